@@ -0,0 +1,632 @@
+/* PsmGen.c
+ *
+ * psmgen: PSM state table compiler and verifier.
+ *
+ * Reads a description of the rotation detection (psm/2LC.psm, psm/3LC.psm),
+ * builds the ESIRAM table of the PSM and proves it on a model of the PSM (the
+ * one of SimESI.c) before it writes the Table[] initializer that ScanIF.c of
+ * the firmware includes (PSM_Table.h).
+ *
+ * The PSM keeps the last sensor reading as its state. With 2 sensors Q0 holds
+ * S1 and is fed back on V2 (ESIV2SEL), Q3 holds S2 and Q4 is set once the PSM
+ * has seen a reading: the first TSM sequence after the reset to state 0 takes
+ * the reading without counting, 32 entries. With 3 sensors V2 is the third
+ * sensor and Q3..Q5 hold S1..S3: 64 entries. A change to the
+ * next reading of the sequence is a forward step, to the previous one a reverse
+ * step; any other change between readings of the sequence is a jump, at least
+ * two sensors changed within one TSM sequence. Every TSM sequence in or out of a
+ * reading that is not part of the sequence is invalid. Neighbouring readings
+ * differ in one sensor, so a step is never seen through a reading in between.
+ *
+ * Description, one keyword per line, '#' starts a comment:
+ *     sensors  2 | 3
+ *     sequence readings in forward order, S2S1 or S3S2S1 (e.g. 00 01 11 10)
+ *     up       forward | reverse       steps that count ESICNT1 up and ESICNT0
+ *     q6       forward | reverse | both | none     steps that set ESIIFG5
+ *     error    q7 | cnt2 | none        jumps; q7: ESIIFG6, cnt2: Q1+Q2 (ESICNT2
+ *                                      down, ESICNT0 up)
+ *     invalid  q7 | cnt2 | none        readings outside the sequence
+ *
+ * The proof checks every entry a reading can reach against the description,
+ * and counts every walk of WALK_STEPS steps (stay, forward or reverse) from
+ * every reading of the sequence through the table: ESICNT1, ESICNT0, ESICNT2
+ * and the Q6/Q7 flags must come out as the steps say. Every jump and invalid
+ * change is then taken once from every reading, and a walk after it must count
+ * again.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_READINGS    8
+#define MAX_TABLE       64
+#define WALK_STEPS      12                  // 3^12 walks from every reading
+
+#define PSM_Q1          0x02                // ESICNT1 up, ESICNT0 up
+#define PSM_Q2          0x04                // ESICNT1 down; with Q1: ESICNT2 down, ESICNT0 up
+#define PSM_Q4          0x10                // 2 sensors: a reading has been seen
+#define PSM_Q6          0x40                // ESIIFG5
+#define PSM_Q7          0x80                // ESIIFG6
+
+enum { STAY, FORWARD, REVERSE, JUMP, INVALID };
+enum { ON_FORWARD = 1, ON_REVERSE = 2 };
+
+typedef struct
+{
+	int Sensors;
+	int Sequence[MAX_READINGS];
+	int Length;
+	int Up;                                 // ON_FORWARD or ON_REVERSE
+	int Q6;                                 // ON_FORWARD | ON_REVERSE
+	int Error;                              // jumps: PSM_Q7, PSM_Q1 | PSM_Q2 or 0
+	int Invalid;                            // readings outside the sequence
+	char Text[2][64];                       // summary lines for the header
+} Psm_Desc;
+
+typedef struct
+{
+	long Cnt0, Cnt1, Cnt2;
+	long Q6, Q7;
+} Psm_Count;
+
+static Psm_Desc D;
+static unsigned char Table[MAX_TABLE];
+static int Table_Size;
+static const char *Path;
+static int Errors;
+
+static void Fail(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	fprintf(stderr, "%s: ", Path);
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	Errors++;
+}
+
+static const char *Reading_Text(int r)
+{
+	static char text[4][4];
+	static int next;
+	char *t = text[next++ & 3];
+	int i;
+
+	for (i = 0; i < D.Sensors; i++)
+		t[i] = '0' + ((r >> (D.Sensors - 1 - i)) & 1);
+	t[i] = 0;
+	return t;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Description
+//---
+
+static int Parse_Reading(const char *word)
+{
+	int r = 0, i;
+
+	if ((int)strlen(word) != D.Sensors)
+		return -1;
+	for (i = 0; i < D.Sensors; i++)
+	{	if ((word[i] != '0') && (word[i] != '1'))
+			return -1;
+		r = (r << 1) | (word[i] - '0');
+	}
+	return r;
+}
+
+static int Parse_Side(const char *word, int none_ok)
+{
+	if (strcmp(word, "forward") == 0) return ON_FORWARD;
+	if (strcmp(word, "reverse") == 0) return ON_REVERSE;
+	if (none_ok && (strcmp(word, "both") == 0)) return ON_FORWARD | ON_REVERSE;
+	if (none_ok && (strcmp(word, "none") == 0)) return 0;
+	return -1;
+}
+
+static int Parse_Action(const char *word)
+{
+	if (strcmp(word, "q7") == 0) return PSM_Q7;
+	if (strcmp(word, "cnt2") == 0) return PSM_Q1 | PSM_Q2;
+	if (strcmp(word, "none") == 0) return 0;
+	return -1;
+}
+
+static const char *Action_Text(int action)
+{
+	return (action == PSM_Q7) ? "q7" : action ? "cnt2" : "none";
+}
+
+static const char *Action_Name(int action)
+{
+	return (action == PSM_Q7) ? "flagged on Q7" : action ? "counted on ESICNT2" : "not counted";
+}
+
+static int Read_Desc(FILE *f)
+{
+	char line[160], *word, *rest;
+	int line_no = 0, seen = 0, i, j;
+
+	D.Up = ON_FORWARD;
+	D.Q6 = ON_FORWARD;
+	D.Error = PSM_Q7;
+	D.Invalid = PSM_Q7;
+	while (fgets(line, sizeof(line), f))
+	{
+		line_no++;
+		if (strchr(line, '#'))
+			*strchr(line, '#') = 0;
+		if (!(word = strtok(line, " \t\r\n")))
+			continue;
+		rest = strtok(NULL, " \t\r\n");
+		if (!rest)
+		{	Fail("line %d: no value", line_no);
+			continue;
+		}
+		if (strcmp(word, "sensors") == 0)
+		{	D.Sensors = atoi(rest);
+			if ((D.Sensors != 2) && (D.Sensors != 3))
+				Fail("line %d: 2 or 3 sensors", line_no);
+			seen |= 1;
+		}
+		else if (strcmp(word, "sequence") == 0)
+		{	if (!D.Sensors)
+			{	Fail("line %d: sequence before sensors", line_no);
+				continue;
+			}
+			for (D.Length = 0; rest; rest = strtok(NULL, " \t\r\n"))
+			{	int r = Parse_Reading(rest);
+
+				if (r < 0)
+					Fail("sequence: %s is not a reading of %d sensors", rest, D.Sensors);
+				else if (D.Length == MAX_READINGS)
+					Fail("sequence: more than %d readings", MAX_READINGS);
+				else
+					D.Sequence[D.Length++] = r;
+			}
+			seen |= 2;
+		}
+		else if (strcmp(word, "up") == 0)
+		{	if ((D.Up = Parse_Side(rest, 0)) < 0)
+				Fail("up: %s is not forward or reverse", rest);
+		}
+		else if (strcmp(word, "q6") == 0)
+		{	if ((D.Q6 = Parse_Side(rest, 1)) < 0)
+				Fail("q6: %s is not forward, reverse, both or none", rest);
+		}
+		else if ((strcmp(word, "error") == 0) || (strcmp(word, "invalid") == 0))
+		{	if ((*((word[0] == 'e') ? &D.Error : &D.Invalid) = Parse_Action(rest)) < 0)
+				Fail("%s: %s is not q7, cnt2 or none", word, rest);
+		}
+		else
+			Fail("line %d: unknown keyword %s", line_no, word);
+	}
+	if ((seen & 3) != 3)
+		Fail("sensors and sequence are needed");
+	if (D.Length && (D.Length < 3))
+		Fail("sequence: %d readings, at least 3 tell the direction", D.Length);
+	for (i = 0; i < D.Length; i++)
+		for (j = i + 1; j < D.Length; j++)
+			if (D.Sequence[i] == D.Sequence[j])
+				Fail("sequence: reading %s twice", Reading_Text(D.Sequence[i]));
+	for (i = 0; i < D.Length; i++)                  // the sensors change one at a time
+	{	int a = D.Sequence[i], b = D.Sequence[(i + 1) % D.Length];
+
+		if ((a ^ b) & ((a ^ b) - 1))
+			Fail("sequence: %s -> %s changes more than one sensor", Reading_Text(a), Reading_Text(b));
+	}
+	return Errors == 0;
+}
+
+// Position of a reading in the sequence, -1 if it is not part of it.
+static int Position(int r)
+{
+	int i;
+
+	for (i = 0; i < D.Length; i++)
+		if (D.Sequence[i] == r)
+			return i;
+	return -1;
+}
+
+static int Step_Kind(int from, int to)
+{
+	int p = Position(from), q = Position(to);
+
+	if ((p < 0) || (q < 0))
+		return INVALID;
+	if (p == q)
+		return STAY;
+	if (q == (p + 1) % D.Length)
+		return FORWARD;
+	if (p == (q + 1) % D.Length)
+		return REVERSE;
+	return JUMP;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Table
+//---
+
+// Address of the table entry for the last reading and the present one
+// (S1 | S2 << 1 | V2 << 2 | Q3..Q5 << 3 of the last state).
+static int Address(int last, int r)
+{
+	if (D.Sensors == 2)
+		return r | ((last & 1) << 2) | ((last >> 1) << 3) | PSM_Q4;
+	return r | (last << 3);
+}
+
+// State bits that keep reading r: Q0, Q3 and Q4 with 2 sensors, Q3..Q5 with 3.
+static int State_Bits(int r)
+{
+	if (D.Sensors == 2)
+		return (r & 1) | ((r >> 1) << 3) | PSM_Q4;
+	return r << 3;
+}
+
+// Reading kept by a PSM state.
+static int State_Reading(int q)
+{
+	if (D.Sensors == 2)
+		return (q & 1) | (((q >> 3) & 1) << 1);
+	return (q >> 3) & 7;
+}
+
+static int Expected(int last, int r)
+{
+	int kind = Step_Kind(last, r), q = State_Bits(r);
+
+	if (kind == JUMP)
+		return q | D.Error;
+	if (kind == INVALID)
+		return q | D.Invalid;
+	if (kind == FORWARD)
+		return q | ((D.Up == ON_FORWARD) ? PSM_Q1 : PSM_Q2) | ((D.Q6 & ON_FORWARD) ? PSM_Q6 : 0);
+	if (kind == REVERSE)
+		return q | ((D.Up == ON_REVERSE) ? PSM_Q1 : PSM_Q2) | ((D.Q6 & ON_REVERSE) ? PSM_Q6 : 0);
+	return q;
+}
+
+static void Build(void)
+{
+	int last, r, readings = 1 << D.Sensors;
+
+	Table_Size = (D.Sensors == 2) ? 32 : 64;
+	memset(Table, 0, sizeof(Table));
+	if (D.Sensors == 2)                             // not started: take the reading
+		for (r = 0; r < 16; r++)
+			Table[r] = State_Bits(r & 3);
+	for (last = 0; last < readings; last++)
+		for (r = 0; r < readings; r++)
+			Table[Address(last, r)] = Expected(last, r);
+}
+
+
+//--------------------------------------------------------------------------
+//---  Proof
+//---
+
+// One TSM sequence with the sensor reading r, as End_Sequence() of SimESI.c.
+static int Psm_Step(int q, int r, Psm_Count *c)
+{
+	int s3 = (D.Sensors == 2) ? (q & 1) : (r >> 2) & 1;
+	int a = (r & 3) | (s3 << 2) | (((q >> 3) & 7) << 3);
+
+	if (a >= Table_Size)
+	{	Fail("state 0x%02X outside the table", q);
+		return 0;
+	}
+	q = Table[a];
+	if ((q & (PSM_Q1 | PSM_Q2)) == (PSM_Q1 | PSM_Q2))
+	{	c->Cnt2--;
+		c->Cnt0++;
+	}
+	else if (q & PSM_Q1)
+	{	c->Cnt1++;
+		c->Cnt0++;
+	}
+	else if (q & PSM_Q2)
+		c->Cnt1--;
+	c->Q6 += (q & PSM_Q6) != 0;
+	c->Q7 += (q & PSM_Q7) != 0;
+	return q;
+}
+
+static void Count_Action(Psm_Count *c, int action, long n)
+{
+	if (action == PSM_Q7)
+		c->Q7 += n;
+	else if (action == (PSM_Q1 | PSM_Q2))
+	{	c->Cnt2 -= n;
+		c->Cnt0 += n;
+	}
+}
+
+// Counters expected after 'forward' and 'reverse' steps, 'jumps' and 'invalid' ones.
+static void Count_Of(Psm_Count *c, long forward, long reverse, long jumps, long invalid)
+{
+	long up = (D.Up == ON_FORWARD) ? forward : reverse;
+	long down = (D.Up == ON_FORWARD) ? reverse : forward;
+
+	c->Cnt1 = up - down;
+	c->Cnt0 = up;
+	c->Cnt2 = 0;
+	c->Q6 = ((D.Q6 & ON_FORWARD) ? forward : 0) + ((D.Q6 & ON_REVERSE) ? reverse : 0);
+	c->Q7 = 0;
+	Count_Action(c, D.Error, jumps);
+	Count_Action(c, D.Invalid, invalid);
+}
+
+static int Same(const Psm_Count *a, const Psm_Count *b)
+{
+	return (a->Cnt0 == b->Cnt0) && (a->Cnt1 == b->Cnt1) && (a->Cnt2 == b->Cnt2) &&
+	       (a->Q6 == b->Q6) && (a->Q7 == b->Q7);
+}
+
+// Every entry a state of the PSM can reach, against the description.
+static int Check_Entries(void)
+{
+	int last, r, readings = 1 << D.Sensors, failed = 0;
+
+	for (last = 0; last < readings; last++)
+		for (r = 0; r < readings; r++)
+		{
+			Psm_Count c = { 0 }, e;
+			int kind = Step_Kind(last, r);
+			int q = Psm_Step(State_Bits(last), r, &c);
+
+			Count_Of(&e, kind == FORWARD, kind == REVERSE, kind == JUMP, kind == INVALID);
+			if ((State_Reading(q) != r) || !Same(&c, &e))
+			{	fprintf(stderr, "%s: entry %s -> %s wrong\n", Path, Reading_Text(last), Reading_Text(r));
+				failed++;
+			}
+		}
+	Errors += failed;
+	return failed == 0;
+}
+
+// All walks of 'steps' steps from PSM state q, counted on top of c, as
+// 'forward', 'reverse', 'jumps' and 'invalid' steps so far. Returns the walks.
+static long Walk(int q, int steps, Psm_Count c, long forward, long reverse, long jumps, long invalid)
+{
+	int p = Position(State_Reading(q)), kind;
+	long walks = 0;
+
+	if (!steps)
+	{	Psm_Count e;
+
+		Count_Of(&e, forward, reverse, jumps, invalid);
+		if (!Same(&c, &e))
+		{	if (Errors++ < 10)
+				fprintf(stderr, "%s: walk through %s counts ESICNT1 %ld ESICNT0 %ld ESICNT2 %ld Q6 %ld Q7 %ld,"
+				        " expected %ld %ld %ld %ld %ld\n", Path, Reading_Text(State_Reading(q)),
+				        c.Cnt1, c.Cnt0, c.Cnt2, c.Q6, c.Q7, e.Cnt1, e.Cnt0, e.Cnt2, e.Q6, e.Q7);
+		}
+		return 1;
+	}
+	for (kind = STAY; kind <= REVERSE; kind++)
+	{
+		Psm_Count n = c;
+		int r = D.Sequence[(kind == STAY) ? p : (kind == FORWARD) ? (p + 1) % D.Length :
+		                   (p + D.Length - 1) % D.Length];
+		int next = Psm_Step(q, r, &n);
+
+		walks += Walk(next, steps - 1, n, forward + (kind == FORWARD), reverse + (kind == REVERSE), jumps, invalid);
+	}
+	return walks;
+}
+
+static int Prove(void)
+{
+	int readings = 1 << D.Sensors, last, r, i;
+	long walks = 0, jumps = 0, invalid = 0;
+
+	if (!Check_Entries())
+		return 0;
+	printf("%s: %d entries, %d sensor states per rotation\n", Path, Table_Size, D.Length);
+
+	for (i = 0; i < D.Length; i++)
+	{	Psm_Count c = { 0 };
+
+		walks += Walk(State_Bits(D.Sequence[i]), WALK_STEPS, c, 0, 0, 0, 0);
+	}
+	if (Errors)
+		return 0;
+	printf("  legal walks    %ld of %d steps from every reading: counts correct\n", walks, WALK_STEPS);
+
+	// Jumps and invalid changes, then a walk from the reading that follows them.
+	for (last = 0; last < readings; last++)
+		for (r = 0; r < readings; r++)
+		{
+			Psm_Count c = { 0 };
+			int kind = Step_Kind(last, r), q;
+
+			if (kind == JUMP)
+			{	q = Psm_Step(State_Bits(last), r, &c);
+				jumps++;
+				Walk(q, 4, c, 0, 0, 1, 0);
+			}
+			else if ((kind == INVALID) && (Position(r) < 0))
+			{	// every further sequence in an invalid reading, and the one out of it, is invalid as well
+				q = Psm_Step(State_Bits(last), r, &c);
+				q = Psm_Step(q, r, &c);
+				q = Psm_Step(q, D.Sequence[0], &c);
+				invalid++;
+				Walk(q, 4, c, 0, 0, 0, 3);
+			}
+			else if (kind == INVALID)
+			{	q = Psm_Step(State_Bits(last), r, &c);
+				invalid++;
+				Walk(q, 4, c, 0, 0, 0, 1);
+			}
+		}
+	if (Errors)
+		return 0;
+	printf("  jumps          %ld between readings: %s, counting resumes\n", jumps, Action_Name(D.Error));
+	if (invalid)
+		printf("  invalid        %ld changes into or out of readings outside the sequence: %s\n",
+		       invalid, Action_Name(D.Invalid));
+	if (D.Sensors == 2)
+	{	for (r = 0; r < readings; r++)
+		{
+			Psm_Count c = { 0 }, e;
+			int q = Psm_Step(0, r, &c);
+
+			Count_Of(&e, 0, 0, 0, 0);
+			if ((State_Reading(q) != r) || !Same(&c, &e))
+				Fail("reset state: the first reading %s counts", Reading_Text(r));
+			Walk(q, 4, c, 0, 0, 0, 0);
+		}
+		if (Errors)
+			return 0;
+		printf("  reset state    the first TSM sequence takes the reading without counting\n");
+	}
+	else
+		printf("  reset state    reading %s, %s\n", Reading_Text(0),
+		       (Position(0) < 0) ? "not in the sequence, the first TSM sequence is invalid" :
+		       "in the sequence, the first TSM sequence may count");
+	return 1;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Output
+//---
+
+static const char *Step_Text(int last, int r)
+{
+	static const char *kind_text[] = { "", "", "", " jump", " invalid" };
+	static char text[40];
+	int q = Table[Address(last, r)], kind = Step_Kind(last, r);
+	int both = (q & (PSM_Q1 | PSM_Q2)) == (PSM_Q1 | PSM_Q2);
+
+	snprintf(text, sizeof(text), "%s%s%s%s%s", kind_text[kind],
+	         both ? "" : (q & PSM_Q1) ? " up" : (q & PSM_Q2) ? " down" : "",
+	         (q & PSM_Q6) ? " Q6" : "", both ? " ESICNT2" : "", (q & PSM_Q7) ? " Q7" : "");
+	return text;
+}
+
+// Table[] in the layout of the firmware sources, CR LF line ends like them.
+static void Write_Table(FILE *f)
+{
+	int a, i;
+
+	fprintf(f, "/*\r\n * PSM_Table.h\r\n *\r\n");
+	fprintf(f, " * PSM state table, generated by psmgen from ESI_HOST_SIM/%s. Do not edit,\r\n", Path);
+	fprintf(f, " * change the description and run make psm in ESI_HOST_SIM.\r\n *\r\n");
+	for (i = 0; i < 2; i++)
+		fprintf(f, " *   %s\r\n", D.Text[i]);
+	fprintf(f, " */\r\n\r\n const unsigned char Table[] = {\r\n");
+	for (a = 0; a < Table_Size; a++)
+	{
+		int s3 = (D.Sensors == 2) ? -1 : (a >> 2) & 1;
+		int last = (D.Sensors == 2) ? (((a >> 2) & 1) | (((a >> 3) & 1) << 1)) : a >> 3;
+		int r = (D.Sensors == 2) ? (a & 3) : (a & 3) | (s3 << 2);
+
+		if ((D.Sensors == 2) && !(a & PSM_Q4))
+			fprintf(f, "\t\t0x%02X,\t\t// %s -> %s%s\r\n", Table[a], (a < 4) ? "start" : "--", Reading_Text(r),
+			        a < 4 ? "" : ", not reached");
+		else
+			fprintf(f, "\t\t0x%02X%s\t\t// %s -> %s%s\r\n", Table[a], (a < Table_Size - 1) ? "," : " ",
+			        Reading_Text(last), Reading_Text(r), Step_Text(last, r));
+	}
+	fprintf(f, " };\r\n");
+}
+
+static void Describe(void)
+{
+	static const char *side[] = { "none", "forward", "reverse", "both" };
+	int i, n;
+
+	n = snprintf(D.Text[0], sizeof(D.Text[0]), "sensors %d, sequence", D.Sensors);
+	for (i = 0; i < D.Length; i++)
+		n += snprintf(D.Text[0] + n, sizeof(D.Text[0]) - n, " %s", Reading_Text(D.Sequence[i]));
+	snprintf(D.Text[1], sizeof(D.Text[1]), "up %s, q6 %s, error %s, invalid %s", side[D.Up], side[D.Q6],
+	         Action_Text(D.Error), Action_Text(D.Invalid));
+}
+
+static void Usage(void)
+{
+	fprintf(stderr,
+		"usage: psmgen [options] DESCRIPTION\n"
+		"  -o FILE    write the proven table to FILE (PSM_Table.h of the firmware)\n"
+		"  -c FILE    check that FILE holds the table of DESCRIPTION\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out = NULL, *check = NULL;
+	FILE *f;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:c:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'o': out = optarg; break;
+		case 'c': check = optarg; break;
+		default:  Usage();
+		}
+	}
+	if (optind != argc - 1)
+		Usage();
+	Path = argv[optind];
+	if (!(f = fopen(Path, "r")))
+	{	perror(Path);
+		return 1;
+	}
+	if (!Read_Desc(f))
+		return 1;
+	fclose(f);
+
+	Build();
+	Describe();
+	if (!Prove())
+	{	fprintf(stderr, "%s: proof failed, no table written\n", Path);
+		return 1;
+	}
+
+	if (out)
+	{	if (!(f = fopen(out, "wb")))
+		{	perror(out);
+			return 1;
+		}
+		Write_Table(f);
+		fclose(f);
+		printf("  written to     %s\n", out);
+	}
+	if (check)
+	{
+		char *want = NULL, *have;
+		size_t want_len = 0, have_len;
+		FILE *m = open_memstream(&want, &want_len);
+
+		Write_Table(m);
+		fclose(m);
+		if (!(f = fopen(check, "rb")))
+		{	perror(check);
+			return 1;
+		}
+		have = malloc(want_len + 2);
+		have_len = fread(have, 1, want_len + 1, f);
+		fclose(f);
+		if ((have_len != want_len) || memcmp(have, want, want_len))
+		{	fprintf(stderr, "%s: not the table of %s, run make psm\n", check, Path);
+			return 1;
+		}
+		printf("  up to date     %s\n", check);
+		free(have);
+		free(want);
+	}
+	return 0;
+}
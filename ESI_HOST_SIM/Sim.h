@@ -0,0 +1,257 @@
+/* Sim.h
+ *
+ * ESI host simulator for the MSP430FR6989 rotation flow meter firmware.
+ *
+ * The firmware sources (main.c, ScanIF.c, ESI_ESIOSC.c, IIC.c, LCD.c) are built
+ * unmodified for the host against include/msp430fr6989.h. Every peripheral
+ * register is a byte of Sim_Periph[]; the simulator models the modules the
+ * firmware depends on (ESI, Timer_A, eUSCI_B0 I2C master, DMA, LCD_C memory, P1 key,
+ * ADC12_B temperature sensor) and advances simulated time whenever the firmware
+ * waits in an LPM or in __delay_cycles().
+ *
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdio.h>
+
+//---- Clocks of the board after Set_Clock()
+#define SIM_ACLK_HZ         32768.0             // LFXT crystal
+#define SIM_MCLK_HZ         4000000.0           // MCLK = SMCLK = DCO = 4 MHz
+#define SIM_ACLK_PERIOD     (1.0 / SIM_ACLK_HZ)
+
+#define SIM_INFINITY        1e300
+
+//---- CPU cycle cost of an interrupt (MSP430X CPU, FR family)
+#define SIM_ISR_ACCEPT_CYCLES   6               // interrupt acceptance
+#define SIM_ISR_RETI_CYCLES     5               // RETI
+
+//---- Peripheral file 0x0000 - 0x0FFF, register symbols are placed by SimSFR.c
+extern volatile unsigned char Sim_Periph[0x1000];
+
+#define SIM_REG8(addr)      (Sim_Periph[(addr)])
+#define SIM_REG16(addr)     (*(volatile unsigned short *)&Sim_Periph[(addr)])
+
+
+//--------------------------------------------------------------------------
+//---  Simulator core (SimCore.c)
+//---
+
+typedef struct
+{
+	double             Time;                // simulated time [s]
+	unsigned long long Tsm_Sequences;       // completed TSM sequences
+	unsigned long long Interrupts;          // serviced interrupts
+	unsigned long long Wakeups;             // interrupts serviced out of an LPM
+	unsigned long long Blocks;              // firmware basic blocks executed
+	unsigned long long Isr_Cycles;          // interrupt accept + RETI cycles
+	unsigned long long Delay_Cycles;        // cycles spent in __delay_cycles()
+	unsigned long long Stall_Cycles;        // cycles spent polling a peripheral (ESICNT3)
+	unsigned long long Dma_Cycles;          // MCLK cycles of DMA transfers
+	unsigned long long Lpm_Exits;           // interrupts that ended an LPM wait
+	double             Wake_Cycles;         // CPU cycles from such an interrupt to the next LPM entry
+	double             Lpm0_Time;           // CPU off with the DCO on: LPM0 [s]
+	double             Request_Time;        // LPM3 with SMCLK requested by eUSCI_B0 for a transfer [s]
+} Sim_Counters;
+
+typedef struct                              // a peripheral model
+{
+	const char *Name;
+	void   (*Reset)(void);
+	void   (*Sync)(void);                   // apply side effects of register writes
+	double (*Next_Event)(void);             // time of the next event, SIM_INFINITY if none
+	void   (*Process)(void);                // handle all events up to Sim_Time
+} Sim_Module;
+
+typedef struct                              // inclusive statistics of a firmware function
+{
+	const void  *Fn;
+	char         Name[40];
+	unsigned long Calls;
+	Sim_Counters Total;
+} Sim_Phase;
+
+extern double        Sim_Time;              // simulated time [s]
+extern double        Sim_Time_Limit;        // simulation stops at this time
+extern double        Sim_Cycles_Per_Block;  // MSP430 cycles per firmware basic block
+extern unsigned int  Sim_SR;                // GIE and LPM bits of the CPU status register
+extern Sim_Counters  Sim_Count;
+extern jmp_buf       Sim_Stop_Jmp;
+extern const char   *Sim_Stop_Reason;
+extern const void   *Sim_Stop_After;        // stop when this firmware function returns
+
+void   Sim_Reset(unsigned long long seed);
+void   Sim_Add_Module(const Sim_Module *module);
+void   Sim_Sync(void);
+void   Sim_Stall(double seconds);
+void   Sim_Stop(const char *reason);
+void   Sim_Snapshot(Sim_Counters *c);
+void   Sim_Counters_Sub(Sim_Counters *d, const Sim_Counters *a, const Sim_Counters *b);
+double Sim_Cpu_Cycles(const Sim_Counters *c);
+double Sim_Charge(const Sim_Counters *c);   // estimated supply charge [C], Sim_Part current model
+unsigned long long Sim_Aclk_Ticks(const Sim_Counters *c);
+
+int        Sim_Phase_Count(void);
+Sim_Phase *Sim_Phase_Get(int index);
+Sim_Phase *Sim_Phase_Find(const char *name);
+void       Sim_Phase_Close_All(void);
+const void *Sim_Function(const char *name);
+void       *Sim_Variable(const char *name, size_t *size);    // firmware global and its size
+
+double Sim_Rand(void);                      // uniform [0,1)
+double Sim_Gauss(void);                     // normal, mean 0, sigma 1
+
+
+//--------------------------------------------------------------------------
+//---  Peripheral models
+//---
+
+extern const Sim_Module Sim_ESI_Module;     // SimESI.c
+extern const Sim_Module Sim_Timer_Module;   // SimTimer.c
+extern const Sim_Module Sim_IIC_Module;     // SimIIC.c
+extern const Sim_Module Sim_Port_Module;    // SimCore.c, P1 key
+extern const Sim_Module Sim_LCD_Module;     // SimLCD.c
+extern const Sim_Module Sim_DMA_Module;     // SimDMA.c
+extern const Sim_Module Sim_ADC_Module;     // SimADC.c
+
+int  Sim_ESI_Pending(int arg);
+void Sim_ESI_Accept(int arg);
+void Sim_ESI_Poll(void);                    // called for every firmware basic block
+double Sim_Esiosc_Hz(void);
+
+typedef struct                              // comparator latch window of a TSM sequence
+{
+	int    Channel;
+	double Start, End;                      // relative to the release of the LC excitation [s]
+} Sim_TSM_Sample;
+
+double Sim_TSM_Clock_Hz(void);              // high frequency TSM clock (ESIOSC or SMCLK, ESIDIV1)
+int    Sim_TSM_Schedule(double t0, Sim_TSM_Sample *sample, int max, double *t_end);
+
+#define SIM_TIMER_A0(n)     ((n) * 2)       // CCR0 vector of TAn
+#define SIM_TIMER_A1(n)     ((n) * 2 + 1)   // CCR1..x / TAIFG vector of TAn
+int  Sim_Timer_Pending(int arg);
+void Sim_Timer_Accept(int arg);
+
+int  Sim_IIC_Pending(int arg);
+void Sim_IIC_Accept(int arg);
+int  Sim_IIC_Clock_Request(void);            // a transfer keeps SMCLK on in LPM3
+void Sim_IIC_Stats(unsigned long *transactions, unsigned long *interrupts);   // STARTs, eUSCI_B0 interrupts
+
+#define SIM_DMA_UCB0RXIFG0  18                  // DMA trigger numbers (DMAxTSEL)
+#define SIM_DMA_UCB0TXIFG0  19
+int  Sim_DMA_Trigger(int trigger);          // the flag is set, 1: a DMA channel has served it
+
+void Sim_ADC_Poll(void);                    // SimADC.c, called for every firmware basic block
+int  Sim_ADC_Pending(int arg);
+void Sim_ADC_Accept(int arg);
+
+int  Sim_Port_Pending(int arg);
+void Sim_Port_Accept(int arg);
+void Sim_Port_Press(double time);           // P1.2 key press at the given time
+
+typedef struct                              // a device on the I2C bus
+{
+	int           (*Start)(unsigned char address, int read);   // 1: address acknowledged
+	int           (*Write)(unsigned char data);                // 1: data acknowledged
+	unsigned char (*Read)(void);
+	void          (*Stop)(void);
+} Sim_IIC_Slave;
+
+extern const Sim_IIC_Slave *Sim_IIC_Bus;    // NULL: nobody acknowledges
+
+extern double Sim_Motor_Rps;                // SimMotor.c, rotor speed at motor speed 15 [rev/s]
+extern const Sim_IIC_Slave Sim_Motor_Board; // the 2-LC demo motor board, address 0x02
+void          Sim_Motor_Reset(void);
+unsigned long Sim_Motor_Count(void);        // its rotation counter
+unsigned long Sim_Motor_Commands(unsigned char command);   // times it received the command
+
+
+//--------------------------------------------------------------------------
+//---  Device part parameters (SimESI.c)
+//---
+
+typedef struct
+{
+	double Esiosc_Hz;                       // ESIOSC frequency at ESICLKFQ = 0x20
+	double Esiosc_Step;                     // relative frequency change per ESICLKFQ step
+	double Esiosc_Tempco;                   // relative frequency change per degC from 25 degC
+	double Comparator_Noise;                // rms comparator noise [DAC codes]
+	double Afe2_Offset;                     // AFE2 offset relative to AFE1 [DAC codes]
+	double Adc_Temp_30C;                    // ADC12 code of the temperature sensor at 30 degC, 1.2 V reference
+	double Adc_Temp_Slope;                  // ADC12 codes per degC of the temperature sensor
+	double I_Active;                        // supply current in active mode at 4 MHz [A]
+	double I_Lpm0;                          // supply current in LPM0, DCO and SMCLK on at 4 MHz [A]
+	double I_Lpm3;                          // supply current in LPM3, ESI idle [A]
+	double Q_Tsm_Sequence;                  // supply charge of one TSM sequence [C]
+} Sim_Part_Config;
+
+extern Sim_Part_Config Sim_Part;
+
+
+//--------------------------------------------------------------------------
+//---  LC sensors and rotor disc (SimSensor.c)
+//---
+
+typedef struct
+{
+	int    Channels;                        // number of LC sensors
+	double Position[4];                     // sensor position on the disc [rev]
+	double Coverage;                        // metal covered part of the disc [rev]
+	double Edge;                            // width of the damping transition at a metal edge [rev]
+	double F_Lc;                            // LC resonance frequency at 25 degC [Hz]
+	double Q_Free;                          // quality factor over the non-metal part at 25 degC
+	double Q_Metal;                         // quality factor over the metal part at 25 degC
+	double Amplitude;                       // LC amplitude at excitation release [DAC codes]
+	double Vmid;                            // mid voltage (ESIVCC2) [DAC codes]
+	double Noise;                           // rms noise of a sample [DAC codes]
+	double Gain[4];                         // amplitude factor of a channel
+	double Q_Scale[4];                      // quality factor of a channel relative to Q_Free / Q_Metal
+	double Wobble;                          // relative change of the metal damping over one revolution
+	double Q_Tempco;                        // relative change of Q per degC
+	double F_Tempco;                        // relative change of F_Lc per degC
+	double Temperature;                     // temperature at time 0 [degC]
+	double Temperature_Rate;                // temperature change [degC/s]
+	double Accel;                           // rotor acceleration to a new speed [rev/s^2], 0: step
+} Sim_Sensor_Config;
+
+extern Sim_Sensor_Config Sim_Sensor;
+
+void   Sim_Sensor_Layout(int channels);
+int    Sim_Param(const char *assignment);   // sensor or part parameter "name=value", 0 if unknown
+void   Sim_Params(FILE *f);                 // lists the parameters and their values
+void   Sim_Sensor_Randomize(double spread);         // part-to-part spread of a virtual meter
+double Sim_Sensor_Temperature(double time);
+double Sim_Sensor_Level(int channel, double time, double t0, double t1);
+void   Sim_Rotor_Reset(void);               // rotor stopped at angle 0
+void   Sim_Rotor_Set_Speed(double rps);     // ramps with Sim_Sensor.Accel
+double Sim_Rotor_Speed(void);
+double Sim_Rotor_Revolutions(void);
+
+
+//--------------------------------------------------------------------------
+//---  Calibration benchmark (SimBench.c)
+//---
+
+void Sim_Bench_Collect(const char *const *phase, int phases,    // statistics of the present run
+                       const Sim_Counters *operation);          // after InitScanIF(), NULL if not reached
+int  Sim_Bench_Write(int fd);               // passes the last collected run to Sim_Bench_Read()
+int  Sim_Bench_Read(int fd, const char *const *phase, int phases);
+int  Sim_Bench_Json(const char *path, const char *firmware, unsigned long long seed);
+int  Sim_Bench_Check(const char *path);     // number of exceeded thresholds, -1 if no file
+
+
+//--------------------------------------------------------------------------
+//---  LCD glass (SimLCD.c)
+//---
+
+#define SIM_LCD_LOWER       0               // lines of Sim_LCD_Number(), as lcd_display_num()
+#define SIM_LCD_UPPER       1
+#define SIM_LCD_BOTH        2
+long Sim_LCD_Number(int line);              // number shown on a line, -1 if blank or unreadable
+int  Sim_LCD_On(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,115 @@
+/* SimADC.c
+ *
+ * ADC12_B model for the internal temperature sensor: a single conversion of
+ * ADC12MEM0 (ADC12INCH_30 with ADC12TCMAP) against the 1.2 V reference of
+ * REF_A. The sensor has the temperature of the LC sensors (Sim_Sensor).
+ *
+ * The firmware starts a conversion with ADC12SC and polls ADC12IFG0. The
+ * result is stored at the first basic block after the start, and the sample
+ * and conversion time is charged as a busy wait of the CPU. With ADC12IE0 set
+ * the conversion runs while the CPU goes on or sleeps: ADC12MEM0 and ADC12IFG0
+ * are set at its end, and accepting the interrupt clears ADC12IFG0 as the read
+ * of ADC12MEM0 in the ISR does. A sequence of channels (ADC12CONSEQ_1 with
+ * ADC12MSC, from ADC12MEM0 to the ADC12EOS of ADC12MCTL0..3) converts one
+ * memory after the other and sets all their flags at the end; accepting the
+ * interrupt clears them all.
+ */
+
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define ADC12OSC_HZ     4.8e6               // MODOSC, ADC12SSEL_0
+#define ADC12_CONVERT   14                  // ADC12CLK cycles of a 12 bit conversion
+#define ADC12_MEMS      4                   // ADC12MCTL0..3 and ADC12MEM0..3 are modelled
+
+static double Done_Time = SIM_INFINITY;    // end of the conversions with ADC12IER0
+static int    Done_Mems = 1;               // memories converted by them
+
+static const unsigned int Sample_Cycles[16] =
+{
+	4, 8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 512, 512, 512, 512, 512,
+};
+
+static unsigned int Convert(unsigned int mctl)
+{
+	double code;
+
+	if (((mctl & 0x1F) != ADC12INCH_30) || !(ADC12CTL3 & ADC12TCMAP))
+		return 0;                           // no other input is connected
+	if (!(REFCTL0 & REFON) || ((mctl & 0x0F00) != ADC12VRSEL_1))
+		return 0x0FFF;                      // reference off: full scale
+
+	code = Sim_Part.Adc_Temp_30C + Sim_Part.Adc_Temp_Slope * (Sim_Sensor_Temperature(Sim_Time) - 30.0)
+	     + Sim_Gauss() + Sim_Rand() - 0.5;
+	if (code < 0)
+		return 0;
+	return (code > 4095) ? 4095 : (unsigned int)code;
+}
+
+// Called for every basic block of the firmware.
+void Sim_ADC_Poll(void)
+{
+	if (!(ADC12CTL0 & ADC12SC))
+		return;
+	ADC12CTL0 &= ~ADC12SC;
+	if (!(ADC12CTL0 & ADC12ON) || !(ADC12CTL0 & ADC12ENC))
+		return;
+
+	if ((ADC12CTL1 & ADC12CONSEQ_3) == ADC12CONSEQ_1)
+	{	if (!(ADC12CTL0 & ADC12MSC) || !ADC12IER0 || (ADC12CTL3 & 0x1F))
+			Sim_Stop("ADC12 sequence without ADC12MSC, interrupt or from ADC12MEM0 is not modelled");
+		for (Done_Mems = 1; Done_Mems < ADC12_MEMS; Done_Mems++)
+			if (SIM_REG16(0x0820 + 2 * (Done_Mems - 1)) & ADC12EOS)
+				break;
+	}
+	else if (ADC12CTL1 & ADC12CONSEQ_3)
+		Sim_Stop("ADC12 repeated conversions are not modelled");
+	else
+		Done_Mems = 1;
+
+	if (ADC12IER0)
+	{	Done_Time = Sim_Time + Done_Mems * (Sample_Cycles[(ADC12CTL0 >> 8) & 15] + ADC12_CONVERT) / ADC12OSC_HZ;
+		return;
+	}
+	ADC12MEM0 = Convert(ADC12MCTL0);
+	ADC12IFGR0 |= ADC12IFG0;
+	Sim_Stall((Sample_Cycles[(ADC12CTL0 >> 8) & 15] + ADC12_CONVERT) / ADC12OSC_HZ);
+}
+
+static void ADC_Reset(void)
+{
+	Done_Time = SIM_INFINITY;
+	Done_Mems = 1;
+}
+
+static double ADC_Next_Event(void)
+{
+	return Done_Time;
+}
+
+static void ADC_Process(void)
+{
+	int n;
+
+	if (Sim_Time >= Done_Time)
+	{	Done_Time = SIM_INFINITY;
+		for (n = 0; n < Done_Mems; n++)
+		{	SIM_REG16(0x0860 + 2 * n) = Convert(SIM_REG16(0x0820 + 2 * n));
+			ADC12IFGR0 |= 1 << n;
+		}
+	}
+}
+
+int Sim_ADC_Pending(int arg)
+{
+	(void)arg;
+	return (ADC12IER0 & ADC12IFGR0) != 0;
+}
+
+void Sim_ADC_Accept(int arg)
+{
+	(void)arg;
+	ADC12IFGR0 &= ~((1 << Done_Mems) - 1);
+}
+
+const Sim_Module Sim_ADC_Module = { "ADC12", ADC_Reset, NULL, ADC_Next_Event, ADC_Process };
@@ -0,0 +1,268 @@
+/* SimBench.c
+ *
+ * Calibration benchmark output of esisim: the statistics of the calibration
+ * phases as JSON, and a check against regression thresholds.
+ *
+ * The statistics of every run are collected with Sim_Bench_Collect(); runs of
+ * child processes (esisim -n) are passed through a pipe. With more than one
+ * run, every counter is the median over the runs, so a single seed that hits a
+ * slow calibration path does not decide the result.
+ *
+ * A threshold file has one limit per line, "phase metric max"; '#' starts a
+ * comment. The phase "total" is the whole run, "operation" the part of it after
+ * InitScanIF() returned (normal operation, not measured with -u InitScanIF). Metrics:
+ *     calls time_ms aclk tsm_sequences wakeups lpm0_ms cpu_cycles charge_uc wake_cycles
+ * (wake_cycles: CPU cycles per interrupt that ended an LPM wait, up to the next LPM entry)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Sim.h"
+
+#define MAX_BENCH_PHASES    16              // including "total" and "operation"
+#define MAX_BENCH_RUNS      1024
+
+typedef struct
+{
+	int           Valid;                    // the phase did run
+	unsigned long Calls;
+	Sim_Counters  Total;
+} Bench_Stat;
+
+static const char *const *Bench_Name;       // phase names, "total" and "operation" follow
+static int Bench_Phases;
+static Bench_Stat (*Run)[MAX_BENCH_PHASES];
+static int Run_Num;
+
+static const char *Metric_Name[] =
+{
+	"calls", "time_ms", "aclk", "tsm_sequences", "wakeups", "lpm0_ms", "cpu_cycles", "charge_uc",
+	"wake_cycles",
+};
+
+#define METRICS     (int)(sizeof(Metric_Name) / sizeof(Metric_Name[0]))
+
+static double Metric(const Sim_Counters *c, unsigned long calls, int m)
+{
+	switch (m)
+	{
+	case 0:  return calls;
+	case 1:  return c->Time * 1e3;
+	case 2:  return (double)Sim_Aclk_Ticks(c);
+	case 3:  return (double)c->Tsm_Sequences;
+	case 4:  return (double)c->Wakeups;
+	case 5:  return c->Lpm0_Time * 1e3;
+	case 6:  return Sim_Cpu_Cycles(c);
+	case 7:  return Sim_Charge(c) * 1e6;
+	default: return c->Lpm_Exits ? c->Wake_Cycles / c->Lpm_Exits : 0.0;
+	}
+}
+
+//--------------------------------------------------------------------------
+//---  Runs
+//---
+
+static void Set_Phases(const char *const *phase, int phases)
+{
+	if (!Run)
+		Run = calloc(MAX_BENCH_RUNS, sizeof(*Run));
+	Bench_Name = phase;
+	Bench_Phases = (phases > MAX_BENCH_PHASES - 2) ? MAX_BENCH_PHASES - 2 : phases;
+}
+
+void Sim_Bench_Collect(const char *const *phase, int phases, const Sim_Counters *operation)
+{
+	Bench_Stat *r;
+	int i;
+
+	Set_Phases(phase, phases);
+	if (Run_Num == MAX_BENCH_RUNS)
+		return;
+
+	r = Run[Run_Num++];
+	memset(r, 0, MAX_BENCH_PHASES * sizeof(*r));
+	for (i = 0; i < Bench_Phases; i++)
+	{
+		const Sim_Phase *p = Sim_Phase_Find(phase[i]);
+
+		if (p)
+		{	r[i].Valid = 1;
+			r[i].Calls = p->Calls;
+			r[i].Total = p->Total;
+		}
+	}
+	r[Bench_Phases].Valid = 1;
+	r[Bench_Phases].Calls = 1;
+	Sim_Snapshot(&r[Bench_Phases].Total);
+	if (operation)
+	{	r[Bench_Phases + 1].Valid = 1;
+		r[Bench_Phases + 1].Calls = 1;
+		r[Bench_Phases + 1].Total = *operation;
+	}
+}
+
+int Sim_Bench_Write(int fd)
+{
+	return Run_Num && (write(fd, Run[Run_Num - 1], sizeof(*Run)) == sizeof(*Run));
+}
+
+int Sim_Bench_Read(int fd, const char *const *phase, int phases)
+{
+	Set_Phases(phase, phases);
+	if ((Run_Num == MAX_BENCH_RUNS) || (read(fd, Run[Run_Num], sizeof(*Run)) != sizeof(*Run)))
+		return 0;
+	Run_Num++;
+	return 1;
+}
+
+static int By_Value(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+#define MEDIAN(field)                                                           \
+	do {                                                                        \
+		for (n = 0, r = 0; r < Run_Num; r++)                                    \
+			if (Run[r][i].Valid)                                                \
+				v[n++] = (double)Run[r][i].field;                               \
+		qsort(v, n, sizeof(*v), By_Value);                                      \
+		m.field = v[n / 2];                                                     \
+	} while (0)
+
+// Median over the runs of a phase, of the whole run ("total") or of the normal
+// operation ("operation"), 0 if the phase did not run.
+static int Lookup(const char *name, Sim_Counters *c, unsigned long *calls)
+{
+	static double v[MAX_BENCH_RUNS];
+	Bench_Stat m;
+	int i, r, n;
+
+	for (i = 0; i < Bench_Phases; i++)
+		if (strcmp(name, Bench_Name[i]) == 0)
+			break;
+	if ((i == Bench_Phases) && (strcmp(name, "total") != 0))
+	{	if (strcmp(name, "operation") != 0)
+			return 0;
+		i = Bench_Phases + 1;
+	}
+
+	for (n = 0, r = 0; r < Run_Num; r++)
+		n += Run[r][i].Valid;
+	if (n == 0)
+		return 0;
+
+	memset(&m, 0, sizeof(m));
+	MEDIAN(Calls);
+	MEDIAN(Total.Time);
+	MEDIAN(Total.Tsm_Sequences);
+	MEDIAN(Total.Interrupts);
+	MEDIAN(Total.Wakeups);
+	MEDIAN(Total.Blocks);
+	MEDIAN(Total.Isr_Cycles);
+	MEDIAN(Total.Delay_Cycles);
+	MEDIAN(Total.Stall_Cycles);
+	MEDIAN(Total.Dma_Cycles);
+	MEDIAN(Total.Lpm_Exits);
+	MEDIAN(Total.Wake_Cycles);
+	MEDIAN(Total.Lpm0_Time);
+	MEDIAN(Total.Request_Time);
+	*c = m.Total;
+	*calls = m.Calls;
+	return 1;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Output
+//---
+
+static void Json_Object(FILE *f, const Sim_Counters *c, unsigned long calls)
+{
+	int m;
+
+	fprintf(f, "{");
+	for (m = 0; m < METRICS; m++)
+		fprintf(f, "%s\"%s\": %.10g", m ? ", " : " ", Metric_Name[m], Metric(c, calls, m));
+	fprintf(f, " }");
+}
+
+int Sim_Bench_Json(const char *path, const char *firmware, unsigned long long seed)
+{
+	FILE *f = fopen(path, "w");
+	Sim_Counters c;
+	unsigned long calls;
+	int i, first = 1;
+
+	if (!f)
+	{	perror(path);
+		return 0;
+	}
+	fprintf(f, "{\n  \"firmware\": \"%s\",\n  \"seed\": %llu,\n  \"runs\": %d,\n",
+	        firmware, seed, Run_Num);
+	fprintf(f, "  \"cycles_per_block\": %g,\n  \"phases\": {\n", Sim_Cycles_Per_Block);
+	for (i = 0; i < Bench_Phases; i++)
+		if (Lookup(Bench_Name[i], &c, &calls))
+		{	fprintf(f, "%s    \"%s\": ", first ? "" : ",\n", Bench_Name[i]);
+			Json_Object(f, &c, calls);
+			first = 0;
+		}
+	Lookup("total", &c, &calls);
+	fprintf(f, "\n  },\n  \"total\": ");
+	Json_Object(f, &c, calls);
+	if (Lookup("operation", &c, &calls))
+	{	fprintf(f, ",\n  \"operation\": ");
+		Json_Object(f, &c, calls);
+	}
+	fprintf(f, "\n}\n");
+	fclose(f);
+	return 1;
+}
+
+int Sim_Bench_Check(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[160], name[48], metric[24];
+	double max;
+	int failed = 0, line_no = 0;
+
+	if (!f)
+	{	perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f))
+	{
+		Sim_Counters c;
+		unsigned long calls;
+		double v;
+		int m;
+
+		line_no++;
+		if (strchr(line, '#'))
+			*strchr(line, '#') = 0;
+		if (sscanf(line, "%47s %23s %lf", name, metric, &max) != 3)
+			continue;
+		for (m = 0; m < METRICS; m++)
+			if (strcmp(metric, Metric_Name[m]) == 0)
+				break;
+		if (m == METRICS)
+		{	fprintf(stderr, "%s:%d: unknown metric %s\n", path, line_no, metric);
+			failed++;
+			continue;
+		}
+		if (!Lookup(name, &c, &calls))
+		{	printf("FAIL  %-20s %-14s did not run\n", name, metric);
+			failed++;
+			continue;
+		}
+		v = Metric(&c, calls, m);
+		printf("%s  %-20s %-14s %12.3f  max %12.3f\n", (v > max) ? "FAIL" : "ok  ", name, metric, v, max);
+		if (v > max)
+			failed++;
+	}
+	fclose(f);
+	return failed;
+}
@@ -0,0 +1,676 @@
+/* SimCore.c
+ *
+ * Simulator core: simulated time, CPU status register, LPM and interrupt
+ * dispatch, and the instrumentation hooks of the firmware build.
+ *
+ * Time only advances at the points where the firmware gives control to the
+ * hardware: entering an LPM, __delay_cycles(), polling ESICNT3, and the entry
+ * and exit of every firmware function (-finstrument-functions), where the CPU
+ * cycles executed since the last such point are accounted. The CPU cycles are
+ * estimated from the number of firmware basic blocks (-fsanitize-coverage=
+ * trace-pc) times Sim_Cycles_Per_Block, plus interrupt overhead and delays.
+ *
+ * Interrupts are dispatched while the CPU sleeps in an LPM, during
+ * __delay_cycles() and when GIE is set, in the priority order of the device.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define MAX_MODULES     16
+#define MAX_LEVEL       8                   // nesting of LPM waits (LPM0 inside an ISR)
+#define MAX_PHASES      256
+#define MAX_CALL_DEPTH  64
+
+double        Sim_Time;
+double        Sim_Time_Limit = 60.0;
+double        Sim_Cycles_Per_Block = 10.0;
+unsigned int  Sim_SR;
+Sim_Counters  Sim_Count;
+jmp_buf       Sim_Stop_Jmp;
+const char   *Sim_Stop_Reason;
+const void   *Sim_Stop_After;
+
+static const Sim_Module *Module[MAX_MODULES];
+static int Module_Num;
+
+static unsigned long long Blocks_Synced;    // basic blocks already converted into time
+static double Stall_Time;                   // pending busy-wait time of the CPU
+static unsigned long long Rand_State;
+
+static unsigned char Lpm_Exit[MAX_LEVEL];
+static int Lpm_Depth;
+static int Waking;                          // an interrupt has ended an LPM wait, no LPM entered since
+static double Wake_Start;                   // Sim_Cpu_Cycles() at that interrupt
+
+typedef struct
+{
+	unsigned int Saved_SR;                  // SR pushed at interrupt acceptance
+	unsigned int Clear_On_Exit;             // bits cleared in the saved SR on RETI
+	unsigned int Set_On_Exit;               // bits set in the saved SR on RETI
+} Isr_Frame;
+
+static Isr_Frame *Frame;                    // frame of the running ISR, NULL in main
+
+static Sim_Phase Phase[MAX_PHASES];
+static int Phase_Num;
+static short Phase_Hash[1024];
+
+static struct
+{
+	int          Phase;
+	Sim_Counters Start;
+} Call[MAX_CALL_DEPTH];
+static int Call_Depth;
+
+
+//--------------------------------------------------------------------------
+//---  Interrupt vectors of the firmware, highest priority first
+//---
+
+extern void ISR_ESCAN_IF(void) __attribute__((weak));
+extern void USCI_B0_ISR(void) __attribute__((weak));
+extern void Timer_A(void) __attribute__((weak));
+extern void Timer1_A(void) __attribute__((weak));
+extern void Timer2_A(void) __attribute__((weak));
+extern void Timer3_A(void) __attribute__((weak));
+extern void PORT1_ISR(void) __attribute__((weak));
+extern void ADC12_ISR(void) __attribute__((weak));
+
+typedef struct
+{
+	const char *Name;
+	int  (*Pending)(int arg);
+	void (*Accept)(int arg);
+	int  Arg;
+	void (*Isr)(void);
+} Sim_Vector;
+
+static const Sim_Vector Vector[] =
+{
+	{ "ESCAN_IF",  Sim_ESI_Pending,   Sim_ESI_Accept,   0,               ISR_ESCAN_IF },
+	{ "USCI_B0",   Sim_IIC_Pending,   Sim_IIC_Accept,   0,               USCI_B0_ISR  },
+	{ "ADC12",     Sim_ADC_Pending,   Sim_ADC_Accept,   0,               ADC12_ISR    },
+	{ "TIMER0_A0", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A0(0), Timer_A      },
+	{ "TIMER0_A1", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A1(0), NULL         },
+	{ "TIMER1_A0", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A0(1), Timer1_A     },
+	{ "TIMER1_A1", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A1(1), NULL         },
+	{ "PORT1",     Sim_Port_Pending,  Sim_Port_Accept,  1,               PORT1_ISR    },
+	{ "TIMER2_A0", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A0(2), NULL         },
+	{ "TIMER2_A1", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A1(2), Timer2_A     },
+	{ "TIMER3_A0", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A0(3), Timer3_A     },
+	{ "TIMER3_A1", Sim_Timer_Pending, Sim_Timer_Accept, SIM_TIMER_A1(3), NULL         },
+};
+
+#define VECTOR_NUM  (int)(sizeof(Vector) / sizeof(Vector[0]))
+
+
+//--------------------------------------------------------------------------
+//---  Time
+//---
+
+void Sim_Add_Module(const Sim_Module *module)
+{
+	if (Module_Num < MAX_MODULES)
+		Module[Module_Num++] = module;
+}
+
+void Sim_Stop(const char *reason)
+{
+	Sim_Stop_Reason = reason;
+	longjmp(Sim_Stop_Jmp, 1);
+}
+
+static int Irq_Pending(void)
+{
+	int i;
+
+	for (i = 0; i < VECTOR_NUM; i++)
+		if (Vector[i].Pending(Vector[i].Arg))
+			return 1;
+	return 0;
+}
+
+static void Service(void);
+
+static void Sync_Modules(void)
+{
+	int i;
+
+	for (i = 0; i < Module_Num; i++)
+		if (Module[i]->Sync)
+			Module[i]->Sync();
+}
+
+// Runs the peripherals up to t_end. With wake set, returns early (1) as soon
+// as an enabled interrupt is pending and GIE is set.
+static int Advance(double t_end, int wake)
+{
+	int i;
+	unsigned long idle = 0;
+
+	for (;;)
+	{
+		double t = t_end;
+
+		for (i = 0; i < Module_Num; i++)
+		{
+			double n = Module[i]->Next_Event ? Module[i]->Next_Event() : SIM_INFINITY;
+			if (n < t)
+				t = n;
+		}
+		if (t >= SIM_INFINITY)
+			Sim_Stop("LPM without wake-up source");
+		if (t > Sim_Time_Limit)
+		{
+			Sim_Time = Sim_Time_Limit;
+			Sim_Stop("time limit");
+		}
+		if (t > Sim_Time)
+		{
+			if ((Sim_SR & CPUOFF) && !(Sim_SR & SCG1))
+				Sim_Count.Lpm0_Time += t - Sim_Time;
+			else if ((Sim_SR & CPUOFF) && Sim_IIC_Clock_Request())
+				Sim_Count.Request_Time += t - Sim_Time;
+			Sim_Time = t;
+			idle = 0;
+		}
+		else if (++idle > 100000)
+			Sim_Stop("peripheral event loop does not advance");
+
+		for (i = 0; i < Module_Num; i++)
+			if (Module[i]->Process)
+				Module[i]->Process();
+
+		if (wake && (Sim_SR & GIE) && Irq_Pending())
+			return 1;
+		if (Sim_Time >= t_end)
+			return 0;
+	}
+}
+
+// Accounts the CPU time executed since the last call and applies the side
+// effects of the register writes in between.
+void Sim_Sync(void)
+{
+	double cycles = (double)(Sim_Count.Blocks - Blocks_Synced) * Sim_Cycles_Per_Block;
+	double t = Sim_Time + cycles / SIM_MCLK_HZ + Stall_Time;
+
+	Blocks_Synced = Sim_Count.Blocks;
+	Stall_Time = 0;
+	Sync_Modules();
+	Service();
+	while (t > Sim_Time)
+	{
+		if (Advance(t, 1))
+			Service();
+	}
+	Sim_Count.Time = Sim_Time;
+}
+
+// The CPU busy-waits on a peripheral for the given time.
+void Sim_Stall(double seconds)
+{
+	Stall_Time += seconds;
+	Sim_Count.Stall_Cycles += (unsigned long long)(seconds * SIM_MCLK_HZ + 0.5);
+}
+
+
+//--------------------------------------------------------------------------
+//---  CPU: interrupts and low power modes
+//---
+
+// Services the highest priority pending interrupt. An ISR that clears CPUOFF
+// in the saved SR ends the LPM wait of the innermost level.
+static void Dispatch(void)
+{
+	int level = Lpm_Depth;
+	int i;
+	Isr_Frame frame, *outer = Frame;
+	const Sim_Vector *v = NULL;
+	double start = Sim_Cpu_Cycles(&Sim_Count);
+
+	for (i = 0; i < VECTOR_NUM; i++)
+		if (Vector[i].Pending(Vector[i].Arg))
+		{	v = &Vector[i];
+			break;
+		}
+	if (v == NULL)
+		return;
+	if (v->Isr == NULL)
+	{	static char msg[64];
+		snprintf(msg, sizeof(msg), "interrupt %s enabled without ISR", v->Name);
+		Sim_Stop(msg);
+	}
+
+	Sim_Count.Interrupts++;
+	if (Sim_SR & CPUOFF)
+		Sim_Count.Wakeups++;
+	Sim_Count.Isr_Cycles += SIM_ISR_ACCEPT_CYCLES + SIM_ISR_RETI_CYCLES;
+	Stall_Time += (SIM_ISR_ACCEPT_CYCLES + SIM_ISR_RETI_CYCLES) / SIM_MCLK_HZ;
+
+	frame.Saved_SR = Sim_SR;
+	frame.Clear_On_Exit = 0;
+	frame.Set_On_Exit = 0;
+	Frame = &frame;
+	Sim_SR &= ~(GIE | LPM4_bits);           // ISR runs active with GIE cleared
+
+	v->Accept(v->Arg);
+	v->Isr();
+
+	Frame = outer;
+	Sim_SR = (frame.Saved_SR & ~frame.Clear_On_Exit) | frame.Set_On_Exit;
+	if ((frame.Saved_SR & CPUOFF) && !(Sim_SR & CPUOFF))
+	{	Lpm_Exit[level] = 1;
+		Sim_Count.Lpm_Exits++;
+		Waking = 1;
+		Wake_Start = start;
+	}
+	Sim_Sync();
+}
+
+// Services the pending interrupts while GIE is set. Interrupts raised while
+// an ISR runs are taken after its RETI by the loop, not by nesting.
+static void Service(void)
+{
+	static int active;
+
+	if (active)
+		return;
+	active = 1;
+	while ((Sim_SR & GIE) && Irq_Pending())
+		Dispatch();
+	active = 0;
+}
+
+static void Enter_LPM(unsigned int bits)
+{
+	int level;
+
+	if (Lpm_Depth + 1 >= MAX_LEVEL)
+		Sim_Stop("LPM nesting too deep");
+	level = ++Lpm_Depth;
+	Lpm_Exit[level] = 0;
+	Sim_SR |= bits;
+	if (Waking)
+	{	Sim_Count.Wake_Cycles += Sim_Cpu_Cycles(&Sim_Count) - Wake_Start;
+		Waking = 0;
+	}
+
+	while (!Lpm_Exit[level])
+	{
+		if ((Sim_SR & GIE) && Irq_Pending())
+			Dispatch();
+		else
+			Advance(SIM_INFINITY, 1);
+	}
+
+	Sim_SR &= ~LPM4_bits;
+	Lpm_Depth--;
+	Service();
+}
+
+void Sim_Bis_SR(unsigned int bits)
+{
+	Sim_Sync();
+	if (bits & CPUOFF)
+	{	Sim_SR |= bits & GIE;
+		Enter_LPM(bits & LPM4_bits);
+	}
+	else
+	{	Sim_SR |= bits;
+		Service();
+	}
+}
+
+void Sim_Bic_SR(unsigned int bits)
+{
+	Sim_Sync();
+	Sim_SR &= ~bits;
+}
+
+void Sim_Bis_SR_On_Exit(unsigned int bits)
+{
+	if (Frame)
+		Frame->Set_On_Exit |= bits;
+}
+
+void Sim_Bic_SR_On_Exit(unsigned int bits)
+{
+	if (Frame)
+		Frame->Clear_On_Exit |= bits;
+}
+
+unsigned int Sim_Get_SR(void)
+{
+	return Sim_SR;
+}
+
+void Sim_Delay_Cycles(unsigned long cycles)
+{
+	double t_end;
+
+	Sim_Sync();
+	Sim_Count.Delay_Cycles += cycles;
+	t_end = Sim_Time + cycles / SIM_MCLK_HZ;
+	while (Sim_Time < t_end)
+	{
+		if (Advance(t_end, 1))
+			Service();
+	}
+	Sim_Count.Time = Sim_Time;
+}
+
+// DADD of BCD numbers with the given number of digits, the carry out is lost
+unsigned long Sim_Bcd_Add(unsigned long a, unsigned long b, int digits)
+{
+	unsigned long sum = 0;
+	unsigned int carry = 0;
+	int i;
+
+	for (i = 0; i < 4 * digits; i += 4)
+	{
+		unsigned int d = ((a >> i) & 0xF) + ((b >> i) & 0xF) + carry;
+
+		carry = d > 9;
+		sum |= (unsigned long)(carry ? d - 10 : d) << i;
+	}
+	return sum;
+}
+
+
+//--------------------------------------------------------------------------
+//---  P1.2 key of the EVM
+//---
+
+static double Key_Time = SIM_INFINITY;
+
+void Sim_Port_Press(double time)
+{
+	Key_Time = time;
+}
+
+static double Port_Next_Event(void)
+{
+	return Key_Time;
+}
+
+static void Port_Process(void)
+{
+	if (Sim_Time >= Key_Time)
+	{	Key_Time = SIM_INFINITY;
+		PAIFG_L |= BIT2;
+	}
+}
+
+int Sim_Port_Pending(int arg)
+{
+	(void)arg;
+	return (PAIE_L & PAIFG_L) != 0;
+}
+
+void Sim_Port_Accept(int arg)
+{
+	(void)arg;
+}
+
+const Sim_Module Sim_Port_Module = { "P1", NULL, NULL, Port_Next_Event, Port_Process };
+
+
+//--------------------------------------------------------------------------
+//---  Statistics
+//---
+
+void Sim_Snapshot(Sim_Counters *c)
+{
+	Sim_Count.Time = Sim_Time;
+	*c = Sim_Count;
+}
+
+void Sim_Counters_Sub(Sim_Counters *d, const Sim_Counters *a, const Sim_Counters *b)
+{
+	d->Time          = a->Time - b->Time;
+	d->Tsm_Sequences = a->Tsm_Sequences - b->Tsm_Sequences;
+	d->Interrupts    = a->Interrupts - b->Interrupts;
+	d->Wakeups       = a->Wakeups - b->Wakeups;
+	d->Blocks        = a->Blocks - b->Blocks;
+	d->Isr_Cycles    = a->Isr_Cycles - b->Isr_Cycles;
+	d->Delay_Cycles  = a->Delay_Cycles - b->Delay_Cycles;
+	d->Stall_Cycles  = a->Stall_Cycles - b->Stall_Cycles;
+	d->Dma_Cycles    = a->Dma_Cycles - b->Dma_Cycles;
+	d->Lpm_Exits     = a->Lpm_Exits - b->Lpm_Exits;
+	d->Wake_Cycles   = a->Wake_Cycles - b->Wake_Cycles;
+	d->Lpm0_Time     = a->Lpm0_Time - b->Lpm0_Time;
+	d->Request_Time  = a->Request_Time - b->Request_Time;
+}
+
+static void Counters_Add(Sim_Counters *d, const Sim_Counters *a)
+{
+	d->Time          += a->Time;
+	d->Tsm_Sequences += a->Tsm_Sequences;
+	d->Interrupts    += a->Interrupts;
+	d->Wakeups       += a->Wakeups;
+	d->Blocks        += a->Blocks;
+	d->Isr_Cycles    += a->Isr_Cycles;
+	d->Delay_Cycles  += a->Delay_Cycles;
+	d->Stall_Cycles  += a->Stall_Cycles;
+	d->Dma_Cycles    += a->Dma_Cycles;
+	d->Lpm_Exits     += a->Lpm_Exits;
+	d->Wake_Cycles   += a->Wake_Cycles;
+	d->Lpm0_Time     += a->Lpm0_Time;
+	d->Request_Time  += a->Request_Time;
+}
+
+double Sim_Cpu_Cycles(const Sim_Counters *c)
+{
+	return (double)c->Blocks * Sim_Cycles_Per_Block
+	     + (double)(c->Isr_Cycles + c->Delay_Cycles + c->Stall_Cycles + c->Dma_Cycles);
+}
+
+// The CPU is active for the estimated CPU cycles, sleeps with the DCO on in
+// LPM0 or for an I2C transfer in LPM3, and in LPM3 for the rest of the time;
+// every TSM sequence adds the charge of the ESI.
+double Sim_Charge(const Sim_Counters *c)
+{
+	double active = Sim_Cpu_Cycles(c) / SIM_MCLK_HZ;
+	double dco = c->Lpm0_Time + c->Request_Time;
+	double sleep = (c->Time > active + dco) ? c->Time - active - dco : 0;
+
+	return active * Sim_Part.I_Active + dco * Sim_Part.I_Lpm0 + sleep * Sim_Part.I_Lpm3
+	     + c->Tsm_Sequences * Sim_Part.Q_Tsm_Sequence;
+}
+
+unsigned long long Sim_Aclk_Ticks(const Sim_Counters *c)
+{
+	return (unsigned long long)(c->Time * SIM_ACLK_HZ + 0.5);
+}
+
+static int Phase_Of(const void *fn)
+{
+	unsigned int h = ((unsigned long)fn >> 4) & 1023;
+	Dl_info info;
+
+	while (Phase_Hash[h])
+	{
+		if (Phase[Phase_Hash[h] - 1].Fn == fn)
+			return Phase_Hash[h] - 1;
+		h = (h + 1) & 1023;
+	}
+	if (Phase_Num >= MAX_PHASES)
+		return -1;
+
+	Phase[Phase_Num].Fn = fn;
+	if (dladdr(fn, &info) && info.dli_sname)
+		snprintf(Phase[Phase_Num].Name, sizeof(Phase[0].Name), "%s", info.dli_sname);
+	else
+		snprintf(Phase[Phase_Num].Name, sizeof(Phase[0].Name), "%p", fn);
+	Phase_Hash[h] = (short)(++Phase_Num);
+	return Phase_Num - 1;
+}
+
+int Sim_Phase_Count(void)
+{
+	return Phase_Num;
+}
+
+Sim_Phase *Sim_Phase_Get(int index)
+{
+	return &Phase[index];
+}
+
+Sim_Phase *Sim_Phase_Find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < Phase_Num; i++)
+		if (strcmp(Phase[i].Name, name) == 0)
+			return &Phase[i];
+	return NULL;
+}
+
+// Closes the calls left open when the simulation was stopped.
+void Sim_Phase_Close_All(void)
+{
+	Sim_Counters now, d;
+
+	Sim_Snapshot(&now);
+	while (Call_Depth > 0)
+	{
+		Call_Depth--;
+		if (Call_Depth < MAX_CALL_DEPTH && Call[Call_Depth].Phase >= 0)
+		{	Sim_Counters_Sub(&d, &now, &Call[Call_Depth].Start);
+			Counters_Add(&Phase[Call[Call_Depth].Phase].Total, &d);
+			Phase[Call[Call_Depth].Phase].Calls++;
+		}
+	}
+}
+
+const void *Sim_Function(const char *name)
+{
+	return dlsym(RTLD_DEFAULT, name);
+}
+
+void *Sim_Variable(const char *name, size_t *size)
+{
+	void *addr = dlsym(RTLD_DEFAULT, name);
+	const ElfW(Sym) *sym = NULL;
+	Dl_info info;
+
+	if (!addr || !dladdr1(addr, &info, (void **)&sym, RTLD_DL_SYMENT) || !sym)
+		return NULL;
+	*size = sym->st_size;
+	return addr;
+}
+
+void __cyg_profile_func_enter(void *fn, void *site)
+{
+	(void)site;
+	Sim_Sync();
+	if (Call_Depth < MAX_CALL_DEPTH)
+	{	Call[Call_Depth].Phase = Phase_Of(fn);
+		Sim_Snapshot(&Call[Call_Depth].Start);
+	}
+	Call_Depth++;
+}
+
+void __cyg_profile_func_exit(void *fn, void *site)
+{
+	Sim_Counters now, d;
+
+	(void)site;
+	Sim_Sync();
+	if (Call_Depth == 0)
+		return;
+	Call_Depth--;
+	if (Call_Depth < MAX_CALL_DEPTH && Call[Call_Depth].Phase >= 0)
+	{	Sim_Snapshot(&now);
+		Sim_Counters_Sub(&d, &now, &Call[Call_Depth].Start);
+		Counters_Add(&Phase[Call[Call_Depth].Phase].Total, &d);
+		Phase[Call[Call_Depth].Phase].Calls++;
+	}
+	if (fn == Sim_Stop_After)
+		Sim_Stop("stop function returned");
+}
+
+void __sanitizer_cov_trace_pc(void)
+{
+	Sim_Count.Blocks++;
+	Sim_ESI_Poll();
+	Sim_ADC_Poll();
+}
+
+
+//--------------------------------------------------------------------------
+//---  Random numbers (xorshift64*)
+//---
+
+double Sim_Rand(void)
+{
+	Rand_State ^= Rand_State >> 12;
+	Rand_State ^= Rand_State << 25;
+	Rand_State ^= Rand_State >> 27;
+	return (double)((Rand_State * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double Sim_Gauss(void)
+{
+	static int have;
+	static double next;
+	double u, v, s;
+
+	if (have)
+	{	have = 0;
+		return next;
+	}
+	do
+	{	u = 2.0 * Sim_Rand() - 1.0;
+		v = 2.0 * Sim_Rand() - 1.0;
+		s = u * u + v * v;
+	} while ((s >= 1.0) || (s == 0.0));
+	s = sqrt(-2.0 * log(s) / s);
+	next = v * s;
+	have = 1;
+	return u * s;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Reset
+//---
+
+void Sim_Reset(unsigned long long seed)
+{
+	int i;
+
+	memset((void *)Sim_Periph, 0, sizeof(Sim_Periph));
+	memset(&Sim_Count, 0, sizeof(Sim_Count));
+	Sim_Time = 0;
+	Sim_SR = 0;
+	Blocks_Synced = 0;
+	Stall_Time = 0;
+	Lpm_Depth = 0;
+	Waking = 0;
+	Frame = NULL;
+	Call_Depth = 0;
+	Rand_State = seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+
+	Sim_Rotor_Reset();
+
+	Module_Num = 0;
+	Sim_Add_Module(&Sim_ESI_Module);
+	Sim_Add_Module(&Sim_Timer_Module);
+	Sim_Add_Module(&Sim_IIC_Module);
+	Sim_Add_Module(&Sim_Port_Module);
+	Sim_Add_Module(&Sim_LCD_Module);
+	Sim_Add_Module(&Sim_DMA_Module);
+	Sim_Add_Module(&Sim_ADC_Module);
+	for (i = 0; i < Module_Num; i++)
+		if (Module[i]->Reset)
+			Module[i]->Reset();
+}
@@ -0,0 +1,153 @@
+/* SimDMA.c
+ *
+ * DMA controller, channels 0..2 in single and repeated single transfer mode,
+ * triggered by the edge of a peripheral flag (Sim_DMA_Trigger(), the eUSCI_B0
+ * UCB0RXIFG0 and UCB0TXIFG0). A trigger moves one byte or word at once and
+ * counts the size down; at the end of the block DMAEN is cleared (single
+ * transfer) and DMAIFG set. The DMA interrupt is not modelled. A transfer takes
+ * 2 MCLK cycles, counted as Dma_Cycles whether the CPU is active or in an LPM.
+ *
+ * DMAxSA and DMAxDA hold 20-bit addresses on the target. The firmware writes
+ * them with __data16_write_addr(); the host pointer is kept here, not in the
+ * peripheral file.
+ */
+
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define DMA_CHANNELS        3
+#define DMA_CTL(n)          (0x0510 + 0x10 * (n))
+#define DMA_SA(n)           (0x0512 + 0x10 * (n))
+#define DMA_DA(n)           (0x0516 + 0x10 * (n))
+#define DMA_SZ(n)           (0x051A + 0x10 * (n))
+#define DMA_CYCLES          2                   // MCLK cycles of a single transfer
+
+typedef struct
+{
+	unsigned long Sa, Da;                   // host pointers written by __data16_write_addr()
+	unsigned long Src, Dst;                 // the running block
+	unsigned int  Size;                     // transfers left in the block
+	int           Loaded;                   // Src, Dst and Size hold the block of DMAEN
+} Dma_Channel;
+
+static Dma_Channel Channel[DMA_CHANNELS];
+
+
+static unsigned int Trigger_Select(int n)
+{
+	switch (n)
+	{
+	case 0:  return DMACTL0 & 0x1F;
+	case 1:  return (DMACTL0 >> 8) & 0x1F;
+	default: return DMACTL1 & 0x1F;
+	}
+}
+
+// Address step of DMASRCINCR / DMADSTINCR (bits 1..0 of incr)
+static long Step(unsigned int incr, int byte)
+{
+	switch (incr & 3)
+	{
+	case 2:  return byte ? -1 : -2;
+	case 3:  return byte ? 1 : 2;
+	default: return 0;
+	}
+}
+
+static void Load(int n)
+{
+	Dma_Channel *c = &Channel[n];
+
+	if (!c->Sa || !c->Da)
+	{	static char msg[64];
+		snprintf(msg, sizeof(msg), "DMA%d address not written with __data16_write_addr()", n);
+		Sim_Stop(msg);
+	}
+	c->Src = c->Sa;
+	c->Dst = c->Da;
+	c->Size = SIM_REG16(DMA_SZ(n));
+	c->Loaded = 1;
+}
+
+static void Transfer(int n)
+{
+	Dma_Channel *c = &Channel[n];
+	unsigned int ctl = SIM_REG16(DMA_CTL(n));
+	unsigned int dt = (ctl >> 12) & 7;
+	int src_byte = (ctl & DMASRCBYTE) != 0, dst_byte = (ctl & DMADSTBYTE) != 0;
+	unsigned int data;
+
+	if ((dt != 0) && (dt != 4))
+		Sim_Stop("DMA block transfer modes are not modelled");
+	if (!c->Loaded)
+		Load(n);
+	if (c->Size == 0)
+		return;
+
+	data = src_byte ? *(volatile unsigned char *)c->Src : *(volatile unsigned short *)c->Src;
+	if (dst_byte)
+		*(volatile unsigned char *)c->Dst = data & 0xFF;
+	else
+		*(volatile unsigned short *)c->Dst = data;
+	c->Src += Step(ctl >> 8, src_byte);
+	c->Dst += Step(ctl >> 10, dst_byte);
+	Sim_Count.Dma_Cycles += DMA_CYCLES;
+
+	if (--c->Size == 0)
+	{	SIM_REG16(DMA_CTL(n)) |= DMAIFG;
+		if (dt == 0)
+			SIM_REG16(DMA_CTL(n)) &= ~DMAEN;
+		c->Loaded = 0;                      // repeated: the next trigger reloads the block
+	}
+}
+
+int Sim_DMA_Trigger(int trigger)
+{
+	int n, served = 0;
+
+	for (n = 0; n < DMA_CHANNELS; n++)
+		if ((SIM_REG16(DMA_CTL(n)) & DMAEN) && (Trigger_Select(n) == (unsigned int)trigger))
+		{	Transfer(n);
+			served = 1;
+		}
+	return served;
+}
+
+void Sim_Data16_Write_Addr(unsigned short addr, unsigned long src)
+{
+	int n;
+
+	for (n = 0; n < DMA_CHANNELS; n++)
+		if (addr == DMA_SA(n) || addr == DMA_DA(n))
+		{	if (addr == DMA_SA(n))
+				Channel[n].Sa = src;
+			else
+				Channel[n].Da = src;
+			Channel[n].Loaded = 0;
+			SIM_REG16(addr) = src & 0xFFFF;
+			SIM_REG16(addr + 2) = (src >> 16) & 0x000F;
+			return;
+		}
+	Sim_Stop("__data16_write_addr() to a register without 20-bit address");
+}
+
+static void DMA_Reset(void)
+{
+	int n;
+
+	for (n = 0; n < DMA_CHANNELS; n++)
+	{	Channel[n].Sa = Channel[n].Da = 0;
+		Channel[n].Loaded = 0;
+	}
+}
+
+static void DMA_Sync(void)
+{
+	int n;
+
+	for (n = 0; n < DMA_CHANNELS; n++)
+		if (!(SIM_REG16(DMA_CTL(n)) & DMAEN))
+			Channel[n].Loaded = 0;              // enabling it again loads the block
+}
+
+const Sim_Module Sim_DMA_Module = { "DMA", DMA_Reset, DMA_Sync, NULL, NULL };
@@ -0,0 +1,364 @@
+/* SimESI.c
+ *
+ * Extended Scan Interface model: TSM, AFE1/AFE2 with DAC registers, PPU
+ * output latches, PSM with ESIRAM state table and counters, interrupt flags
+ * and vector, and the ESIOSC with its ESICNT3 frequency measurement.
+ *
+ * A TSM sequence is evaluated completely at its start trigger: the state list
+ * ESITSM0..31 is walked to get the time of every state, the channel release
+ * times (ESIEX + ESILCEN) and the comparator decisions of the states with
+ * ESIRSON + ESICA + ESIDAC. The results become visible at the end of the
+ * sequence (ESISTOP), when the PPU latches, the PSM and the flags are updated.
+ */
+
+#include <math.h>
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define TSM_STATES      32
+#define ACLK_TICK(t)    ((unsigned long long)floor((t) * SIM_ACLK_HZ + 1e-6))
+
+Sim_Part_Config Sim_Part =
+{
+	4.6e6,                                  // Esiosc_Hz
+	0.008,                                  // Esiosc_Step
+	0.0,                                    // Esiosc_Tempco
+	1.5,                                    // Comparator_Noise
+	6.0,                                    // Afe2_Offset
+	2690.0,                                 // Adc_Temp_30C (788 mV)
+	8.5,                                    // Adc_Temp_Slope (2.5 mV/degC)
+	480e-6,                                 // I_Active (FRAM, 4 MHz, datasheet typical)
+	160e-6,                                 // I_Lpm0 (4 MHz, estimate)
+	0.9e-6,                                 // I_Lpm3 (LFXT, LCD off)
+	6e-9,                                   // Q_Tsm_Sequence (excitation, AFE1, DAC per channel)
+};
+
+static unsigned int  Ctl_Prev;              // ESICTL seen at the last sync
+static unsigned int  Tsm_Prev;              // ESITSM seen at the last sync
+static unsigned char Clkgon_Prev;           // ESICLKGON seen at the last poll
+
+static unsigned long long Trigger_Tick;     // ACLK tick of the next ACLK divider trigger
+static double Trigger_Time;                 // SIM_INFINITY if no trigger is scheduled
+static double Seq_End;                      // end of the running sequence, SIM_INFINITY if idle
+
+static unsigned int  Seq_Out;               // PPU outputs latched by the running sequence
+static unsigned int  Seq_Mask;              // PPU outputs written by the running sequence
+static unsigned char Psm_State;             // Q0..Q7 of the present PSM state
+
+
+//--------------------------------------------------------------------------
+//---  ESIOSC
+//---
+
+double Sim_Esiosc_Hz(void)
+{
+	int fq = (ESIOSC >> 8) & 0x3F;
+
+	return Sim_Part.Esiosc_Hz * (1.0 + Sim_Part.Esiosc_Step * (fq - 32))
+	       * (1.0 + Sim_Part.Esiosc_Tempco * (Sim_Sensor_Temperature(Sim_Time) - 25.0));
+}
+
+// Called for every basic block of the firmware: a rising edge of ESICLKGON
+// starts an ESICNT3 measurement, which the firmware polls until it differs
+// from 0x01. The result is stored at once and the polling time is charged as
+// CPU stall time (gate of one ACLK period, started at the next ACLK edge).
+void Sim_ESI_Poll(void)
+{
+	unsigned char on = ESIOSC_L & ESICLKGON;
+
+	if (on == Clkgon_Prev)
+		return;
+	Clkgon_Prev = on;
+	if (on)
+	{	ESICNT3 = (unsigned short)floor(Sim_Esiosc_Hz() / SIM_ACLK_HZ + Sim_Rand());
+		Sim_Stall((1.0 + Sim_Rand()) * SIM_ACLK_PERIOD);
+	}
+}
+
+
+//--------------------------------------------------------------------------
+//---  TSM
+//---
+
+static unsigned int Trigger_Divider(void)
+{
+	unsigned int a = (ESITSM >> 4) & 7;
+	unsigned int b = (ESITSM >> 7) & 7;
+
+	return (4 * a + 2) * (2 * b + 1);
+}
+
+static void Schedule_Trigger(void)
+{
+	unsigned long long n = Trigger_Divider();
+
+	if (!(ESICTL & ESIEN) || !(ESITSM & ESITSMTRG0))
+	{	Trigger_Time = SIM_INFINITY;
+		return;
+	}
+	Trigger_Tick = (ACLK_TICK(Sim_Time) / n + 1) * n;
+	Trigger_Time = Trigger_Tick * SIM_ACLK_PERIOD;
+}
+
+static double Next_Aclk_Edge(double t, unsigned int n)
+{
+	return (ACLK_TICK(t) + n) * SIM_ACLK_PERIOD;
+}
+
+double Sim_TSM_Clock_Hz(void)
+{
+	double hf = (ESIOSC & ESIHFSEL) ? Sim_Esiosc_Hz() : SIM_MCLK_HZ;
+
+	return hf / (1 << (ESITSM & 3));        // ESIDIV1
+}
+
+// Walks the state list ESITSM0..31 of a sequence started at t0 and returns
+// the comparator latch windows (ESIRSON + ESICA + ESIDAC) relative to the
+// release of the excitation (ESIEX + ESILCEN) of their channel.
+int Sim_TSM_Schedule(double t0, Sim_TSM_Sample *sample, int max, double *t_end)
+{
+	double hf = Sim_TSM_Clock_Hz();
+	double release[4] = { 0, 0, 0, 0 };
+	double t = t0;
+	int i, n = 0;
+
+	for (i = 0; i < TSM_STATES; i++)
+	{
+		unsigned int s = SIM_REG16(0x0D60 + 2 * i);
+		unsigned int reps = (s >> 11) + 1;
+		int ch = s & 3;
+		double tend;
+
+		if (s & ESISTOP)
+			break;
+		tend = (s & ESICLK) ? Next_Aclk_Edge(t, reps) : t + reps / hf;
+
+		if ((s & (ESIEX | ESILCEN)) == (ESIEX | ESILCEN))
+			release[ch] = tend;
+
+		if (((s & (ESIRSON | ESICA | ESIDAC)) == (ESIRSON | ESICA | ESIDAC)) && (n < max))
+		{	sample[n].Channel = ch;
+			sample[n].Start = t - release[ch];
+			sample[n].End = tend - release[ch];
+			n++;
+		}
+		t = tend;
+	}
+
+	*t_end = (t > t0) ? t : t0 + 1.0 / hf;
+	return n;
+}
+
+static void Run_Sequence(double t0)
+{
+	Sim_TSM_Sample sample[TSM_STATES];
+	unsigned int out = ESIPPU;
+	int i, n;
+
+	n = Sim_TSM_Schedule(t0, sample, TSM_STATES, &Seq_End);
+	Seq_Out = 0;
+	Seq_Mask = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		int ch = sample[i].Channel;
+		double level = Sim_Sensor_Level(ch, t0, sample[i].Start, sample[i].End);
+		unsigned int prev = (out >> ch) & 1;
+		double dac = SIM_REG16(0x0D40 + 2 * (2 * ch + prev));
+		unsigned int bit = (level + Sim_Part.Comparator_Noise * Sim_Gauss()) > dac;
+
+		bit ^= (ESIAFE & ESICA1INV) ? 1 : 0;
+		Seq_Out = (Seq_Out & ~(1u << ch)) | (bit << ch);
+		Seq_Mask |= 1u << ch;
+
+		if ((ESIAFE & ESICA2EN) && (ESIAFE & ESIDAC2EN))
+		{
+			prev = (out >> (4 + ch)) & 1;
+			dac = SIM_REG16(0x0D50 + 2 * (2 * ch + prev)) - Sim_Part.Afe2_Offset;
+			bit = (level + Sim_Part.Comparator_Noise * Sim_Gauss()) > dac;
+			bit ^= (ESIAFE & ESICA2INV) ? 1 : 0;
+			Seq_Out = (Seq_Out & ~(1u << (4 + ch))) | (bit << (4 + ch));
+			Seq_Mask |= 1u << (4 + ch);
+		}
+	}
+	ESIINT2 |= ESIIFG2;
+}
+
+
+//--------------------------------------------------------------------------
+//---  PPU, PSM and counters
+//---
+
+static unsigned int Out_Bit(unsigned int out, unsigned int sel)
+{
+	return (out >> (sel & 7)) & 1;
+}
+
+// ESIIS0x / ESIIS2x: every change, modulo 4, modulo 256, wrap to zero
+static void Count_Flag(unsigned int mode, unsigned int cnt, unsigned int flag)
+{
+	static const unsigned int Mask[4] = { 0x0000, 0x0003, 0x00FF, 0xFFFF };
+
+	if ((cnt & Mask[mode]) == 0)
+		ESIINT2 |= flag;
+}
+
+static void End_Sequence(void)
+{
+	unsigned int out = (ESIPPU & ~Seq_Mask) | (Seq_Out & Seq_Mask);
+	unsigned int s1, s2, v2, q, sel;
+
+	Seq_End = SIM_INFINITY;
+	Sim_Count.Tsm_Sequences++;
+	ESIPPU = (ESIPPU & ~0xFF) | (out & 0xFF);
+	ESIINT2 |= ESIIFG1;
+
+	s1 = Out_Bit(out, ESICTL >> 7);
+	s2 = Out_Bit(out, ESICTL >> 10);
+	v2 = (ESIPSM & ESIV2SEL) ? (Psm_State & 1) : Out_Bit(out, ESICTL >> 13);
+	q = SIM_REG8(0x0E00 + (s1 | (s2 << 1) | (v2 << 2) | (((Psm_State >> 3) & 7) << 3)));
+	Psm_State = q;
+
+	if ((q & 0x06) == 0x06)
+	{	if (ESIPSM & ESICNT2EN)
+		{	ESICNT2--;
+			Count_Flag((ESIINT2 >> 13) & 3, ESICNT2, ESIIFG4);
+		}
+		if (ESIPSM & ESICNT0EN)
+		{	ESICNT0++;
+			Count_Flag((ESIINT2 >> 10) & 3, ESICNT0, ESIIFG7);
+		}
+	}
+	else if (q & 0x02)
+	{	if (ESIPSM & ESICNT1EN)
+		{	ESICNT1++;
+			if ((ESICNT1 == ESITHR1) || (ESICNT1 == ESITHR2))
+				ESIINT2 |= ESIIFG3;
+		}
+		if (ESIPSM & ESICNT0EN)
+		{	ESICNT0++;
+			Count_Flag((ESIINT2 >> 10) & 3, ESICNT0, ESIIFG7);
+		}
+	}
+	else if (q & 0x04)
+	{	if (ESIPSM & ESICNT1EN)
+		{	ESICNT1--;
+			if ((ESICNT1 == ESITHR1) || (ESICNT1 == ESITHR2))
+				ESIINT2 |= ESIIFG3;
+		}
+	}
+	if (q & 0x40)
+		ESIINT2 |= ESIIFG5;
+	if (q & 0x80)
+		ESIINT2 |= ESIIFG6;
+
+	sel = (ESIINT1 >> 10) & 7;
+	if (Out_Bit(out, sel >> 1) ^ (sel & 1))
+		ESIINT2 |= ESIIFG0;
+	sel = (ESIINT1 >> 13) & 7;
+	if (Out_Bit(out, 4 + (sel >> 1)) ^ (sel & 1))
+		ESIINT2 |= ESIIFG8;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Module
+//---
+
+static void ESI_Reset(void)
+{
+	ESIOSC = 0x2000;                        // ESICLKFQ = 0x20
+	Ctl_Prev = 0;
+	Tsm_Prev = 0;
+	Clkgon_Prev = 0;
+	Trigger_Time = SIM_INFINITY;
+	Seq_End = SIM_INFINITY;
+	Psm_State = 0;
+}
+
+static void ESI_Sync(void)
+{
+	unsigned int ctl = ESICTL;
+	unsigned int tsm = ESITSM & ~ESISTART;
+
+	if (ESIPSM & (ESICNT0RST | ESICNT1RST | ESICNT2RST))
+	{	if (ESIPSM & ESICNT0RST) ESICNT0 = 0;
+		if (ESIPSM & ESICNT1RST) ESICNT1 = 0;
+		if (ESIPSM & ESICNT2RST) ESICNT2 = 0;
+		ESIPSM &= ~(ESICNT0RST | ESICNT1RST | ESICNT2RST);
+	}
+
+	if ((ctl ^ Ctl_Prev) & ESIEN)
+	{
+		if (ctl & ESIEN)
+		{	ESICNT0 = 0;
+			ESICNT1 = 0;
+			ESICNT2 = 0;
+			Psm_State = 0;
+		}
+		else
+			Seq_End = SIM_INFINITY;
+		Tsm_Prev = tsm;
+		Schedule_Trigger();
+	}
+	else if (tsm != Tsm_Prev)
+	{	Tsm_Prev = tsm;
+		Schedule_Trigger();
+	}
+	Ctl_Prev = ctl;
+
+	if (ESITSM & ESISTART)
+	{	ESITSM &= ~ESISTART;
+		if ((ctl & ESIEN) && (ESITSM & ESITSMTRG1) && (Seq_End >= SIM_INFINITY))
+			Run_Sequence(Next_Aclk_Edge(Sim_Time, 1));
+	}
+}
+
+static double ESI_Next_Event(void)
+{
+	return (Seq_End < Trigger_Time) ? Seq_End : Trigger_Time;
+}
+
+static void ESI_Process(void)
+{
+	if (Sim_Time >= Seq_End)
+		End_Sequence();
+	if (Sim_Time >= Trigger_Time)
+	{
+		unsigned long long n = Trigger_Divider();
+
+		if (Seq_End >= SIM_INFINITY)        // a trigger during a sequence is lost
+			Run_Sequence(Trigger_Time);
+		Trigger_Tick += n;
+		Trigger_Time = Trigger_Tick * SIM_ACLK_PERIOD;
+	}
+}
+
+int Sim_ESI_Pending(int arg)
+{
+	(void)arg;
+	return (ESIINT1 & ESIINT2 & 0x01FF) != 0;
+}
+
+void Sim_ESI_Accept(int arg)
+{
+	static const struct { unsigned int Flag, Iv; } Priority[] =
+	{
+		{ ESIIFG1, ESIIV_ESIIFG1 }, { ESIIFG0, ESIIV_ESIIFG0 }, { ESIIFG8, ESIIV_ESIIFG8 },
+		{ ESIIFG3, ESIIV_ESIIFG3 }, { ESIIFG6, ESIIV_ESIIFG6 }, { ESIIFG5, ESIIV_ESIIFG5 },
+		{ ESIIFG4, ESIIV_ESIIFG4 }, { ESIIFG7, ESIIV_ESIIFG7 }, { ESIIFG2, ESIIV_ESIIFG2 },
+	};
+	unsigned int pending = ESIINT1 & ESIINT2 & 0x01FF;
+	unsigned int i;
+
+	(void)arg;
+	ESIIV = ESIIV_NONE;
+	for (i = 0; i < sizeof(Priority) / sizeof(Priority[0]); i++)
+		if (pending & Priority[i].Flag)
+		{	ESIIV = Priority[i].Iv;         // reading ESIIV clears the flag
+			ESIINT2 &= ~Priority[i].Flag;
+			break;
+		}
+}
+
+const Sim_Module Sim_ESI_Module = { "ESI", ESI_Reset, ESI_Sync, ESI_Next_Event, ESI_Process };
@@ -0,0 +1,288 @@
+/* SimGen.c
+ *
+ * lcgen: LC sensor signal generator without the firmware.
+ *
+ * Loads the TSM state list of InitScanIF() (2 or 3 LC sensors) with a given
+ * length of the tunable delay chain (ESITSM3..8 / 15..20 of the 2-LC firmware,
+ * the four delay states per channel of the 3-LC firmware), gets the comparator
+ * latch windows from Sim_TSM_Schedule() at the ESIOSC frequency and streams
+ * the sensor levels of a sequence per TSM trigger for a number of virtual
+ * meters with a part-to-part spread.
+ *
+ * Per meter the minimum and maximum level of every channel and the separation
+ * of the metal and non-metal level are listed (up to LIST_MAX meters), then the
+ * separation over all meters and the generator throughput.
+ * With -S the delay chain is swept per meter (like TSM_Auto_cal) and the delay
+ * with the largest separation is reported.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define MAX_SAMPLES     32
+#define LIST_MAX        20                  // meters listed one by one
+#define DELAY_MAX       64                  // upper end of the -S sweep [ESIFCLK cycles]
+
+static const unsigned short Tsm_2LC[] =
+{
+	0x0400, 0x202C, 0x0404, 0x0024, 0x0024, 0x0024, 0x0024, 0x0024, 0x0024, 0xF134, 0x5974,
+	0x0400, 0x0400,
+	0x20AD, 0x0485, 0x00A5, 0x00A5, 0x00A5, 0x00A5, 0x00A5, 0x00A5, 0xF1B5, 0x59F5,
+	0x0200,
+};
+
+static const unsigned short Tsm_3LC[] =
+{
+	0x0400, 0x182C, 0x0404, 0x0024, 0x0024, 0x0024, 0x0024, 0xC934, 0x4974,
+	0x0400, 0x0400,
+	0x18AD, 0x0485, 0x00A5, 0x00A5, 0x00A5, 0x00A5, 0xC9B5, 0x49F5,
+	0x0401, 0x0401,
+	0x182E, 0x0406, 0x0026, 0x0026, 0x0026, 0x0026, 0xC936, 0x4976,
+	0x0202,
+};
+
+typedef struct
+{
+	double Min[4], Max[4];
+} Stats;
+
+
+// Loads the TSM state list with 'delay' ESIFCLK cycles in every delay chain.
+// Like TSM_Auto_cal, the repeat count of the first delay state is filled up to
+// 32 cycles before the next one is extended.
+static void Load_TSM(int channels, int delay)
+{
+	const unsigned short *tsm = (channels == 3) ? Tsm_3LC : Tsm_2LC;
+	int n = (channels == 3) ? sizeof(Tsm_3LC) / 2 : sizeof(Tsm_2LC) / 2;
+	int taps = (channels == 3) ? 4 : 6;
+	int i, extra = 0, in_chain = 0;
+
+	if (delay < taps)
+		delay = taps;
+	if (delay > 32 * taps)
+		delay = 32 * taps;
+	for (i = 0; i < n; i++)
+	{
+		unsigned short s = tsm[i];
+
+		if ((s & ~3) == 0x0024)             // tunable delay state, 1 x ESIFCLK
+		{	int r;
+
+			if (!in_chain)
+				extra = delay - taps;
+			in_chain = 1;
+			r = (extra > 31) ? 31 : extra;
+			s |= r << 11;
+			extra -= r;
+		}
+		else
+			in_chain = 0;
+		SIM_REG16(0x0D60 + 2 * i) = s;
+	}
+	for (; i < 32; i++)
+		SIM_REG16(0x0D60 + 2 * i) = ESISTOP;
+}
+
+static void Sample_Meter(const Sim_TSM_Sample *sample, int n, double rate, unsigned long seqs, Stats *st, FILE *csv, int meter)
+{
+	unsigned long k;
+	int i;
+
+	memset(st, 0, sizeof(*st));
+	for (i = 0; i < 4; i++)
+	{	st->Min[i] = 1e9;
+		st->Max[i] = -1e9;
+	}
+
+	for (k = 0; k < seqs; k++)
+	{
+		double t = k / rate;
+
+		Sim_Time = t;
+		if (csv)
+			fprintf(csv, "%d,%.7f", meter, t);
+		for (i = 0; i < n; i++)
+		{
+			int ch = sample[i].Channel;
+			double v = Sim_Sensor_Level(ch, t, sample[i].Start, sample[i].End);
+
+			if (v < st->Min[ch]) st->Min[ch] = v;
+			if (v > st->Max[ch]) st->Max[ch] = v;
+			if (csv)
+				fprintf(csv, ",%.1f", v);
+		}
+		if (csv)
+			fputc('\n', csv);
+	}
+}
+
+// Separation of the metal and non-metal level of the channels at the given
+// delay, noise free.
+static double Separation(int channels, int delay)
+{
+	Sim_TSM_Sample sample[MAX_SAMPLES];
+	double noise = Sim_Sensor.Noise, accel = Sim_Sensor.Accel, t_end, sep = 1e9;
+	double lo[4], hi[4];
+	int i, j, n;
+
+	Load_TSM(channels, delay);
+	n = Sim_TSM_Schedule(0, sample, MAX_SAMPLES, &t_end);
+	Sim_Sensor.Noise = 0;
+	Sim_Sensor.Accel = 0;
+	Sim_Time = 0;
+	Sim_Rotor_Reset();
+	Sim_Rotor_Set_Speed(1.0);
+	for (i = 0; i < 4; i++)
+	{	lo[i] = 1e9;
+		hi[i] = -1e9;
+	}
+	for (j = 0; j < 64; j++)                // one revolution at 1 rps
+	{	Sim_Time = j / 64.0;
+		for (i = 0; i < n; i++)
+		{	double v = Sim_Sensor_Level(sample[i].Channel, Sim_Time, sample[i].Start, sample[i].End);
+			lo[sample[i].Channel] = fmin(lo[sample[i].Channel], v);
+			hi[sample[i].Channel] = fmax(hi[sample[i].Channel], v);
+		}
+	}
+	Sim_Sensor.Noise = noise;
+	Sim_Sensor.Accel = accel;
+	for (i = 0; i < n; i++)
+		sep = fmin(sep, hi[sample[i].Channel] - lo[sample[i].Channel]);
+	return sep;
+}
+
+static void Usage(void)
+{
+	fprintf(stderr,
+		"usage: lcgen [options] [name=value ...]\n"
+		"  -c N       LC sensors, 2 or 3 (default 2)\n"
+		"  -d CYCLES  ESIFCLK cycles of the tunable delay chain (default 6)\n"
+		"  -q FQ      ESICLKFQ (default 0x20)\n"
+		"  -f HZ      TSM sequence rate (default 2340)\n"
+		"  -r RPS     rotor speed (default 45)\n"
+		"  -T SEC     signal length per meter (default 1)\n"
+		"  -n METERS  virtual meters (default 1)\n"
+		"  -v SPREAD  relative part-to-part sigma of gain and Q (default 0)\n"
+		"  -s SEED    random seed (default 1)\n"
+		"  -S         sweep the delay chain per meter, report the best delay\n"
+		"  -o FILE    write the samples as CSV (meter,time,level per sample)\n"
+		"  -p         list the sensor and part parameters\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	Sim_Sensor_Config base;
+	Sim_TSM_Sample sample[MAX_SAMPLES];
+	int channels = 2, delay = 6, fq = 0x20, meters = 1, sweep = 0, opt, m, i, n;
+	double rate = 2340, rps = 45, length = 1, spread = 0, t_end, total = 0, wall;
+	double sep_min = 1e9, sep_sum = 0;
+	unsigned long long seed = 1;
+	const char *out = NULL;
+	FILE *csv = NULL;
+	clock_t c0;
+
+	while ((opt = getopt(argc, argv, "c:d:q:f:r:T:n:v:s:So:p")) != -1)
+	{
+		switch (opt)
+		{
+		case 'c': channels = atoi(optarg); break;
+		case 'd': delay = atoi(optarg); break;
+		case 'q': fq = strtol(optarg, NULL, 0); break;
+		case 'f': rate = atof(optarg); break;
+		case 'r': rps = atof(optarg); break;
+		case 'T': length = atof(optarg); break;
+		case 'n': meters = atoi(optarg); break;
+		case 'v': spread = atof(optarg); break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		case 'S': sweep = 1; break;
+		case 'o': out = optarg; break;
+		case 'p': Sim_Params(stdout); return 0;
+		default:  Usage();
+		}
+	}
+	if ((channels != 2) && (channels != 3))
+		Usage();
+
+	Sim_Reset(seed);
+	Sim_Sensor_Layout(channels);
+	for (; optind < argc; optind++)
+		if (!Sim_Param(argv[optind]))
+		{	fprintf(stderr, "lcgen: unknown parameter %s\n", argv[optind]);
+			return 2;
+		}
+	ESIOSC = ESIHFSEL | ((fq & 0x3F) << 8);
+	ESITSM = 0;                             // ESIDIV1 = 1
+	if (out && !(csv = fopen(out, "w")))
+	{	perror(out);
+		return 1;
+	}
+	base = Sim_Sensor;
+
+	printf("ESIOSC %.3f MHz, %d LC, delay %d cycles, %.0f Hz, %.1f rps\n\n",
+	       Sim_Esiosc_Hz() / 1e6, channels, delay, rate, rps);
+	if (meters <= LIST_MAX)
+		printf("%5s  %-*s %8s%s\n", "meter", 14 * channels - 1, "min/max per channel",
+		       "sep", sweep ? "  delay" : "");
+
+	c0 = clock();
+	for (m = 0; m < meters; m++)
+	{
+		Stats st;
+		double sep = 1e9;
+		int best = delay;
+
+		Sim_Sensor = base;
+		if (spread > 0)
+			Sim_Sensor_Randomize(spread);
+
+		if (sweep)
+		{	double best_sep = -1e9;
+			int d;
+
+			for (d = channels == 3 ? 4 : 6; d <= DELAY_MAX; d++)
+			{	double s = Separation(channels, d);
+
+				if (s > best_sep)
+				{	best_sep = s;
+					best = d;
+				}
+			}
+		}
+
+		Load_TSM(channels, best);
+		n = Sim_TSM_Schedule(0, sample, MAX_SAMPLES, &t_end);
+		Sim_Time = 0;
+		Sim_Rotor_Reset();
+		Sim_Rotor_Set_Speed(rps);
+		Sample_Meter(sample, n, rate, (unsigned long)(length * rate), &st, csv, m);
+		total += (length * rate) * n;
+
+		for (i = 0; i < channels; i++)
+			sep = fmin(sep, st.Max[i] - st.Min[i]);
+		sep_min = fmin(sep_min, sep);
+		sep_sum += sep;
+		if (meters > LIST_MAX)
+			continue;
+		printf("%5d", m);
+		for (i = 0; i < channels; i++)
+			printf(" %6.0f/%-6.0f", st.Min[i], st.Max[i]);
+		printf(" %8.1f", sep);
+		if (sweep)
+			printf("  %d", best);
+		printf("\n");
+	}
+	wall = (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+	if (csv)
+		fclose(csv);
+	printf("\n%d meters, separation min %.1f, mean %.1f\n", meters, sep_min, sep_sum / meters);
+	printf("%.0f samples in %.3f s, %.2f Msamples/s\n", total, wall, wall > 0 ? total / wall / 1e6 : 0);
+	return 0;
+}
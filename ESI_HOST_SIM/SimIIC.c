@@ -0,0 +1,195 @@
+/* SimIIC.c
+ *
+ * eUSCI_B0 in I2C master mode, byte level: START + address, data bytes with
+ * the byte counter (UCB0TBCNT) and the automatic STOP (UCASTP_2), ACK/NACK of
+ * the addressed device on Sim_IIC_Bus. Every byte takes 9 SCL periods of
+ * UCB0BRW SMCLK cycles. The transmitter waits (clock stretching) until the
+ * firmware has serviced UCTXIFG0. After a NACK the master holds the bus until
+ * the firmware sets UCTXSTP (STOP, UCSTPIFG) or UCTXSTT (repeated START).
+ * UCRXIFG0 and UCTXIFG0 trigger the DMA; a DMA channel that serves the flag
+ * reads UCB0RXBUF or writes UCB0TXBUF, which resets it.
+ */
+
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+const Sim_IIC_Slave *Sim_IIC_Bus;
+
+enum { IIC_IDLE, IIC_ADDRESS, IIC_TX_WAIT, IIC_DATA, IIC_STOP, IIC_NACKED };
+
+static int    State;
+static int    Read;                         // master receiver
+static unsigned int Count;                  // bytes transferred since START
+static unsigned char Tx_Byte;
+static double Event_Time;
+static unsigned long Transactions;
+static unsigned long Interrupts;
+
+
+static double Byte_Time(void)
+{
+	unsigned int br = UCB0BRW ? UCB0BRW : 1;
+
+	return 9.0 * br / SIM_MCLK_HZ;
+}
+
+static void Set_Rx_Tx_Ifg(unsigned int flag)
+{
+	if (!Sim_DMA_Trigger((flag == UCRXIFG0) ? SIM_DMA_UCB0RXIFG0 : SIM_DMA_UCB0TXIFG0))
+		UCB0IFG |= flag;
+}
+
+static int Last_Byte(void)
+{
+	return ((UCB0CTLW1 & UCASTP_3) == UCASTP_2) && (Count == UCB0TBCNT);
+}
+
+static void Start_Tx_Byte(void)
+{
+	Tx_Byte = UCB0TXBUF;
+	State = IIC_DATA;
+	Event_Time = Sim_Time + Byte_Time();
+	if (!((UCB0CTLW1 & UCASTP_3) == UCASTP_2) || (Count + 1 < UCB0TBCNT))
+		Set_Rx_Tx_Ifg(UCTXIFG0);            // TXBUF is free for the next byte
+}
+
+static void IIC_Reset(void)
+{
+	State = IIC_IDLE;
+	Event_Time = SIM_INFINITY;
+	Transactions = 0;
+	Interrupts = 0;
+}
+
+static void IIC_Sync(void)
+{
+	if (UCB0CTLW0 & UCSWRST)
+	{	State = IIC_IDLE;
+		Event_Time = SIM_INFINITY;
+		UCB0IFG = 0;
+		return;
+	}
+	if ((State == IIC_NACKED) && (UCB0CTLW0 & UCTXSTP) && !(UCB0CTLW0 & UCTXSTT))
+	{	State = IIC_STOP;
+		Event_Time = Sim_Time + 1.0 / SIM_MCLK_HZ * UCB0BRW;
+	}
+	else if (((State == IIC_IDLE) || (State == IIC_NACKED)) && (UCB0CTLW0 & UCTXSTT))
+	{
+		Read = !(UCB0CTLW0 & UCTR);
+		Count = 0;
+		State = IIC_ADDRESS;
+		Event_Time = Sim_Time + Byte_Time() + 1.0 / SIM_MCLK_HZ * UCB0BRW;
+		Transactions++;
+		if (!Read)
+			Set_Rx_Tx_Ifg(UCTXIFG0);
+	}
+	else if ((State == IIC_TX_WAIT) && !(UCB0IFG & UCTXIFG0))
+		Start_Tx_Byte();
+}
+
+static double IIC_Next_Event(void)
+{
+	return Event_Time;
+}
+
+static void IIC_Process(void)
+{
+	if (Sim_Time < Event_Time)
+		return;
+	Event_Time = SIM_INFINITY;
+
+	switch (State)
+	{
+	case IIC_ADDRESS:
+		UCB0CTLW0 &= ~UCTXSTT;
+		if (!Sim_IIC_Bus || !Sim_IIC_Bus->Start(UCB0I2CSA & 0x7F, Read))
+		{	UCB0IFG |= UCNACKIFG;           // the master waits for STOP or a new START
+			State = IIC_NACKED;
+			break;
+		}
+		if (Read)
+		{	State = IIC_DATA;
+			Event_Time = Sim_Time + Byte_Time();
+		}
+		else if (UCB0IFG & UCTXIFG0)
+			State = IIC_TX_WAIT;
+		else
+			Start_Tx_Byte();
+		break;
+
+	case IIC_DATA:
+		Count++;
+		if (Read)
+		{	UCB0RXBUF = Sim_IIC_Bus->Read();
+			Set_Rx_Tx_Ifg(UCRXIFG0);
+		}
+		else if (!Sim_IIC_Bus->Write(Tx_Byte))
+		{	UCB0IFG |= UCNACKIFG;
+			State = IIC_NACKED;
+			break;
+		}
+		if (Last_Byte())
+			UCB0IFG |= UCBCNTIFG;
+		if (Last_Byte() || (UCB0CTLW0 & UCTXSTP))
+		{	State = IIC_STOP;
+			Event_Time = Sim_Time + 1.0 / SIM_MCLK_HZ * UCB0BRW;
+		}
+		else if (Read)
+			Event_Time = Sim_Time + Byte_Time();
+		else if (UCB0IFG & UCTXIFG0)
+			State = IIC_TX_WAIT;
+		else
+			Start_Tx_Byte();
+		break;
+
+	case IIC_STOP:
+		if (Sim_IIC_Bus)
+			Sim_IIC_Bus->Stop();
+		UCB0CTLW0 &= ~UCTXSTP;
+		UCB0IFG |= UCSTPIFG;
+		State = IIC_IDLE;
+		break;
+	}
+}
+
+static const struct { unsigned int Flag, Iv; } Priority[] =
+{
+	{ UCALIFG,   USCI_I2C_UCALIFG   }, { UCNACKIFG, USCI_I2C_UCNACKIFG },
+	{ UCSTTIFG,  USCI_I2C_UCSTTIFG  }, { UCSTPIFG,  USCI_I2C_UCSTPIFG  },
+	{ UCRXIFG0,  USCI_I2C_UCRXIFG0  }, { UCTXIFG0,  USCI_I2C_UCTXIFG0  },
+	{ UCBCNTIFG, USCI_I2C_UCBCNTIFG }, { UCCLTOIFG, USCI_I2C_UCCLTOIFG },
+};
+
+int Sim_IIC_Clock_Request(void)
+{
+	return (State != IIC_IDLE) && (State != IIC_NACKED);
+}
+
+int Sim_IIC_Pending(int arg)
+{
+	(void)arg;
+	return (UCB0IE & UCB0IFG & 0x00FF) != 0;
+}
+
+void Sim_IIC_Stats(unsigned long *transactions, unsigned long *interrupts)
+{
+	*transactions = Transactions;
+	*interrupts = Interrupts;
+}
+
+void Sim_IIC_Accept(int arg)
+{
+	unsigned int i;
+
+	(void)arg;
+	UCB0IV = USCI_NONE;
+	for (i = 0; i < sizeof(Priority) / sizeof(Priority[0]); i++)
+		if (UCB0IE & UCB0IFG & Priority[i].Flag)
+		{	UCB0IV = Priority[i].Iv;        // reading UCB0IV resets the flag
+			UCB0IFG &= ~Priority[i].Flag;
+			Interrupts++;
+			break;
+		}
+}
+
+const Sim_Module Sim_IIC_Module = { "eUSCI_B0", IIC_Reset, IIC_Sync, IIC_Next_Event, IIC_Process };
@@ -0,0 +1,63 @@
+/* SimLCD.c
+ *
+ * LCD_C memory of the EVM430-FR6989 glass: clears the memory on LCDCLRM and
+ * reads back the numbers written by lcd_display_num(), large digits on the
+ * lower line (LCDM3, 5, 7, 9, 11) and small digits on the upper line
+ * (LCDM19, 18, 17, 16), or one number over both lines, the upper line first.
+ * Leading digits are blank (0x00).
+ */
+
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define LCDM(n)     SIM_REG8(0x0A20 + (n) - 1)
+
+static const unsigned char Large[10] = { 0xFC, 0x60, 0xDB, 0xF3, 0x67, 0xB7, 0xBF, 0xE0, 0xFF, 0xF7 };
+static const unsigned char Small[10] = { 0xCF, 0x06, 0xAD, 0x2F, 0x66, 0x6B, 0xEB, 0x0E, 0xEF, 0x6F };
+
+static const int Digit[] = { 19, 18, 17, 16, 3, 5, 7, 9, 11 };     // upper line, then lower line
+
+#define UPPER       4                       // Digit[0..3] small
+
+
+long Sim_LCD_Number(int line)
+{
+	int first = (line == SIM_LCD_LOWER) ? UPPER : 0;
+	int last = (line == SIM_LCD_UPPER) ? UPPER : 9;
+	long num = -1;
+	int i, d;
+
+	for (i = first; i < last; i++)
+	{
+		const unsigned char *seg = (i < UPPER) ? Small : Large;
+		unsigned char m = LCDM(Digit[i]);
+
+		if ((m == 0x00) && (num < 0))
+			continue;                       // leading blank
+		for (d = 0; d < 10; d++)
+			if (seg[d] == m)
+				break;
+		if (d == 10)
+			return -1;
+		num = ((num < 0) ? 0 : num * 10) + d;
+	}
+	return num;
+}
+
+int Sim_LCD_On(void)
+{
+	return (LCDCCTL0 & LCDON) != 0;
+}
+
+static void LCD_Sync(void)
+{
+	int i;
+
+	if (LCDCMEMCTL & LCDCLRM)
+	{	for (i = 1; i <= 43; i++)
+			LCDM(i) = 0;
+		LCDCMEMCTL &= ~LCDCLRM;
+	}
+}
+
+const Sim_Module Sim_LCD_Module = { "LCD_C", NULL, LCD_Sync, NULL, NULL };
@@ -0,0 +1,880 @@
+/* SimMain.c
+ *
+ * Runs the firmware main() in the simulator and reports, for every
+ * calibration phase, the simulated time, ACLK ticks, TSM sequences, wake-ups
+ * from LPM, CPU cycles and estimated supply charge spent (inclusive of the
+ * called functions). The report can be written as JSON (-j) and checked
+ * against regression thresholds (-B), see SimBench.c.
+ *
+ * The operator of the demo is part of the simulation: once the firmware shows
+ * "8888" on the lower LCD line (TSM calibration and noise level done), the
+ * rotor is started at the given speed so Set_DAC() and ReCalScanIF() can
+ * complete. Instead of a constant speed, the operator can replay a recorded
+ * rotor speed profile (-R): lines "time rps", time relative to the start.
+ * With -M the 2-LC firmware drives the rotor itself through the motor board on
+ * the I2C bus (SimMotor.c), and every 1000-rotation demonstration ends with the
+ * ESI count on the lower LCD line and the motor board count on the upper one;
+ * they are checked against each other.
+ *
+ * With -n the run is repeated for a number of virtual meters with a
+ * part-to-part spread of the LC sensors (-v). Every meter runs in a child
+ * process, so the firmware starts from its initial data, and is reported on
+ * one line; the JSON output and the threshold check (-j, -B) use the median
+ * over the meters.
+ *
+ * -F keeps the firmware variables in INFO FRAM (the calibration snapshot) in an
+ * image file over runs: it is loaded before main() and written when the run
+ * stops, so a second run is a reset of the meter in the field. The rotor keeps
+ * turning through such a reset. The report gives the time from the reset to
+ * the first count of ESICNT1 after InitScanIF() returned.
+ *
+ * -T writes the ISR trace of a firmware built with Isr_trace (Trace.h) as the
+ * TI-TXT memory dump of Trace_Log in the layout of the target, the input of
+ * tracedec (TraceDec.c). The report gives the cycles the trace costs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#ifndef SIM_CHANNELS
+#define SIM_CHANNELS    2
+#endif
+
+void fw_main(void);
+
+static const char *Phase_Name[] =
+{
+	"EsioscInit", "InitScanIF", "Restore_Snapshot", "TSM_Auto_cal", "Find_Noise_level", "Set_DAC", "ReCalScanIF",
+	"Drift_Probe_Start", "Drift_Probe_End", "Temp_Update", "Osc_Update",
+};
+
+static const char *Fram_Name[] =            // firmware variables in INFO FRAM and PERSISTENT
+{
+	"Cal_Snapshot", "Temp_Model", "Flow_Hist", "Skip_Log", "Trace_Log",
+};
+
+#define FRAM_VARS   (int)(sizeof(Fram_Name) / sizeof(Fram_Name[0]))
+
+#define PHASES      (int)(sizeof(Phase_Name) / sizeof(Phase_Name[0]))
+
+#define MAX_PARAMS  32
+#define MAX_PROFILE 4096
+#define MAX_DEMOS   64
+#define MAX_TRACE   1024                    // Trace_Log records written by -T
+
+#ifndef SIM_FW
+#define SIM_FW          "2LC"
+#endif
+
+#if SIM_CHANNELS == 3
+#define LCD_COUNT       SIM_LCD_BOTH        // the totalizer over both lines
+#else
+#define LCD_COUNT       SIM_LCD_LOWER       // the upper line shows the motor board
+#endif
+
+#define LCD_BENCH_RANGE 100000              // esisim -L: lcd_display_num() for 0..99999
+
+static double Operator_Rps = 45.0;
+static int    Rotor_Started;
+static int    Esien_Prev;
+static double Esien_Revolutions;            // rotor position when the ESI counters were reset
+static long   Lcd_Count = -1;               // count on the LCD
+static double Lcd_Revolutions;              // revolutions since the ESI enable when it was drawn
+static double Rotor_Start;                  // time the operator started the rotor
+static const Sim_Phase *Init_Phase;
+static int    Count_Prev;
+static double First_Count = -1;             // first ESICNT1 count after InitScanIF() returned
+static int    Operation_Started;
+static Sim_Counters Operation_Start;        // counters when InitScanIF() returned
+
+static struct { double Time, Rps; } Profile[MAX_PROFILE];
+static int Profile_Num;
+static int Profile_Next;
+
+static double Motor_Rps;                    // motor board on the I2C bus at this full speed, 0: none
+static struct { long Esi, Motor; } Demo[MAX_DEMOS];     // counts on the LCD at the end of a demonstration
+static int    Demo_Num;
+static unsigned long Demo_Stops;            // 0x20 commands at the last 0x00
+static unsigned long Demo_Halts;            // 0x00 commands
+
+
+//--------------------------------------------------------------------------
+//---  Operator of the demo
+//---
+
+static void Count_Check(void)
+{
+	int count = (short)ESICNT1;
+
+	if (!Init_Phase)
+		Init_Phase = Sim_Phase_Find("InitScanIF");
+	if (!Operation_Started && Init_Phase && Init_Phase->Calls)
+	{	Operation_Started = 1;
+		Sim_Snapshot(&Operation_Start);
+	}
+	if (First_Count >= 0)
+		return;
+	if (Init_Phase && Init_Phase->Calls && (count != 0) && (count != Count_Prev))
+		First_Count = Sim_Time;
+	Count_Prev = count;
+}
+
+// The demonstration stops the rotor after 1000 rotations (0x20) and shows both
+// counts until the next one begins with a stop command (0x00).
+static void Demo_Check(void)
+{
+	unsigned long stops = Sim_Motor_Commands(0x20), halts = Sim_Motor_Commands(0x00);
+
+	if (halts == Demo_Halts)
+		return;
+	Demo_Halts = halts;
+	if ((stops != Demo_Stops) && (Demo_Num < MAX_DEMOS))
+	{	Demo[Demo_Num].Esi = Sim_LCD_Number(SIM_LCD_LOWER);
+		Demo[Demo_Num].Motor = Sim_LCD_Number(SIM_LCD_UPPER);
+		Demo_Num++;
+	}
+	Demo_Stops = stops;
+}
+
+// Largest difference of the ESI and the motor board count over the
+// demonstrations, -1 if none ended or a count was not readable.
+static long Demo_Error(void)
+{
+	long worst = 0, d;
+	int i;
+
+	if (Demo_Num == 0)
+		return -1;
+	for (i = 0; i < Demo_Num; i++)
+	{
+		if ((Demo[i].Esi < 0) || (Demo[i].Motor < 0))
+			return -1;
+		d = labs(Demo[i].Esi - Demo[i].Motor);
+		worst = (d > worst) ? d : worst;
+	}
+	return worst;
+}
+
+static void Operator_Sync(void)
+{
+	int esien = (ESICTL & ESIEN) != 0;
+
+	if (Motor_Rps > 0)
+		Demo_Check();                       // the firmware drives the rotor
+	else if (!Rotor_Started && (Sim_LCD_Number(0) == 8888))
+	{	Rotor_Started = 1;
+		Rotor_Start = Sim_Time;
+		if (Profile_Num == 0)
+			Sim_Rotor_Set_Speed(Operator_Rps);
+	}
+	if (esien && !Esien_Prev)
+		Esien_Revolutions = Sim_Rotor_Revolutions();
+	Esien_Prev = esien;
+	if (Sim_LCD_Number(LCD_COUNT) != Lcd_Count)            // the display task draws it late
+	{	Lcd_Count = Sim_LCD_Number(LCD_COUNT);
+		Lcd_Revolutions = Sim_Rotor_Revolutions() - Esien_Revolutions;
+	}
+	Count_Check();
+}
+
+static double Operator_Next_Event(void)
+{
+	if (!Rotor_Started || (Profile_Next == Profile_Num))
+		return SIM_INFINITY;
+	return Rotor_Start + Profile[Profile_Next].Time;
+}
+
+static void Operator_Process(void)
+{
+	while ((Profile_Next < Profile_Num) && (Operator_Next_Event() <= Sim_Time))
+		Sim_Rotor_Set_Speed(Profile[Profile_Next++].Rps);
+	Count_Check();
+}
+
+static const Sim_Module Operator_Module = { "Operator", NULL, Operator_Sync, Operator_Next_Event, Operator_Process };
+
+static int Load_Profile(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[80];
+
+	if (!f)
+	{	perror(path);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), f) && (Profile_Num < MAX_PROFILE))
+		if (sscanf(line, "%lf %lf", &Profile[Profile_Num].Time, &Profile[Profile_Num].Rps) == 2)
+			Profile_Num++;
+	fclose(f);
+	return 1;
+}
+
+
+//--------------------------------------------------------------------------
+//---  FRAM image
+//---
+
+// Loads the INFO FRAM variables, "name size hex-bytes" per line. Returns 0 if
+// there is no image yet.
+static int Fram_Load(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char name[48];
+	size_t size, n, i;
+	int loaded = 0, v;
+
+	if (!f)
+		return 0;
+	while (fscanf(f, "%47s %zu", name, &size) == 2)
+	{
+		unsigned char *var = NULL;
+
+		for (v = 0; v < FRAM_VARS; v++)
+			if ((strcmp(name, Fram_Name[v]) == 0) && (var = Sim_Variable(name, &n)) && (n != size))
+				var = NULL;
+		for (i = 0; i < size; i++)
+		{	unsigned int byte;
+
+			if (fscanf(f, "%2x", &byte) != 1)
+				break;
+			if (var)
+				var[i] = (unsigned char)byte;
+		}
+		loaded |= (var != NULL);
+	}
+	fclose(f);
+	return loaded;
+}
+
+static int Fram_Save(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	size_t size, i;
+	int v;
+
+	if (!f)
+	{	perror(path);
+		return 0;
+	}
+	for (v = 0; v < FRAM_VARS; v++)
+	{
+		const unsigned char *var = Sim_Variable(Fram_Name[v], &size);
+
+		if (!var)
+			continue;
+		fprintf(f, "%s %zu ", Fram_Name[v], size);
+		for (i = 0; i < size; i++)
+			fprintf(f, "%02x", var[i]);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+	return 1;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Report
+//---
+
+static void Print_Phase(const Sim_Phase *p)
+{
+	printf("%-22s %6lu %10.3f %10llu %9llu %8llu %9.3f %12.0f %10.3f\n",
+	       p->Name, p->Calls, p->Total.Time * 1e3, Sim_Aclk_Ticks(&p->Total),
+	       p->Total.Tsm_Sequences, p->Total.Wakeups, p->Total.Lpm0_Time * 1e3,
+	       Sim_Cpu_Cycles(&p->Total), Sim_Charge(&p->Total) * 1e6);
+}
+
+static unsigned int Tsm_Period(void)        // ACLK cycles of the ESIDIV3 trigger
+{
+	return (4 * ((ESITSM >> 4) & 7) + 2) * (2 * ((ESITSM >> 7) & 7) + 1);
+}
+
+// Jumps over a sensor state counted by the firmware on ESICNT2, as Skip_Count()
+// computes them; 0 if the firmware does not detect them.
+static unsigned long Skips(void)
+{
+	const unsigned long *total = Sim_Function("Skip_total");
+	const unsigned int *last = Sim_Function("Skip_last");
+
+	return (total && last) ? *total + ((*last - ESICNT2) & 0xFFFF) : 0;
+}
+
+// Volumes of the firmware totalizer in sensor states, as Tot_Forward() and
+// Tot_Net() compute them; 0 if the firmware has none.
+static int Totalizer(unsigned long *forward, long *net)
+{
+	const unsigned long *fwd_base = Sim_Function("Tot_fwd_base");
+	const long *net_base = Sim_Function("Tot_net_base");
+	const unsigned int *net_last = Sim_Function("Tot_net_last");
+
+	if (!fwd_base || !net_base || !net_last)
+		return 0;
+	*forward = *fwd_base + ESICNT0 - Skips();
+	if ((ESIINT2 & ESIIFG7) && (ESICNT0 < 0x8000))
+		*forward += 0x10000;
+	*net = *net_base + (short)(ESICNT1 - *net_last);
+	return 1;
+}
+
+// Non-empty bins of the firmware flow rate histogram Flow_Hist, the copy Flow_copy of
+// two: a version and a sequence number followed by the counts per octave of the rotation
+// period, as the lowest rate of the bin, and a CRC.
+static void Flow_Histogram(void)
+{
+	size_t size;
+	const unsigned char *hist = Sim_Variable("Flow_Hist", &size);
+	const unsigned char *copy = Sim_Function("Flow_copy");
+	const unsigned long *count;
+	unsigned int i, bins;
+
+	if (!hist || !copy)
+		return;
+	size /= 2;
+	count = (const unsigned long *)(hist + *copy * size + 2 * sizeof(unsigned int));
+	bins = (size - 2 * sizeof(unsigned int) - sizeof(unsigned long)) / sizeof(unsigned long);
+	printf("           histogram");
+	for (i = 0; i < bins; i++)
+		if (count[i])
+			printf(" >%g rps %lu", SIM_ACLK_HZ / (512 << i), count[i]);
+	printf("\n");
+}
+
+// Skip_Log of the firmware, the same layout on the host, the CRC after the entries
+typedef struct
+{
+	unsigned int  Version, Sequence;
+	unsigned char Next, Entries;
+	unsigned long Total;
+	struct { unsigned long Time; long Net; unsigned char Level, Skips; } Entry[];
+} Fw_Skip_Log;
+
+// Jumps over a sensor state of this run and the last entries of the firmware log,
+// the copy Skip_saved_copy of two.
+static void Skip_Report(void)
+{
+	size_t size;
+	const unsigned char *logs = Sim_Variable("Skip_Log", &size);
+	const unsigned char *copy = Sim_Function("Skip_saved_copy");
+	const Fw_Skip_Log *log;
+	unsigned int slots, i;
+
+	printf("Skip       %lu jumps over a sensor state", Skips());
+	if (!logs || !copy)
+	{	printf("\n");
+		return;
+	}
+	size /= 2;
+	log = (const Fw_Skip_Log *)(logs + *copy * size);
+	printf(", %lu over all runs\n", log->Total);
+	slots = (size - sizeof(*log) - sizeof(unsigned long)) / sizeof(log->Entry[0]);
+	for (i = 0; (i < log->Entries) && (i < 4); i++)
+	{
+		unsigned int n = (log->Next + 2 * slots - 1 - i) % slots;
+
+		printf("           at %.3f s of TA2, net %ld states, rate level %u, %u jumps\n",
+		       log->Entry[n].Time / SIM_ACLK_HZ, log->Entry[n].Net, log->Entry[n].Level, log->Entry[n].Skips);
+	}
+}
+
+// Event scheduler of Task.c: runs, late runs and the longest wait per task
+static void Task_Report(void)
+{
+	static const char *const Name[] = { "demo", "recal", "temp", "osc", "display", "sample", "save" };
+	const unsigned int *runs = Sim_Function("Task_Runs");
+	const unsigned int *late = Sim_Function("Task_Late");
+	const unsigned int *wait = Sim_Function("Task_Wait");
+	const unsigned char *lost = Sim_Function("Task_Lost");
+	unsigned int i;
+
+	if (!runs || !late || !wait || !lost)
+		return;
+	printf("Tasks     ");
+	for (i = 0; i < sizeof(Name) / sizeof(Name[0]); i++)
+		if (runs[i])
+			printf(" %s %u (%u late, wait %.2f ms)", Name[i], runs[i], late[i], wait[i] * 1e3 / SIM_ACLK_HZ);
+	printf(", %u events lost\n", *lost);
+}
+
+// Trace_Log of the firmware, the same layout on the host
+typedef struct
+{
+	unsigned long Count;
+	struct { unsigned char Isr, Late; unsigned int Entry, Exit; } Record[];
+} Fw_Trace_Log;
+
+// Records of the ISR trace and the cycles of Trace_In() and Trace_Out().
+static void Trace_Report(const Sim_Counters *c)
+{
+	size_t size;
+	const Fw_Trace_Log *log = Sim_Variable("Trace_Log", &size);
+	const Sim_Phase *in = Sim_Phase_Find("Trace_In");
+	const Sim_Phase *out = Sim_Phase_Find("Trace_Out");
+	double cycles;
+
+	if (!log || !in || !out)
+		return;
+	cycles = Sim_Cpu_Cycles(&in->Total) + Sim_Cpu_Cycles(&out->Total);
+	printf("Trace      %lu records, %.0f cycles in Trace_In() and Trace_Out(), %.1f per ISR, %.2f %% of the CPU cycles\n",
+	       log->Count, cycles, cycles / out->Calls, 100.0 * cycles / Sim_Cpu_Cycles(c));
+}
+
+// Trace_Log as TI-TXT: Count (32 bits), then Isr, Late, Entry and Exit (16 bits)
+// of every record, little endian as on the target. The address is not known
+// on the host; the dump starts at @0000.
+static int Trace_Save(const char *path)
+{
+	size_t size, n, i;
+	const Fw_Trace_Log *log = Sim_Variable("Trace_Log", &size);
+	unsigned char image[4 + 6 * MAX_TRACE];
+	FILE *f;
+
+	if (!log)
+	{	fprintf(stderr, "esisim: the firmware is built without Isr_trace\n");
+		return 0;
+	}
+	n = (size - sizeof(*log)) / sizeof(log->Record[0]);
+	if (n > MAX_TRACE)
+		n = MAX_TRACE;
+	for (i = 0; i < 4; i++)
+		image[i] = (log->Count >> (8 * i)) & 0xFF;
+	for (i = 0; i < n; i++)
+	{	unsigned char *r = &image[4 + 6 * i];
+
+		r[0] = log->Record[i].Isr;
+		r[1] = log->Record[i].Late;
+		r[2] = log->Record[i].Entry & 0xFF;
+		r[3] = (log->Record[i].Entry >> 8) & 0xFF;
+		r[4] = log->Record[i].Exit & 0xFF;
+		r[5] = (log->Record[i].Exit >> 8) & 0xFF;
+	}
+	if (!(f = fopen(path, "w")))
+	{	perror(path);
+		return 0;
+	}
+	fprintf(f, "@0000\n");
+	for (i = 0; i < 4 + 6 * n; i++)
+		fprintf(f, "%02X%c", image[i], ((i % 16) == 15) ? '\n' : ' ');
+	if ((i % 16) != 0)
+		fprintf(f, "\n");
+	fprintf(f, "q\n");
+	fclose(f);
+	return 1;
+}
+
+// Counters of the normal operation, from the return of InitScanIF() on;
+// NULL if it was not reached.
+static const Sim_Counters *Operation(Sim_Counters *c)
+{
+	Sim_Counters now;
+
+	if (!Operation_Started)
+		return NULL;
+	Sim_Snapshot(&now);
+	Sim_Counters_Sub(c, &now, &Operation_Start);
+	return c;
+}
+
+static int By_Time(const void *a, const void *b)
+{
+	double ta = (*(const Sim_Phase * const *)a)->Total.Time;
+	double tb = (*(const Sim_Phase * const *)b)->Total.Time;
+
+	return (ta < tb) - (ta > tb);
+}
+
+static void Report(int all)
+{
+	const unsigned int *loops = Sim_Function("Set_DAC_loops");
+	const unsigned int *interval = Sim_Function("Drift_interval");
+	const unsigned int *rate_switches = Sim_Function("Rate_switches");
+	const signed char *esiosc_error = Sim_Function("Esiosc_error");
+	const unsigned int *osc_moves = Sim_Function("Osc_moves");
+	const unsigned int *osc_updates = Sim_Function("Osc_TSM_updates");
+	const unsigned long *flow_period = Sim_Function("Flow_period");
+	const unsigned long *flow_average = Sim_Function("Flow_average");   // x 8, Flow_shift
+	const unsigned long *flow_peak = Sim_Function("Flow_peak");
+	Sim_TSM_Sample sample[32];              // ESITSM0..31
+	Sim_Counters c, op;
+	unsigned long forward, transactions, iic_interrupts;
+	long net;
+	double t_end;
+	unsigned int i;
+	int n;
+
+	Sim_Snapshot(&c);
+	printf("stopped: %s at %.6f s\n\n", Sim_Stop_Reason ? Sim_Stop_Reason : "-", Sim_Time);
+	printf("%-22s %6s %10s %10s %9s %8s %9s %12s %10s\n",
+	       "phase", "calls", "time[ms]", "ACLK", "TSM seq", "wakeups", "LPM0[ms]", "CPU cycles", "charge[uC]");
+
+	if (all)
+	{
+		int n = Sim_Phase_Count(), j;
+		const Sim_Phase **list = malloc(n * sizeof(*list));
+
+		for (j = 0; j < n; j++)
+			list[j] = Sim_Phase_Get(j);
+		qsort(list, n, sizeof(*list), By_Time);
+		for (j = 0; j < n; j++)
+			Print_Phase(list[j]);
+		free(list);
+	}
+	else
+	{
+		for (i = 0; i < PHASES; i++)
+		{
+			const Sim_Phase *p = Sim_Phase_Find(Phase_Name[i]);
+
+			if (p)
+				Print_Phase(p);
+		}
+	}
+
+	printf("\n%-22s %6s %10.3f %10llu %9llu %8llu %9.3f %12.0f %10.3f\n", "total", "",
+	       c.Time * 1e3, Sim_Aclk_Ticks(&c), c.Tsm_Sequences, c.Wakeups, c.Lpm0_Time * 1e3,
+	       Sim_Cpu_Cycles(&c), Sim_Charge(&c) * 1e6);
+	if (Operation(&op))
+		printf("%-22s %6s %10.3f %10llu %9llu %8llu %9.3f %12.0f %10.3f\n", "operation", "",
+		       op.Time * 1e3, Sim_Aclk_Ticks(&op), op.Tsm_Sequences, op.Wakeups, op.Lpm0_Time * 1e3,
+		       Sim_Cpu_Cycles(&op), Sim_Charge(&op) * 1e6);
+	printf("interrupts %llu, ISR overhead %llu cycles, delay %llu cycles, ESICNT3 polling %llu cycles,"
+	       " SMCLK for I2C in LPM3 %.3f ms\n",
+	       c.Interrupts, c.Isr_Cycles, c.Delay_Cycles, c.Stall_Cycles, c.Request_Time * 1e3);
+	if (Operation(&op) && op.Lpm_Exits)
+		printf("wakes      %llu LPM exits in operation, %.0f cycles up to the next LPM entry, %.0f each\n",
+		       op.Lpm_Exits, op.Wake_Cycles, op.Wake_Cycles / op.Lpm_Exits);
+	printf("\n");
+
+	printf("ESIOSC     ESICLKFQ 0x%02X, %.3f MHz", (ESIOSC >> 8) & 0x3F, Sim_Esiosc_Hz() / 1e6);
+	if (esiosc_error)
+		printf(", EsioscInit error %d cycles per ACLK period", *esiosc_error);
+	printf("\n");
+	if (osc_moves && osc_updates)
+		printf("           background re-calibration: %u ESICLKFQ changes, %u delay chains rescaled\n",
+		       *osc_moves, *osc_updates);
+	n = Sim_TSM_Schedule(Sim_Time, sample, 32, &t_end);
+	printf("TSM        latch");
+	for (i = 0; i < (unsigned int)n; i++)
+		printf(" %.2f", sample[i].Start * 1e6);
+	printf(" us after the LC release\n");
+	printf("ESIDAC1R   %u %u %u %u %u %u\n", ESIDAC1R0, ESIDAC1R1, ESIDAC1R2, ESIDAC1R3, ESIDAC1R4, ESIDAC1R5);
+	if (loops)
+		printf("Set_DAC    %u iterations after the separation, %d saved against the 1 s tail\n",
+		       *loops, 468 - (int)*loops);
+	if (interval)
+		printf("Drift      probe every %u Q6 events\n", *interval);
+	if (rate_switches)
+		printf("Rate       TSM every %u ACLK (%.0f Hz), %u rate switches\n", Tsm_Period(),
+		       SIM_ACLK_HZ / Tsm_Period(), *rate_switches);
+	if (Totalizer(&forward, &net))
+		printf("Totalizer  forward %lu, reverse %lu states, net %.2f revolutions\n",
+		       forward, forward - net, (double)net / (2 * SIM_CHANNELS));
+	if (flow_period && flow_average && flow_peak)
+	{
+		printf("Flow       last rotation %lu ACLK (%.2f rps), average %.2f rps, peak %.2f rps\n", *flow_period,
+		       *flow_period ? SIM_ACLK_HZ / *flow_period : 0.0,
+		       (*flow_average >> 3) ? SIM_ACLK_HZ / (*flow_average >> 3) : 0.0,
+		       *flow_peak ? SIM_ACLK_HZ / *flow_peak : 0.0);
+		Flow_Histogram();
+	}
+	if (Sim_Function("Skip_total"))
+		Skip_Report();
+	Task_Report();
+	Trace_Report(&c);
+	Sim_IIC_Stats(&transactions, &iic_interrupts);
+	if (transactions)
+		printf("I2C        %lu transactions, %lu eUSCI_B0 interrupts (%.2f per transaction), DMA %llu cycles\n",
+		       transactions, iic_interrupts, (double)iic_interrupts / transactions, c.Dma_Cycles);
+	printf("LCD        lower %ld, upper %ld\n", Sim_LCD_Number(0), Sim_LCD_Number(1));
+	if (Motor_Rps > 0)
+	{	printf("Demo       %d of 1000 rotations, ESI / motor board count:", Demo_Num);
+		for (i = 0; i < (unsigned int)Demo_Num; i++)
+			printf(" %ld/%ld", Demo[i].Esi, Demo[i].Motor);
+		printf("\n           motor board count %lu, %lu commands 0x2F\n", Sim_Motor_Count(),
+		       Sim_Motor_Commands(0x2F));
+	}
+	printf("rotor      %.2f rps, %.2f revolutions since ESI enable, ESICNT1 %d\n",
+	       Sim_Rotor_Speed(), Sim_Rotor_Revolutions() - Esien_Revolutions, (short)ESICNT1);
+	if (First_Count >= 0)
+		printf("first count %.3f s after reset\n", First_Count);
+	else
+		printf("first count -\n");
+}
+
+static void Report_Meter(int meter, int counting)
+{
+	const Sim_Phase *init = Sim_Phase_Find("InitScanIF");
+	size_t size = 0;
+	const unsigned int *noise = Sim_Variable("Noise_level", &size);    // one per channel or a common one
+	const unsigned int *loops = Sim_Function("Set_DAC_loops");
+	unsigned int noise_max = 0;
+	int i;
+
+	for (i = 0; noise && (i < (int)(size / sizeof(unsigned int))); i++)
+		if (noise[i] > noise_max)
+			noise_max = noise[i];
+	printf("%5d %-20s %9.3f %9.3f %6u %5u", meter, Sim_Stop_Reason ? Sim_Stop_Reason : "-", Sim_Time,
+	       init ? init->Total.Time * 1e3 : 0.0, noise_max, loops ? *loops : 0);
+	for (i = 0; i < SIM_CHANNELS; i++)
+		printf(" %5u", SIM_REG16(0x0D40 + 4 * i));
+	if (Motor_Rps > 0)                      // largest ESI - motor board count of the demonstrations
+		printf(" %7ld\n", Demo_Error());
+	else if (counting)                      // LCD count error of the demo when drawn [revolutions]
+		printf(" %7.2f\n", Lcd_Count - Lcd_Revolutions);
+	else
+		printf(" %7s\n", "-");
+}
+
+
+//--------------------------------------------------------------------------
+//---  LCD benchmark
+//---
+
+static const char *Lcd_Phase[] = { "lcd_display_num" };
+
+// lcd_display_num() for every number of 0..99999 on every line: counting up,
+// scattered (most digits change) and repeated (the number is on the line),
+// CPU cycles per call and numbers not read back from the glass.
+static int Lcd_Bench(void)
+{
+	static const char *line_name[] = { "lower", "upper", "both" };
+	static const char *order_name[] = { "counting", "scattered", "repeated" };
+	static const unsigned long modulo[] = { 100000, 10000, 100000000 };
+	void (*init)(void) = (void (*)(void))Sim_Function("init_LCD");
+	void (*show)(unsigned long, unsigned char) = (void (*)(unsigned long, unsigned char))Sim_Function("lcd_display_num");
+	Sim_Counters a, b, d;
+	long errors = 0;
+	int line, order;
+
+	if (!init || !show)
+	{	fprintf(stderr, "esisim: no firmware function init_LCD or lcd_display_num\n");
+		return 0;
+	}
+	Sim_Reset(1);
+	Sim_Time_Limit = SIM_INFINITY;          // the CPU time of the calls
+	if (setjmp(Sim_Stop_Jmp) != 0)
+	{	fprintf(stderr, "esisim: %s\n", Sim_Stop_Reason);
+		return 0;
+	}
+	init();
+	printf("%-6s %-10s %8s %8s %8s %7s   lcd_display_num(0..%d), CPU cycles per call\n", "line", "order",
+	       "min", "avg", "max", "errors", LCD_BENCH_RANGE - 1);
+	for (line = SIM_LCD_LOWER; line <= SIM_LCD_BOTH; line++)
+		for (order = 0; order < 3; order++)
+		{
+			double min = SIM_INFINITY, max = 0, sum = 0, c;
+			long wrong = 0;
+			unsigned long i, n;
+
+			for (i = 0; i < LCD_BENCH_RANGE; i++)
+			{
+				n = (order == 1) ? (i * 7919) % LCD_BENCH_RANGE : i;
+				if (order == 2)
+					show(n, line);
+				Sim_Snapshot(&a);
+				show(n, line);
+				Sim_Snapshot(&b);
+				Sim_Counters_Sub(&d, &b, &a);
+				c = Sim_Cpu_Cycles(&d);
+				sum += c;
+				min = (c < min) ? c : min;
+				max = (c > max) ? c : max;
+				wrong += Sim_LCD_Number(line) != (long)(n % modulo[line]);
+			}
+			printf("%-6s %-10s %8.0f %8.1f %8.0f %7ld\n", line_name[line], order_name[order], min,
+			       sum / LCD_BENCH_RANGE, max, wrong);
+			errors += wrong;
+		}
+	Sim_Bench_Collect(Lcd_Phase, 1, NULL);
+	return errors == 0;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Main
+//---
+
+static void Usage(void)
+{
+	fprintf(stderr,
+		"usage: esisim [options]\n"
+		"  -t SEC     stop after SEC seconds of simulated time (default 60)\n"
+		"  -u FUNC    stop when firmware function FUNC returns (e.g. InitScanIF)\n"
+		"  -r RPS     rotor speed set by the operator after \"8888\" (default 45)\n"
+		"  -b SEC     press the P1.2 key at SEC seconds\n"
+		"  -c CYCLES  MSP430 cycles per firmware basic block (default 10)\n"
+		"  -s SEED    random seed (default 1)\n"
+		"  -a         report all firmware functions\n"
+		"  -P N=V     set a sensor or part parameter (-P list to list them)\n"
+		"  -n METERS  run METERS virtual meters, one report line each\n"
+		"  -v SPREAD  relative part-to-part sigma of the LC gain and Q (default 0)\n"
+		"  -R FILE    replay a rotor speed profile (\"time rps\" lines) from the rotor start\n"
+		"  -M RPS     2-LC motor board on the I2C bus, RPS at its full speed: the firmware drives\n"
+		"             the rotor, exit status 1 if a demo's two counts differ by more than 1\n"
+		"  -j FILE    write the phase statistics as JSON (median over the meters with -n)\n"
+		"  -B FILE    check the phase statistics against thresholds, exit status 1 if exceeded\n"
+		"  -F FILE    keep the INFO FRAM variables in an image file over runs (not with -n)\n"
+		"  -T FILE    write the ISR trace of an Isr_trace build as TI-TXT for tracedec (not with -n)\n"
+		"  -L         LCD benchmark: lcd_display_num() for 0..99999 on every line, no meter run\n");
+	exit(2);
+}
+
+static void Run(unsigned long long seed, const char **param, int params, double spread, double key, const void *until,
+                const char *fram)
+{
+	int i;
+
+	Sim_Reset(seed);
+	Sim_Sensor_Layout(SIM_CHANNELS);
+	for (i = 0; i < params; i++)
+		Sim_Param(param[i]);
+	if (spread > 0)
+		Sim_Sensor_Randomize(spread);
+	Sim_Add_Module(&Operator_Module);
+	if (Motor_Rps > 0)
+	{	Sim_Motor_Rps = Motor_Rps;
+		Sim_Motor_Reset();
+		Sim_IIC_Bus = &Sim_Motor_Board;
+	}
+	if (fram && Fram_Load(fram))            // reset in the field, the rotor keeps turning
+	{	Rotor_Started = 1;
+		Rotor_Start = 0;
+		if ((Profile_Num == 0) && (Motor_Rps == 0))
+			Sim_Rotor_Set_Speed(Operator_Rps);
+	}
+	if (key >= 0)
+		Sim_Port_Press(key);
+	Sim_Stop_After = until;
+
+	if (setjmp(Sim_Stop_Jmp) == 0)
+	{	fw_main();
+		Sim_Stop_Reason = "main returned";
+	}
+	Sim_Phase_Close_All();
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long long seed = 1;
+	const char *until = NULL;
+	const void *until_fn = NULL;
+	const char *param[MAX_PARAMS];
+	const char *json = NULL, *thresholds = NULL, *fram = NULL, *trace = NULL;
+	Sim_Counters op;
+	double key = -1, spread = 0;
+	int all = 0, params = 0, meters = 0, lcd = 0, failed = 0, opt, m;
+
+	while ((opt = getopt(argc, argv, "t:u:r:b:c:s:aP:n:v:R:M:j:B:F:T:L")) != -1)
+	{
+		switch (opt)
+		{
+		case 't': Sim_Time_Limit = atof(optarg); break;
+		case 'u': until = optarg; break;
+		case 'r': Operator_Rps = atof(optarg); break;
+		case 'b': key = atof(optarg); break;
+		case 'c': Sim_Cycles_Per_Block = atof(optarg); break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		case 'a': all = 1; break;
+		case 'n': meters = atoi(optarg); break;
+		case 'v': spread = atof(optarg); break;
+		case 'R': if (!Load_Profile(optarg)) return 2; break;
+		case 'M': Motor_Rps = atof(optarg); break;
+		case 'j': json = optarg; break;
+		case 'B': thresholds = optarg; break;
+		case 'F': fram = optarg; break;
+		case 'T': trace = optarg; break;
+		case 'L': lcd = 1; break;
+		case 'P':
+			if (strcmp(optarg, "list") == 0)
+			{	Sim_Params(stdout);
+				return 0;
+			}
+			if ((params == MAX_PARAMS) || !Sim_Param(optarg))
+			{	fprintf(stderr, "esisim: unknown parameter %s\n", optarg);
+				return 2;
+			}
+			param[params++] = optarg;
+			break;
+		default:  Usage();
+		}
+	}
+
+	if (((fram || trace) && meters) || ((Motor_Rps > 0) && Profile_Num))
+		Usage();
+#if SIM_CHANNELS == 3
+	if (Motor_Rps > 0)
+	{	fprintf(stderr, "esisim: the 3-LC firmware has no motor board\n");
+		return 2;
+	}
+#endif
+	if (until)
+	{	until_fn = Sim_Function(until);
+		if (!until_fn)
+		{	fprintf(stderr, "esisim: no firmware function %s\n", until);
+			return 2;
+		}
+	}
+
+	if (lcd)
+	{	if (!Lcd_Bench())
+			return 1;
+	}
+	else if (meters == 0)
+	{	Run(seed, param, params, spread, key, until_fn, fram);
+		if (fram && !Fram_Save(fram))
+			return 2;
+		if (trace && !Trace_Save(trace))
+			return 2;
+		Report(all);
+		Sim_Bench_Collect(Phase_Name, PHASES, Operation(&op));
+		failed = (Motor_Rps > 0) && ((Demo_Error() < 0) || (Demo_Error() > 1));
+	}
+	else
+	{
+		printf("%5s %-20s %9s %9s %6s %5s %*s %7s\n", "meter", "stopped", "time[s]", "init[ms]", "noise", "tail",
+		       6 * SIM_CHANNELS - 1, "DAC", (Motor_Rps > 0) ? "demo" : "LCD err");
+		fflush(stdout);
+		for (m = 0; m < meters; m++)
+		{
+			int fd[2];
+			pid_t pid;
+			int status;
+
+			if ((pipe(fd) < 0) || ((pid = fork()) < 0))
+			{	perror("esisim");
+				return 1;
+			}
+			if (pid == 0)
+			{	close(fd[0]);
+				Run(seed + m, param, params, spread, key, until_fn, NULL);
+				Report_Meter(m, until_fn == NULL);
+				fflush(stdout);
+				Sim_Bench_Collect(Phase_Name, PHASES, Operation(&op));
+				Sim_Bench_Write(fd[1]);
+				_exit((Motor_Rps > 0) && ((Demo_Error() < 0) || (Demo_Error() > 1)));
+			}
+			close(fd[1]);
+			Sim_Bench_Read(fd[0], Phase_Name, PHASES);
+			close(fd[0]);
+			waitpid(pid, &status, 0);
+			if (Motor_Rps > 0)
+				failed |= !WIFEXITED(status) || WEXITSTATUS(status);
+		}
+	}
+
+	if (json && !Sim_Bench_Json(json, SIM_FW, seed))
+		return 2;
+	if (thresholds)
+	{	int exceeded;
+
+		printf("\n");
+		exceeded = Sim_Bench_Check(thresholds);
+		if (exceeded)
+			return (exceeded < 0) ? 2 : 1;
+	}
+	return failed;
+}
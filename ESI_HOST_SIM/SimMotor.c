@@ -0,0 +1,105 @@
+/* SimMotor.c
+ *
+ * Motor board of the 2-LC demo (MSP430G2553) as the I2C slave at address 0x02
+ * on Sim_IIC_Bus. A byte written to it is a command: the high nibble is the
+ * direction (0 stop, 1 anti-clockwise, 2 clockwise, 3 reset the rotation
+ * counter), the low nibble the speed, 0..15 of Sim_Motor_Rps. Clockwise is the
+ * forward direction of the rotor model. A read returns the 32-bit rotation
+ * counter, low byte first, and the last command as the status byte: the passes
+ * of the disc at the infra-red detector, which is half a revolution away from
+ * angle 0, in either direction. A reader of 2 bytes gets the 16-bit counter.
+ */
+
+#include <math.h>
+#include "Sim.h"
+
+#define MOTOR_ADDRESS   0x02
+#define DETECTOR        0.5                 // angle of the infra-red detector [rev]
+
+double Sim_Motor_Rps = 47.0;
+
+static unsigned long Count;                 // rotation counter
+static double        Count_Angle;           // rotor angle at the last update of Count
+static unsigned char Status;                // last command
+static unsigned char Reply[5];
+static int           Reply_Index;
+static unsigned long Commands[256];
+
+
+// Counts the detector passes since the last update; the rotor does not turn
+// back in between, as it only changes its direction on a command.
+static void Count_Update(void)
+{
+	double angle = Sim_Rotor_Revolutions();
+
+	Count += (unsigned long)fabs(floor(angle - DETECTOR) - floor(Count_Angle - DETECTOR));
+	Count_Angle = angle;
+}
+
+static int Motor_Start(unsigned char address, int read)
+{
+	if (address != MOTOR_ADDRESS)
+		return 0;
+	if (read)
+	{	Count_Update();
+		Reply[0] = Count & 0xFF;
+		Reply[1] = (Count >> 8) & 0xFF;
+		Reply[2] = (Count >> 16) & 0xFF;
+		Reply[3] = (Count >> 24) & 0xFF;
+		Reply[4] = Status;
+		Reply_Index = 0;
+	}
+	return 1;
+}
+
+static int Motor_Write(unsigned char command)
+{
+	double rps = Sim_Motor_Rps * (command & 0x0F) / 15;
+
+	Count_Update();
+	Commands[command]++;
+	Status = command;
+	switch (command >> 4)
+	{
+	case 0:  Sim_Rotor_Set_Speed(0); break;
+	case 1:  Sim_Rotor_Set_Speed(-rps); break;
+	case 2:  Sim_Rotor_Set_Speed(rps); break;
+	case 3:  Count = 0; break;
+	default: break;
+	}
+	return 1;
+}
+
+static unsigned char Motor_Read(void)
+{
+	return (Reply_Index < (int)sizeof(Reply)) ? Reply[Reply_Index++] : 0xFF;
+}
+
+static void Motor_Stop(void)
+{
+}
+
+const Sim_IIC_Slave Sim_Motor_Board = { Motor_Start, Motor_Write, Motor_Read, Motor_Stop };
+
+void Sim_Motor_Reset(void)
+{
+	unsigned int i;
+
+	Count = 0;
+	Count_Angle = Sim_Rotor_Revolutions();
+	Status = 0;
+	Reply_Index = sizeof(Reply);
+	for (i = 0; i < 256; i++)
+		Commands[i] = 0;
+}
+
+unsigned long Sim_Motor_Count(void)
+{
+	Count_Update();
+	return Count & 0xFFFFFFFF;
+}
+
+unsigned long Sim_Motor_Commands(unsigned char command)
+{
+	return Commands[command];
+}
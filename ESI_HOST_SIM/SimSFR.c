@@ -0,0 +1,484 @@
+/* SimSFR.c
+ *
+ * Peripheral file of the simulated MSP430FR6989.
+ *
+ * The firmware accesses the registers through the extern declarations of the
+ * device header (SFR_8BIT / SFR_16BIT). On the target the linker command file
+ * resolves these symbols to absolute addresses; here every symbol is defined as
+ * an alias into Sim_Periph[], at the offset of the real register. Byte access
+ * symbols (_L / _H) alias the same storage, and registers like ESIRAMx keep the
+ * contiguous layout the firmware relies on (InitScanIF walks &ESIRAM0).
+ *
+ * Only the modules used by the firmware are listed. A register missing here
+ * shows up as an undefined symbol at link time.
+ *
+ * Sim_Periph is aligned to 64 KB, so the low 16 bits of a register's host
+ * address are its address on the target: __data16_write_addr((unsigned short)
+ * &DMA0SA, ...) finds the register (SimDMA.c).
+ */
+
+volatile unsigned char Sim_Periph[0x1000] __attribute__((aligned(0x10000))) = { 0 };
+
+#define SFR8(name, addr)	__asm__(".globl " #name "\n\t.set " #name ", Sim_Periph+" #addr);
+#define SFR16(name, addr)	SFR8(name, addr) SFR8(name##_L, addr) SFR8(name##_H, addr+1)
+
+//---- SFR, PMM, FRAM, WDT, CS, SYS, REF_A
+SFR16(SFRIE1, 0x0100)
+SFR16(SFRIFG1, 0x0102)
+SFR16(SFRRPCR, 0x0104)
+SFR16(PMMCTL0, 0x0120)
+SFR16(PMMIFG, 0x012A)
+SFR16(PM5CTL0, 0x0130)
+SFR16(FRCTL0, 0x0140)
+SFR16(GCCTL0, 0x0144)
+SFR16(GCCTL1, 0x0146)
+SFR16(RCCTL0, 0x0158)
+SFR16(WDTCTL, 0x015C)
+SFR16(CSCTL0, 0x0160)
+SFR16(CSCTL1, 0x0162)
+SFR16(CSCTL2, 0x0164)
+SFR16(CSCTL3, 0x0166)
+SFR16(CSCTL4, 0x0168)
+SFR16(CSCTL5, 0x016A)
+SFR16(CSCTL6, 0x016C)
+SFR16(SYSCTL, 0x0180)
+SFR16(SYSJMBC, 0x0186)
+SFR16(SYSUNIV, 0x019A)
+SFR16(SYSSNIV, 0x019C)
+SFR16(SYSRSTIV, 0x019E)
+SFR16(REFCTL0, 0x01B0)
+
+//---- Ports
+SFR16(PAIN, 0x0200)
+SFR16(PAOUT, 0x0202)
+SFR16(PADIR, 0x0204)
+SFR16(PAREN, 0x0206)
+SFR16(PASEL0, 0x020A)
+SFR16(PASEL1, 0x020C)
+SFR16(PASELC, 0x0216)
+SFR16(P1IV, 0x020E)
+SFR16(PAIES, 0x0218)
+SFR16(PAIE, 0x021A)
+SFR16(PAIFG, 0x021C)
+SFR16(P2IV, 0x021E)
+SFR16(PBIN, 0x0220)
+SFR16(PBOUT, 0x0222)
+SFR16(PBDIR, 0x0224)
+SFR16(PBREN, 0x0226)
+SFR16(PBSEL0, 0x022A)
+SFR16(PBSEL1, 0x022C)
+SFR16(PBSELC, 0x0236)
+SFR16(P3IV, 0x022E)
+SFR16(PBIES, 0x0238)
+SFR16(PBIE, 0x023A)
+SFR16(PBIFG, 0x023C)
+SFR16(P4IV, 0x023E)
+SFR16(PCIN, 0x0240)
+SFR16(PCOUT, 0x0242)
+SFR16(PCDIR, 0x0244)
+SFR16(PCREN, 0x0246)
+SFR16(PCSEL0, 0x024A)
+SFR16(PCSEL1, 0x024C)
+SFR16(PCSELC, 0x0256)
+SFR16(PDIN, 0x0260)
+SFR16(PDOUT, 0x0262)
+SFR16(PDDIR, 0x0264)
+SFR16(PDREN, 0x0266)
+SFR16(PDSEL0, 0x026A)
+SFR16(PDSEL1, 0x026C)
+SFR16(PDSELC, 0x0276)
+SFR16(PEIN, 0x0280)
+SFR16(PEOUT, 0x0282)
+SFR16(PEDIR, 0x0284)
+SFR16(PEREN, 0x0286)
+SFR16(PESEL0, 0x028A)
+SFR16(PESEL1, 0x028C)
+SFR16(PESELC, 0x0296)
+SFR16(PJIN, 0x0320)
+SFR16(PJOUT, 0x0322)
+SFR16(PJDIR, 0x0324)
+SFR16(PJREN, 0x0326)
+SFR16(PJSEL0, 0x032A)
+SFR16(PJSEL1, 0x032C)
+SFR16(PJSELC, 0x0336)
+
+//---- DMA
+SFR16(DMACTL0, 0x0500)
+SFR16(DMACTL1, 0x0502)
+SFR16(DMACTL2, 0x0504)
+SFR16(DMACTL3, 0x0506)
+SFR16(DMACTL4, 0x0508)
+SFR16(DMAIV, 0x050E)
+SFR16(DMA0CTL, 0x0510)
+SFR8(DMA0SA, 0x0512)
+SFR8(DMA0SAL, 0x0512)
+SFR8(DMA0SAH, 0x0514)
+SFR8(DMA0DA, 0x0516)
+SFR8(DMA0DAL, 0x0516)
+SFR8(DMA0DAH, 0x0518)
+SFR16(DMA0SZ, 0x051A)
+SFR16(DMA1CTL, 0x0520)
+SFR8(DMA1SA, 0x0522)
+SFR8(DMA1SAL, 0x0522)
+SFR8(DMA1SAH, 0x0524)
+SFR8(DMA1DA, 0x0526)
+SFR8(DMA1DAL, 0x0526)
+SFR8(DMA1DAH, 0x0528)
+SFR16(DMA1SZ, 0x052A)
+SFR16(DMA2CTL, 0x0530)
+SFR8(DMA2SA, 0x0532)
+SFR8(DMA2SAL, 0x0532)
+SFR8(DMA2SAH, 0x0534)
+SFR8(DMA2DA, 0x0536)
+SFR8(DMA2DAL, 0x0536)
+SFR8(DMA2DAH, 0x0538)
+SFR16(DMA2SZ, 0x053A)
+
+//---- Timer0_A3
+SFR16(TA0CTL, 0x0340)
+SFR16(TA0CCTL0, 0x0342)
+SFR16(TA0CCTL1, 0x0344)
+SFR16(TA0CCTL2, 0x0346)
+SFR16(TA0R, 0x0350)
+SFR16(TA0CCR0, 0x0352)
+SFR16(TA0CCR1, 0x0354)
+SFR16(TA0CCR2, 0x0356)
+SFR16(TA0EX0, 0x0360)
+SFR16(TA0IV, 0x036E)
+
+//---- Timer1_A3
+SFR16(TA1CTL, 0x0380)
+SFR16(TA1CCTL0, 0x0382)
+SFR16(TA1CCTL1, 0x0384)
+SFR16(TA1CCTL2, 0x0386)
+SFR16(TA1R, 0x0390)
+SFR16(TA1CCR0, 0x0392)
+SFR16(TA1CCR1, 0x0394)
+SFR16(TA1CCR2, 0x0396)
+SFR16(TA1EX0, 0x03A0)
+SFR16(TA1IV, 0x03AE)
+
+//---- Timer2_A2
+SFR16(TA2CTL, 0x0400)
+SFR16(TA2CCTL0, 0x0402)
+SFR16(TA2CCTL1, 0x0404)
+SFR16(TA2R, 0x0410)
+SFR16(TA2CCR0, 0x0412)
+SFR16(TA2CCR1, 0x0414)
+SFR16(TA2EX0, 0x0420)
+SFR16(TA2IV, 0x042E)
+
+//---- Timer3_A5
+SFR16(TA3CTL, 0x0440)
+SFR16(TA3CCTL0, 0x0442)
+SFR16(TA3CCTL1, 0x0444)
+SFR16(TA3CCTL2, 0x0446)
+SFR16(TA3CCTL3, 0x0448)
+SFR16(TA3CCTL4, 0x044A)
+SFR16(TA3R, 0x0450)
+SFR16(TA3CCR0, 0x0452)
+SFR16(TA3CCR1, 0x0454)
+SFR16(TA3CCR2, 0x0456)
+SFR16(TA3CCR3, 0x0458)
+SFR16(TA3CCR4, 0x045A)
+SFR16(TA3EX0, 0x0460)
+SFR16(TA3IV, 0x046E)
+
+//---- eUSCI_B0
+SFR16(UCB0CTLW0, 0x0640)
+SFR16(UCB0CTLW1, 0x0642)
+SFR16(UCB0BRW, 0x0646)
+SFR16(UCB0STATW, 0x0648)
+SFR16(UCB0TBCNT, 0x064A)
+SFR16(UCB0RXBUF, 0x064C)
+SFR16(UCB0TXBUF, 0x064E)
+SFR16(UCB0I2COA0, 0x0654)
+SFR16(UCB0I2COA1, 0x0656)
+SFR16(UCB0I2COA2, 0x0658)
+SFR16(UCB0I2COA3, 0x065A)
+SFR16(UCB0ADDRX, 0x065C)
+SFR16(UCB0ADDMASK, 0x065E)
+SFR16(UCB0I2CSA, 0x0660)
+SFR16(UCB0IE, 0x066A)
+SFR16(UCB0IFG, 0x066C)
+SFR16(UCB0IV, 0x066E)
+
+//---- ADC12_B
+SFR16(ADC12CTL0, 0x0800)
+SFR16(ADC12CTL1, 0x0802)
+SFR16(ADC12CTL2, 0x0804)
+SFR16(ADC12CTL3, 0x0806)
+SFR16(ADC12IFGR0, 0x080C)
+SFR16(ADC12IER0, 0x0812)
+SFR16(ADC12IV, 0x0818)
+SFR16(ADC12MCTL0, 0x0820)
+SFR16(ADC12MCTL1, 0x0822)
+SFR16(ADC12MCTL2, 0x0824)
+SFR16(ADC12MCTL3, 0x0826)
+SFR16(ADC12MEM0, 0x0860)
+SFR16(ADC12MEM1, 0x0862)
+SFR16(ADC12MEM2, 0x0864)
+SFR16(ADC12MEM3, 0x0866)
+
+//---- COMP_E
+SFR16(CECTL0, 0x08C0)
+SFR16(CECTL1, 0x08C2)
+SFR16(CECTL2, 0x08C4)
+SFR16(CECTL3, 0x08C6)
+SFR16(CEINT, 0x08CC)
+SFR16(CEIV, 0x08CE)
+
+//---- LCD_C
+SFR16(LCDCCTL0, 0x0A00)
+SFR16(LCDCCTL1, 0x0A02)
+SFR16(LCDCBLKCTL, 0x0A04)
+SFR16(LCDCMEMCTL, 0x0A06)
+SFR16(LCDCVCTL, 0x0A08)
+SFR16(LCDCPCTL0, 0x0A0A)
+SFR16(LCDCPCTL1, 0x0A0C)
+SFR16(LCDCPCTL2, 0x0A0E)
+SFR16(LCDCCPCTL, 0x0A12)
+SFR16(LCDCIV, 0x0A1E)
+SFR8(LCDM1, 0x0A20)
+SFR8(LCDM2, 0x0A21)
+SFR8(LCDM3, 0x0A22)
+SFR8(LCDM4, 0x0A23)
+SFR8(LCDM5, 0x0A24)
+SFR8(LCDM6, 0x0A25)
+SFR8(LCDM7, 0x0A26)
+SFR8(LCDM8, 0x0A27)
+SFR8(LCDM9, 0x0A28)
+SFR8(LCDM10, 0x0A29)
+SFR8(LCDM11, 0x0A2A)
+SFR8(LCDM12, 0x0A2B)
+SFR8(LCDM13, 0x0A2C)
+SFR8(LCDM14, 0x0A2D)
+SFR8(LCDM15, 0x0A2E)
+SFR8(LCDM16, 0x0A2F)
+SFR8(LCDM17, 0x0A30)
+SFR8(LCDM18, 0x0A31)
+SFR8(LCDM19, 0x0A32)
+SFR8(LCDM20, 0x0A33)
+SFR8(LCDM21, 0x0A34)
+SFR8(LCDM22, 0x0A35)
+SFR8(LCDM23, 0x0A36)
+SFR8(LCDM24, 0x0A37)
+SFR8(LCDM25, 0x0A38)
+SFR8(LCDM26, 0x0A39)
+SFR8(LCDM27, 0x0A3A)
+SFR8(LCDM28, 0x0A3B)
+SFR8(LCDM29, 0x0A3C)
+SFR8(LCDM30, 0x0A3D)
+SFR8(LCDM31, 0x0A3E)
+SFR8(LCDM32, 0x0A3F)
+SFR8(LCDM33, 0x0A40)
+SFR8(LCDM34, 0x0A41)
+SFR8(LCDM35, 0x0A42)
+SFR8(LCDM36, 0x0A43)
+SFR8(LCDM37, 0x0A44)
+SFR8(LCDM38, 0x0A45)
+SFR8(LCDM39, 0x0A46)
+SFR8(LCDM40, 0x0A47)
+SFR8(LCDM41, 0x0A48)
+SFR8(LCDM42, 0x0A49)
+SFR8(LCDM43, 0x0A4A)
+
+//---- ESI
+SFR16(ESIDEBUG1, 0x0D00)
+SFR16(ESIDEBUG2, 0x0D02)
+SFR16(ESIDEBUG3, 0x0D04)
+SFR16(ESIDEBUG4, 0x0D06)
+SFR16(ESIDEBUG5, 0x0D08)
+SFR16(ESICNT0, 0x0D10)
+SFR16(ESICNT1, 0x0D12)
+SFR16(ESICNT2, 0x0D14)
+SFR16(ESICNT3, 0x0D16)
+SFR16(ESIIV, 0x0D1A)
+SFR16(ESIINT1, 0x0D1C)
+SFR16(ESIINT2, 0x0D1E)
+SFR16(ESIAFE, 0x0D20)
+SFR16(ESIPPU, 0x0D22)
+SFR16(ESITSM, 0x0D24)
+SFR16(ESIPSM, 0x0D26)
+SFR16(ESIOSC, 0x0D28)
+SFR16(ESICTL, 0x0D2A)
+SFR16(ESITHR1, 0x0D2C)
+SFR16(ESITHR2, 0x0D2E)
+SFR16(ESIDAC1R0, 0x0D40)
+SFR16(ESIDAC1R1, 0x0D42)
+SFR16(ESIDAC1R2, 0x0D44)
+SFR16(ESIDAC1R3, 0x0D46)
+SFR16(ESIDAC1R4, 0x0D48)
+SFR16(ESIDAC1R5, 0x0D4A)
+SFR16(ESIDAC1R6, 0x0D4C)
+SFR16(ESIDAC1R7, 0x0D4E)
+SFR16(ESIDAC2R0, 0x0D50)
+SFR16(ESIDAC2R1, 0x0D52)
+SFR16(ESIDAC2R2, 0x0D54)
+SFR16(ESIDAC2R3, 0x0D56)
+SFR16(ESIDAC2R4, 0x0D58)
+SFR16(ESIDAC2R5, 0x0D5A)
+SFR16(ESIDAC2R6, 0x0D5C)
+SFR16(ESIDAC2R7, 0x0D5E)
+SFR16(ESITSM0, 0x0D60)
+SFR16(ESITSM1, 0x0D62)
+SFR16(ESITSM2, 0x0D64)
+SFR16(ESITSM3, 0x0D66)
+SFR16(ESITSM4, 0x0D68)
+SFR16(ESITSM5, 0x0D6A)
+SFR16(ESITSM6, 0x0D6C)
+SFR16(ESITSM7, 0x0D6E)
+SFR16(ESITSM8, 0x0D70)
+SFR16(ESITSM9, 0x0D72)
+SFR16(ESITSM10, 0x0D74)
+SFR16(ESITSM11, 0x0D76)
+SFR16(ESITSM12, 0x0D78)
+SFR16(ESITSM13, 0x0D7A)
+SFR16(ESITSM14, 0x0D7C)
+SFR16(ESITSM15, 0x0D7E)
+SFR16(ESITSM16, 0x0D80)
+SFR16(ESITSM17, 0x0D82)
+SFR16(ESITSM18, 0x0D84)
+SFR16(ESITSM19, 0x0D86)
+SFR16(ESITSM20, 0x0D88)
+SFR16(ESITSM21, 0x0D8A)
+SFR16(ESITSM22, 0x0D8C)
+SFR16(ESITSM23, 0x0D8E)
+SFR16(ESITSM24, 0x0D90)
+SFR16(ESITSM25, 0x0D92)
+SFR16(ESITSM26, 0x0D94)
+SFR16(ESITSM27, 0x0D96)
+SFR16(ESITSM28, 0x0D98)
+SFR16(ESITSM29, 0x0D9A)
+SFR16(ESITSM30, 0x0D9C)
+SFR16(ESITSM31, 0x0D9E)
+
+//---- ESI RAM (PSM state table)
+SFR8(ESIRAM0, 0x0E00)
+SFR8(ESIRAM1, 0x0E01)
+SFR8(ESIRAM2, 0x0E02)
+SFR8(ESIRAM3, 0x0E03)
+SFR8(ESIRAM4, 0x0E04)
+SFR8(ESIRAM5, 0x0E05)
+SFR8(ESIRAM6, 0x0E06)
+SFR8(ESIRAM7, 0x0E07)
+SFR8(ESIRAM8, 0x0E08)
+SFR8(ESIRAM9, 0x0E09)
+SFR8(ESIRAM10, 0x0E0A)
+SFR8(ESIRAM11, 0x0E0B)
+SFR8(ESIRAM12, 0x0E0C)
+SFR8(ESIRAM13, 0x0E0D)
+SFR8(ESIRAM14, 0x0E0E)
+SFR8(ESIRAM15, 0x0E0F)
+SFR8(ESIRAM16, 0x0E10)
+SFR8(ESIRAM17, 0x0E11)
+SFR8(ESIRAM18, 0x0E12)
+SFR8(ESIRAM19, 0x0E13)
+SFR8(ESIRAM20, 0x0E14)
+SFR8(ESIRAM21, 0x0E15)
+SFR8(ESIRAM22, 0x0E16)
+SFR8(ESIRAM23, 0x0E17)
+SFR8(ESIRAM24, 0x0E18)
+SFR8(ESIRAM25, 0x0E19)
+SFR8(ESIRAM26, 0x0E1A)
+SFR8(ESIRAM27, 0x0E1B)
+SFR8(ESIRAM28, 0x0E1C)
+SFR8(ESIRAM29, 0x0E1D)
+SFR8(ESIRAM30, 0x0E1E)
+SFR8(ESIRAM31, 0x0E1F)
+SFR8(ESIRAM32, 0x0E20)
+SFR8(ESIRAM33, 0x0E21)
+SFR8(ESIRAM34, 0x0E22)
+SFR8(ESIRAM35, 0x0E23)
+SFR8(ESIRAM36, 0x0E24)
+SFR8(ESIRAM37, 0x0E25)
+SFR8(ESIRAM38, 0x0E26)
+SFR8(ESIRAM39, 0x0E27)
+SFR8(ESIRAM40, 0x0E28)
+SFR8(ESIRAM41, 0x0E29)
+SFR8(ESIRAM42, 0x0E2A)
+SFR8(ESIRAM43, 0x0E2B)
+SFR8(ESIRAM44, 0x0E2C)
+SFR8(ESIRAM45, 0x0E2D)
+SFR8(ESIRAM46, 0x0E2E)
+SFR8(ESIRAM47, 0x0E2F)
+SFR8(ESIRAM48, 0x0E30)
+SFR8(ESIRAM49, 0x0E31)
+SFR8(ESIRAM50, 0x0E32)
+SFR8(ESIRAM51, 0x0E33)
+SFR8(ESIRAM52, 0x0E34)
+SFR8(ESIRAM53, 0x0E35)
+SFR8(ESIRAM54, 0x0E36)
+SFR8(ESIRAM55, 0x0E37)
+SFR8(ESIRAM56, 0x0E38)
+SFR8(ESIRAM57, 0x0E39)
+SFR8(ESIRAM58, 0x0E3A)
+SFR8(ESIRAM59, 0x0E3B)
+SFR8(ESIRAM60, 0x0E3C)
+SFR8(ESIRAM61, 0x0E3D)
+SFR8(ESIRAM62, 0x0E3E)
+SFR8(ESIRAM63, 0x0E3F)
+SFR8(ESIRAM64, 0x0E40)
+SFR8(ESIRAM65, 0x0E41)
+SFR8(ESIRAM66, 0x0E42)
+SFR8(ESIRAM67, 0x0E43)
+SFR8(ESIRAM68, 0x0E44)
+SFR8(ESIRAM69, 0x0E45)
+SFR8(ESIRAM70, 0x0E46)
+SFR8(ESIRAM71, 0x0E47)
+SFR8(ESIRAM72, 0x0E48)
+SFR8(ESIRAM73, 0x0E49)
+SFR8(ESIRAM74, 0x0E4A)
+SFR8(ESIRAM75, 0x0E4B)
+SFR8(ESIRAM76, 0x0E4C)
+SFR8(ESIRAM77, 0x0E4D)
+SFR8(ESIRAM78, 0x0E4E)
+SFR8(ESIRAM79, 0x0E4F)
+SFR8(ESIRAM80, 0x0E50)
+SFR8(ESIRAM81, 0x0E51)
+SFR8(ESIRAM82, 0x0E52)
+SFR8(ESIRAM83, 0x0E53)
+SFR8(ESIRAM84, 0x0E54)
+SFR8(ESIRAM85, 0x0E55)
+SFR8(ESIRAM86, 0x0E56)
+SFR8(ESIRAM87, 0x0E57)
+SFR8(ESIRAM88, 0x0E58)
+SFR8(ESIRAM89, 0x0E59)
+SFR8(ESIRAM90, 0x0E5A)
+SFR8(ESIRAM91, 0x0E5B)
+SFR8(ESIRAM92, 0x0E5C)
+SFR8(ESIRAM93, 0x0E5D)
+SFR8(ESIRAM94, 0x0E5E)
+SFR8(ESIRAM95, 0x0E5F)
+SFR8(ESIRAM96, 0x0E60)
+SFR8(ESIRAM97, 0x0E61)
+SFR8(ESIRAM98, 0x0E62)
+SFR8(ESIRAM99, 0x0E63)
+SFR8(ESIRAM100, 0x0E64)
+SFR8(ESIRAM101, 0x0E65)
+SFR8(ESIRAM102, 0x0E66)
+SFR8(ESIRAM103, 0x0E67)
+SFR8(ESIRAM104, 0x0E68)
+SFR8(ESIRAM105, 0x0E69)
+SFR8(ESIRAM106, 0x0E6A)
+SFR8(ESIRAM107, 0x0E6B)
+SFR8(ESIRAM108, 0x0E6C)
+SFR8(ESIRAM109, 0x0E6D)
+SFR8(ESIRAM110, 0x0E6E)
+SFR8(ESIRAM111, 0x0E6F)
+SFR8(ESIRAM112, 0x0E70)
+SFR8(ESIRAM113, 0x0E71)
+SFR8(ESIRAM114, 0x0E72)
+SFR8(ESIRAM115, 0x0E73)
+SFR8(ESIRAM116, 0x0E74)
+SFR8(ESIRAM117, 0x0E75)
+SFR8(ESIRAM118, 0x0E76)
+SFR8(ESIRAM119, 0x0E77)
+SFR8(ESIRAM120, 0x0E78)
+SFR8(ESIRAM121, 0x0E79)
+SFR8(ESIRAM122, 0x0E7A)
+SFR8(ESIRAM123, 0x0E7B)
+SFR8(ESIRAM124, 0x0E7C)
+SFR8(ESIRAM125, 0x0E7D)
+SFR8(ESIRAM126, 0x0E7E)
+SFR8(ESIRAM127, 0x0E7F)
@@ -0,0 +1,271 @@
+/* SimSensor.c
+ *
+ * LC sensors over a half metal-covered rotor disc.
+ *
+ * After the excitation is released, the LC voltage of a channel decays as
+ *     v(t) = Vmid + A * exp(-t / tau) * cos(w * t),   tau = Q / (pi * f)
+ * The comparator sees the maximum of v(t) in the time window of the latching
+ * TSM state. Metal under the sensor damps the LC (lower Q), so the peak level
+ * is lower over the metal part of the disc. The quality factor is blended over
+ * the metal edge, where the sensor covers metal only partially.
+ *
+ * Field effects are parameters of the model: part-to-part spread of gain and Q
+ * per channel, rotor wobble (the metal damping changes over one revolution
+ * with the air gap), temperature drift of Q and f, speed ramps of the rotor.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+
+#define PI  3.14159265358979323846
+
+Sim_Sensor_Config Sim_Sensor =
+{
+	2,                                      // Channels
+	{ 0.0, 0.25, 0.5, 0.75 },               // Position
+	0.5,                                    // Coverage
+	0.04,                                   // Edge
+	480e3,                                  // F_Lc
+	40.0,                                   // Q_Free
+	25.0,                                   // Q_Metal
+	1500.0,                                 // Amplitude
+	2048.0,                                 // Vmid
+	2.5,                                    // Noise
+	{ 1.0, 1.0, 1.0, 1.0 },                 // Gain
+	{ 1.0, 1.0, 1.0, 1.0 },                 // Q_Scale
+	0.0,                                    // Wobble
+	-0.0039,                                // Q_Tempco (copper resistance)
+	-50e-6,                                 // F_Tempco
+	25.0,                                   // Temperature
+	0.0,                                    // Temperature_Rate
+	0.0,                                    // Accel
+};
+
+static double Rotor_Rps;                    // rotor speed at Rotor_Time [rev/s]
+static double Rotor_Angle;                  // rotor angle at Rotor_Time [rev]
+static double Rotor_Time;
+static double Rotor_Target;                 // speed at the end of a ramp
+static double Rotor_Accel;                  // signed acceleration of the ramp, 0 if none
+
+
+//--------------------------------------------------------------------------
+//---  Parameters
+//---
+
+static const struct
+{
+	const char *Name;
+	double     *Value;
+} Param[] =
+{
+	{ "coverage",     &Sim_Sensor.Coverage },
+	{ "edge",         &Sim_Sensor.Edge },
+	{ "f_lc",         &Sim_Sensor.F_Lc },
+	{ "q_free",       &Sim_Sensor.Q_Free },
+	{ "q_metal",      &Sim_Sensor.Q_Metal },
+	{ "amplitude",    &Sim_Sensor.Amplitude },
+	{ "vmid",         &Sim_Sensor.Vmid },
+	{ "noise",        &Sim_Sensor.Noise },
+	{ "pos0",         &Sim_Sensor.Position[0] },
+	{ "pos1",         &Sim_Sensor.Position[1] },
+	{ "pos2",         &Sim_Sensor.Position[2] },
+	{ "pos3",         &Sim_Sensor.Position[3] },
+	{ "gain0",        &Sim_Sensor.Gain[0] },
+	{ "gain1",        &Sim_Sensor.Gain[1] },
+	{ "gain2",        &Sim_Sensor.Gain[2] },
+	{ "gain3",        &Sim_Sensor.Gain[3] },
+	{ "qscale0",      &Sim_Sensor.Q_Scale[0] },
+	{ "qscale1",      &Sim_Sensor.Q_Scale[1] },
+	{ "qscale2",      &Sim_Sensor.Q_Scale[2] },
+	{ "qscale3",      &Sim_Sensor.Q_Scale[3] },
+	{ "wobble",       &Sim_Sensor.Wobble },
+	{ "q_tempco",     &Sim_Sensor.Q_Tempco },
+	{ "f_tempco",     &Sim_Sensor.F_Tempco },
+	{ "temp",         &Sim_Sensor.Temperature },
+	{ "temp_rate",    &Sim_Sensor.Temperature_Rate },
+	{ "accel",        &Sim_Sensor.Accel },
+	{ "esiosc_hz",    &Sim_Part.Esiosc_Hz },
+	{ "esiosc_step",  &Sim_Part.Esiosc_Step },
+	{ "esiosc_tempco", &Sim_Part.Esiosc_Tempco },
+	{ "comp_noise",   &Sim_Part.Comparator_Noise },
+	{ "afe2_offset",  &Sim_Part.Afe2_Offset },
+	{ "adc_t30",      &Sim_Part.Adc_Temp_30C },
+	{ "adc_tempco",   &Sim_Part.Adc_Temp_Slope },
+	{ "i_active",     &Sim_Part.I_Active },
+	{ "i_lpm0",       &Sim_Part.I_Lpm0 },
+	{ "i_lpm3",       &Sim_Part.I_Lpm3 },
+	{ "q_tsm",        &Sim_Part.Q_Tsm_Sequence },
+};
+
+#define PARAM_NUM   (int)(sizeof(Param) / sizeof(Param[0]))
+
+int Sim_Param(const char *assignment)
+{
+	const char *eq = strchr(assignment, '=');
+	int i;
+
+	if (!eq)
+		return 0;
+	for (i = 0; i < PARAM_NUM; i++)
+		if ((strlen(Param[i].Name) == (size_t)(eq - assignment))
+		 && (strncmp(Param[i].Name, assignment, eq - assignment) == 0))
+		{	*Param[i].Value = atof(eq + 1);
+			return 1;
+		}
+	return 0;
+}
+
+void Sim_Params(FILE *f)
+{
+	int i;
+
+	for (i = 0; i < PARAM_NUM; i++)
+		fprintf(f, "  %-12s %g\n", Param[i].Name, *Param[i].Value);
+}
+
+void Sim_Sensor_Layout(int channels)
+{
+	int i;
+
+	Sim_Sensor.Channels = channels;
+	for (i = 0; i < 4; i++)
+		Sim_Sensor.Position[i] = (channels == 3) ? i / 3.0 : i * 0.25;
+}
+
+// Gaussian part-to-part spread of a virtual meter: spread is the relative
+// sigma of the gain and quality factors of every channel.
+void Sim_Sensor_Randomize(double spread)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{	Sim_Sensor.Gain[i] *= 1.0 + spread * Sim_Gauss();
+		Sim_Sensor.Q_Scale[i] *= 1.0 + spread * Sim_Gauss();
+	}
+	Sim_Sensor.F_Lc *= 1.0 + spread * 0.5 * Sim_Gauss();
+}
+
+double Sim_Sensor_Temperature(double time)
+{
+	return Sim_Sensor.Temperature + Sim_Sensor.Temperature_Rate * time;
+}
+
+
+//--------------------------------------------------------------------------
+//---  Rotor
+//---
+
+void Sim_Rotor_Reset(void)
+{
+	Rotor_Rps = 0;
+	Rotor_Angle = 0;
+	Rotor_Time = Sim_Time;
+	Rotor_Target = 0;
+	Rotor_Accel = 0;
+}
+
+// Angle and speed of the rotor at a time after Rotor_Time. rps may point to
+// Rotor_Rps, so it is written last.
+static double Rotor_State(double time, double *rps)
+{
+	double dt = time - Rotor_Time;
+	double ramp = (Rotor_Accel != 0) ? (Rotor_Target - Rotor_Rps) / Rotor_Accel : 0;
+	double angle;
+
+	if (dt < ramp)
+	{	angle = Rotor_Angle + Rotor_Rps * dt + 0.5 * Rotor_Accel * dt * dt;
+		*rps = Rotor_Rps + Rotor_Accel * dt;
+		return angle;
+	}
+	angle = Rotor_Angle + Rotor_Rps * ramp + 0.5 * Rotor_Accel * ramp * ramp + Rotor_Target * (dt - ramp);
+	*rps = Rotor_Target;
+	return angle;
+}
+
+void Sim_Rotor_Set_Speed(double rps)
+{
+	Rotor_Angle = Rotor_State(Sim_Time, &Rotor_Rps);
+	Rotor_Time = Sim_Time;
+	Rotor_Target = rps;
+	Rotor_Accel = 0;
+	if (Sim_Sensor.Accel > 0)
+		Rotor_Accel = (rps > Rotor_Rps) ? Sim_Sensor.Accel : -Sim_Sensor.Accel;
+	else
+		Rotor_Rps = rps;
+}
+
+double Sim_Rotor_Speed(void)
+{
+	double rps;
+
+	Rotor_State(Sim_Time, &rps);
+	return rps;
+}
+
+double Sim_Rotor_Revolutions(void)
+{
+	double rps;
+
+	return Rotor_State(Sim_Time, &rps);
+}
+
+
+//--------------------------------------------------------------------------
+//---  LC signal
+//---
+
+// Part of the sensor area over metal, 0..1.
+static double Metal(int channel, double angle)
+{
+	double x = Sim_Sensor.Position[channel] - angle;
+	double d;
+
+	x -= floor(x);                          // disc coordinate under the sensor
+	if (x < Sim_Sensor.Coverage)
+		d = fmin(x, Sim_Sensor.Coverage - x);
+	else
+		d = -fmin(x - Sim_Sensor.Coverage, 1.0 - x);
+	d = 0.5 + d / Sim_Sensor.Edge;
+	return (d < 0) ? 0 : (d > 1) ? 1 : d;
+}
+
+static double Decay(double a, double tau, double w, double t)
+{
+	return a * exp(-t / tau) * cos(w * t);
+}
+
+// Peak level seen in the window [t0, t1] after the release of the LC.
+double Sim_Sensor_Level(int channel, double time, double t0, double t1)
+{
+	double rps;
+	double angle = Rotor_State(time, &rps);
+	double dt = Sim_Sensor_Temperature(time) - 25.0;
+	double m = Metal(channel, angle);
+	double f = Sim_Sensor.F_Lc * (1.0 + Sim_Sensor.F_Tempco * dt);
+	double q_free = Sim_Sensor.Q_Free;
+	double q_metal = Sim_Sensor.Q_Metal;
+	double w = 2 * PI * f;
+	double a = Sim_Sensor.Amplitude * Sim_Sensor.Gain[channel];
+	double q, tau, phi, tp, v;
+
+	if (Sim_Sensor.Wobble != 0)
+		q_metal = q_free + (q_metal - q_free) * (1.0 + Sim_Sensor.Wobble * cos(2 * PI * angle));
+	q = (q_free + (q_metal - q_free) * m) * Sim_Sensor.Q_Scale[channel] * (1.0 + Sim_Sensor.Q_Tempco * dt);
+	tau = q / (PI * f);
+
+	if (t0 < 0)
+		t0 = 0;
+	if (t1 < t0)
+		t1 = t0;
+
+	v = fmax(Decay(a, tau, w, t0), Decay(a, tau, w, t1));
+	phi = atan(1.0 / (w * tau));            // maxima at w*t = 2*pi*k - phi
+	tp = (ceil((w * t0 + phi) / (2 * PI)) * 2 * PI - phi) / w;
+	if (tp <= t1)
+		v = fmax(v, Decay(a, tau, w, tp));
+
+	return Sim_Sensor.Vmid + v + Sim_Sensor.Noise * Sim_Gauss();
+}
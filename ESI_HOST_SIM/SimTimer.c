@@ -0,0 +1,227 @@
+/* SimTimer.c
+ *
+ * Timer_A model for TA0..TA3: up and continuous mode in compare mode, clocked
+ * from ACLK or SMCLK with the ID and TAIDEX dividers. TAR is derived from the
+ * time elapsed since the last (re)configuration; the interrupt flags are set
+ * when the counter passes the compare values.
+ */
+
+#include <math.h>
+#include "msp430fr6989.h"
+#include "Sim.h"
+
+#define TIMER_NUM   4
+
+// register offsets of a Timer_A instance
+#define TA_CTL      0x00
+#define TA_CCTL(n)  (0x02 + 2 * (n))
+#define TA_R        0x10
+#define TA_CCR(n)   (0x12 + 2 * (n))
+#define TA_EX0      0x20
+#define TA_IV       0x2E
+
+typedef struct
+{
+	unsigned int Base;
+	int          Ccrs;                      // number of capture/compare registers
+	unsigned int Ctl_Prev;                  // TAxCTL configuration bits seen at the last sync
+	unsigned int Ex0_Prev;
+	unsigned int Ccr0_Prev;
+	double       Anchor;                    // time at which TAR was Anchor_R
+	unsigned int Anchor_R;
+	long long    Tick_Done;                 // ticks since Anchor already processed
+} Timer;
+
+static Timer Ta[TIMER_NUM] =
+{
+	{ 0x0340, 3 }, { 0x0380, 3 }, { 0x0400, 2 }, { 0x0440, 5 },
+};
+
+#define REG(t, off) SIM_REG16((t)->Base + (off))
+
+
+static double Rate(const Timer *t)
+{
+	unsigned int ctl = REG(t, TA_CTL);
+	double f;
+
+	switch ((ctl >> 8) & 3)
+	{
+	case 1:  f = SIM_ACLK_HZ; break;
+	case 2:  f = SIM_MCLK_HZ; break;
+	default: return 0;                      // TAxCLK / INCLK are not connected
+	}
+	return f / (1 << ((ctl >> 6) & 3)) / ((REG(t, TA_EX0) & 7) + 1);
+}
+
+static unsigned int Mode(const Timer *t)
+{
+	return (REG(t, TA_CTL) >> 4) & 3;
+}
+
+static unsigned long Period(const Timer *t)
+{
+	return (Mode(t) == MC__CONTINUOUS >> 4) ? 0x10000 : (unsigned long)REG(t, TA_CCR(0)) + 1;
+}
+
+// First tick after tick k at which TAR reaches value v.
+static long long Next_Tick(const Timer *t, long long k, unsigned int v)
+{
+	unsigned long p = Period(t);
+	long long r = (long long)((t->Anchor_R + k + 1) % p);
+
+	if (v >= p)
+		return -1;
+	return k + 1 + (((long long)v - r) % (long long)p + (long long)p) % (long long)p;
+}
+
+static long long Ticks(const Timer *t, double time)
+{
+	double f = Rate(t);
+
+	return (f > 0) ? (long long)floor((time - t->Anchor) * f + 1e-6) : 0;
+}
+
+static int Running(const Timer *t)
+{
+	return (Mode(t) != 0) && (Rate(t) > 0);
+}
+
+// Sets the flags of all compare events in the ticks (Tick_Done, k].
+static void Update(Timer *t, long long k)
+{
+	int n;
+	long long e;
+
+	if (!Running(t) || (k <= t->Tick_Done))
+		return;
+	e = Next_Tick(t, t->Tick_Done, 0);
+	if ((e >= 0) && (e <= k))
+		REG(t, TA_CTL) |= TAIFG;
+	for (n = 0; n < t->Ccrs; n++)
+	{
+		if (REG(t, TA_CCTL(n)) & CAP)
+			continue;
+		e = Next_Tick(t, t->Tick_Done, REG(t, TA_CCR(n)));
+		if ((e >= 0) && (e <= k))
+			REG(t, TA_CCTL(n)) |= CCIFG;
+	}
+	t->Tick_Done = k;
+	REG(t, TA_R) = (unsigned short)((t->Anchor_R + k) % Period(t));
+}
+
+static void Anchor(Timer *t)
+{
+	t->Anchor = Sim_Time;
+	t->Anchor_R = REG(t, TA_R);
+	t->Tick_Done = 0;
+	t->Ctl_Prev = REG(t, TA_CTL) & ~(TAIFG | TACLR);
+	t->Ex0_Prev = REG(t, TA_EX0);
+	t->Ccr0_Prev = REG(t, TA_CCR(0));
+}
+
+static void Timer_Reset(void)
+{
+	int i;
+
+	for (i = 0; i < TIMER_NUM; i++)
+		Anchor(&Ta[i]);
+}
+
+static void Timer_Sync(void)
+{
+	int i;
+
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		Timer *t = &Ta[i];
+
+		if (Running(t) && (t->Ctl_Prev & MC_3))        // not over a stop
+			Update(t, Ticks(t, Sim_Time));
+		if (REG(t, TA_CTL) & TACLR)
+		{	REG(t, TA_CTL) &= ~TACLR;
+			REG(t, TA_R) = 0;
+			Anchor(t);
+		}
+		else if (((REG(t, TA_CTL) & ~TAIFG) != t->Ctl_Prev) || (REG(t, TA_EX0) != t->Ex0_Prev)
+		      || (REG(t, TA_CCR(0)) != t->Ccr0_Prev))
+			Anchor(t);
+	}
+}
+
+static double Timer_Next_Event(void)
+{
+	double next = SIM_INFINITY;
+	int i, n;
+
+	for (i = 0; i < TIMER_NUM; i++)
+	{
+		Timer *t = &Ta[i];
+		long long e;
+
+		if (!Running(t))
+			continue;
+		if ((REG(t, TA_CTL) & TAIE) && !(REG(t, TA_CTL) & TAIFG))
+		{	e = Next_Tick(t, t->Tick_Done, 0);
+			if ((e >= 0) && (t->Anchor + e / Rate(t) < next))
+				next = t->Anchor + e / Rate(t);
+		}
+		for (n = 0; n < t->Ccrs; n++)
+		{
+			unsigned int cctl = REG(t, TA_CCTL(n));
+
+			if (!(cctl & CCIE) || (cctl & (CCIFG | CAP)))
+				continue;
+			e = Next_Tick(t, t->Tick_Done, REG(t, TA_CCR(n)));
+			if ((e >= 0) && (t->Anchor + e / Rate(t) < next))
+				next = t->Anchor + e / Rate(t);
+		}
+	}
+	return next;
+}
+
+static void Timer_Process(void)
+{
+	int i;
+
+	for (i = 0; i < TIMER_NUM; i++)
+		if (Running(&Ta[i]))
+			Update(&Ta[i], Ticks(&Ta[i], Sim_Time));
+}
+
+int Sim_Timer_Pending(int arg)
+{
+	Timer *t = &Ta[arg / 2];
+	int n;
+
+	if ((arg & 1) == 0)
+		return (REG(t, TA_CCTL(0)) & (CCIE | CCIFG)) == (CCIE | CCIFG);
+	for (n = 1; n < t->Ccrs; n++)
+		if ((REG(t, TA_CCTL(n)) & (CCIE | CCIFG)) == (CCIE | CCIFG))
+			return 1;
+	return (REG(t, TA_CTL) & (TAIE | TAIFG)) == (TAIE | TAIFG);
+}
+
+void Sim_Timer_Accept(int arg)
+{
+	Timer *t = &Ta[arg / 2];
+	int n;
+
+	if ((arg & 1) == 0)
+	{	REG(t, TA_CCTL(0)) &= ~CCIFG;       // CCIFG0 is reset when its interrupt is accepted
+		return;
+	}
+	REG(t, TA_IV) = 0;                      // reading TAxIV resets the flag
+	for (n = 1; n < t->Ccrs; n++)
+		if ((REG(t, TA_CCTL(n)) & (CCIE | CCIFG)) == (CCIE | CCIFG))
+		{	REG(t, TA_IV) = 2 * n;
+			REG(t, TA_CCTL(n)) &= ~CCIFG;
+			return;
+		}
+	if ((REG(t, TA_CTL) & (TAIE | TAIFG)) == (TAIE | TAIFG))
+	{	REG(t, TA_IV) = 0x0E;              // TAIFG
+		REG(t, TA_CTL) &= ~TAIFG;
+	}
+}
+
+const Sim_Module Sim_Timer_Module = { "Timer_A", Timer_Reset, Timer_Sync, Timer_Next_Event, Timer_Process };
@@ -0,0 +1,244 @@
+/* TraceDec.c
+ *
+ * tracedec: decoder of the ISR trace of the firmware (Trace.h, Isr_trace).
+ *
+ * Reads a TI-TXT memory dump of Trace_Log, as the debugger saves it from the
+ * target or esisim -T writes it: Count (32 bits), then the ring of 6-byte
+ * records Isr, Late, Entry, Exit (16 bits, little endian). The ring size is
+ * the size of the dump. The records are taken from the oldest one on; their
+ * TA2R stamps are placed in time from record to record, which holds as the TA2
+ * overflow interrupt is traced itself: no two records are more than a TA2
+ * period apart, and every Timer2_A record starts the next period. A reset
+ * record starts the time again.
+ *
+ * Per ISR the calls, the share of the time spent in it, the duration and, for
+ * the timers, the latency from the trigger are listed with a histogram in ACLK
+ * cycles (30.5 us); "queued" counts the entries within one ACLK cycle of the
+ * exit of the ISR before, which most likely waited for it. An ISR that ran
+ * longer than a TA2 period shows modulo that period. The cost of the trace is
+ * the number of records times the cycles of Trace_In() and Trace_Out() per ISR
+ * (-c, as esisim reports them). With -t every record is listed as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ACLK_HZ         32768.0
+#define MCLK_HZ         4e6
+#define MAX_BYTES       65536
+#define TRACE_ISRS      8                   // Trace_esi .. Trace_adc
+#define TRACE_RESET     8                   // Trace_reset
+#define TRACE_TA2       3                   // Trace_ta2
+#define LATE_NONE       0xFF                // Trace_late_none
+#define BINS            9                   // histogram: < 1, 2, 4 .. 128 ACLK cycles, more
+#define TRACE_CYCLES    80                  // Trace_In() + Trace_Out() per ISR, esisim
+
+static const char *const Isr_Name[TRACE_ISRS] =
+{
+	"ISR_ESCAN_IF", "Timer_A", "Timer1_A", "Timer2_A", "Timer3_A", "USCI_B0_ISR", "PORT1_ISR", "ADC12_ISR",
+};
+
+typedef struct
+{
+	unsigned long Calls, Queued, Late_Calls;
+	double        Busy, Max, Late_Sum, Late_Max;    // ACLK cycles
+	unsigned long Hist[BINS], Late_Hist[BINS];
+} Isr_Stats;
+
+static const char   *Path;
+static unsigned char Image[MAX_BYTES];
+static Isr_Stats     Stats[TRACE_ISRS];
+
+
+// Bytes of the first section of a TI-TXT file, the address is not used.
+static int Read_Dump(FILE *f)
+{
+	char word[16];
+	unsigned int byte;
+	int n = 0, section = 0;
+
+	while (fscanf(f, "%15s", word) == 1)
+	{
+		if (word[0] == '@')
+		{	if (section++)
+				break;
+		}
+		else if ((word[0] == 'q') || (word[0] == 'Q'))
+			break;
+		else if (!section || (sscanf(word, "%2x", &byte) != 1) || (n == MAX_BYTES))
+		{	fprintf(stderr, "%s: not a TI-TXT dump of Trace_Log\n", Path);
+			return -1;
+		}
+		else
+			Image[n++] = (unsigned char)byte;
+	}
+	return n;
+}
+
+static unsigned int Word(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static int Bin(unsigned int cycles)
+{
+	int b = 0;
+
+	while ((b < BINS - 1) && (cycles >= (1u << b)))
+		b++;
+	return b;
+}
+
+static void Histogram(const unsigned long *hist)
+{
+	int b;
+
+	for (b = 0; b < BINS; b++)
+		printf(" %6lu", hist[b]);
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	double cycles = TRACE_CYCLES;
+	int timeline = 0, opt, size, records, resets = 0, first, i, b;
+	unsigned long count, written;
+	long long t = 0, period = 0, exit_prev = -2, start = 0, span = 0;     // ACLK cycles
+	FILE *f;
+
+	while ((opt = getopt(argc, argv, "tc:")) != -1)
+	{
+		switch (opt)
+		{
+		case 't': timeline = 1; break;
+		case 'c': cycles = atof(optarg); break;
+		default:
+			fprintf(stderr,
+				"usage: tracedec [-t] [-c CYCLES] DUMP\n"
+				"  -t         list every record\n"
+				"  -c CYCLES  cycles of Trace_In() and Trace_Out() per ISR (default %d)\n", TRACE_CYCLES);
+			return 2;
+		}
+	}
+	if (optind != argc - 1)
+	{	fprintf(stderr, "usage: tracedec [-t] [-c CYCLES] DUMP\n");
+		return 2;
+	}
+	Path = argv[optind];
+	if (!(f = fopen(Path, "r")))
+	{	perror(Path);
+		return 1;
+	}
+	size = Read_Dump(f);
+	fclose(f);
+	if ((size < 4 + 6) || ((size - 4) % 6))
+	{	if (size >= 0)
+			fprintf(stderr, "%s: %d bytes, not a Trace_Log\n", Path, size);
+		return 1;
+	}
+
+	count = Image[0] | (Image[1] << 8) | ((unsigned long)Image[2] << 16) | ((unsigned long)Image[3] << 24);
+	records = (size - 4) / 6;
+	written = (count < (unsigned long)records) ? count : (unsigned long)records;
+	first = (count < (unsigned long)records) ? 0 : (int)(count % records);
+
+	if (timeline)
+		printf("%12s  %-12s %9s %9s\n", "time[ms]", "ISR", "late[us]", "dur[us]");
+	for (i = 0; i < (int)written; i++)
+	{
+		const unsigned char *r = &Image[4 + 6 * ((first + i) % records)];
+		unsigned int isr = r[0], late = r[1], entry = Word(&r[2]), duration = (Word(&r[4]) - entry) & 0xFFFF;
+		Isr_Stats *s;
+
+		if (isr == TRACE_RESET)
+		{	span += t - start;
+			t = start = entry;
+			period = 0;
+			exit_prev = -2;
+			resets++;
+			if (timeline)
+				printf("%12s  reset\n", "");
+			continue;
+		}
+		if (isr >= TRACE_ISRS)
+		{	fprintf(stderr, "%s: record %d: ISR %u unknown\n", Path, i, isr);
+			return 1;
+		}
+
+		if (i == 0)
+			t = start = entry;
+		else if (isr == TRACE_TA2)                  // the next overflow of TA2
+			t = (++period << 16) + entry;
+		else                                        // less than a TA2 period after the record before
+			t += (entry - t) & 0xFFFF;
+
+		s = &Stats[isr];
+		s->Calls++;
+		s->Busy += duration;
+		if (duration > s->Max)
+			s->Max = duration;
+		s->Hist[Bin(duration)]++;
+		if (t <= exit_prev + 1)
+			s->Queued++;
+		if (late != LATE_NONE)
+		{	s->Late_Calls++;
+			s->Late_Sum += late;
+			if (late > s->Late_Max)
+				s->Late_Max = late;
+			s->Late_Hist[Bin(late)]++;
+		}
+		exit_prev = t + duration;
+		if (timeline)
+		{	printf("%12.3f  %-12s ", (t - start) * 1e3 / ACLK_HZ, Isr_Name[isr]);
+			if (late != LATE_NONE)
+				printf("%9.0f", late * 1e6 / ACLK_HZ);
+			else
+				printf("%9s", "-");
+			printf(" %9.0f\n", duration * 1e6 / ACLK_HZ);
+		}
+	}
+	span += t - start;
+
+	if (timeline)
+		printf("\n");
+	printf("%s: %lu records written, the last %lu over %.3f s, %d resets\n", Path, count, written,
+	       span / ACLK_HZ, resets);
+	printf("%-12s %7s %7s %8s %8s %7s %9s %9s\n", "ISR", "calls", "busy[%]", "dur[us]", "max[us]", "queued",
+	       "late[us]", "max[us]");
+	for (i = 0; i < TRACE_ISRS; i++)
+	{
+		const Isr_Stats *s = &Stats[i];
+
+		if (!s->Calls)
+			continue;
+		printf("%-12s %7lu %7.3f %8.0f %8.0f %7lu", Isr_Name[i], s->Calls, span ? 100.0 * s->Busy / span : 0.0,
+		       s->Busy * 1e6 / ACLK_HZ / s->Calls, s->Max * 1e6 / ACLK_HZ, s->Queued);
+		if (s->Late_Calls)
+			printf(" %9.0f %9.0f\n", s->Late_Sum * 1e6 / ACLK_HZ / s->Late_Calls, s->Late_Max * 1e6 / ACLK_HZ);
+		else
+			printf(" %9s %9s\n", "-", "-");
+	}
+
+	printf("\n%-18s %6s", "ACLK cycles", "<1");
+	for (b = 1; b < BINS - 1; b++)
+		printf("   <%3u", 1u << b);
+	printf("  >=%3u\n", 1u << (BINS - 2));
+	for (i = 0; i < TRACE_ISRS; i++)
+	{
+		if (!Stats[i].Calls)
+			continue;
+		printf("%-12s dur   ", Isr_Name[i]);
+		Histogram(Stats[i].Hist);
+		if (Stats[i].Late_Calls)
+		{	printf("%-12s late  ", "");
+			Histogram(Stats[i].Late_Hist);
+		}
+	}
+
+	printf("\ntrace cost   %lu records x %.0f cycles: %.3f ms of CPU at 4 MHz, %.3f %% of the time\n",
+	       written, cycles, written * cycles * 1e3 / MCLK_HZ,
+	       span ? 100.0 * written * cycles / MCLK_HZ / (span / ACLK_HZ) : 0.0);
+	return 0;
+}
@@ -0,0 +1,11 @@
+/* in430.h (host)
+ *
+ * The TI device header includes this file for the compiler intrinsics.
+ */
+
+#ifndef HOST_IN430_H_
+#define HOST_IN430_H_
+
+#include "intrinsics.h"
+
+#endif /* HOST_IN430_H_ */
@@ -0,0 +1,46 @@
+/* intrinsics.h (host)
+ *
+ * MSP430 compiler intrinsics for the host build of the firmware.
+ * Status register operations and busy waits are executed by the simulator core
+ * (SimCore.c): entering an LPM advances simulated time until an interrupt
+ * service routine clears the LPM bits on exit. The decimal adds (DADD) are
+ * computed by the core too, without cycles beyond the firmware block.
+ * __data16_write_addr() writes a 20-bit address register of the DMA controller
+ * (SimDMA.c), which keeps the host pointer.
+ */
+
+#ifndef HOST_INTRINSICS_H_
+#define HOST_INTRINSICS_H_
+
+void Sim_Bis_SR(unsigned int bits);
+void Sim_Bic_SR(unsigned int bits);
+void Sim_Bis_SR_On_Exit(unsigned int bits);
+void Sim_Bic_SR_On_Exit(unsigned int bits);
+unsigned int Sim_Get_SR(void);
+void Sim_Delay_Cycles(unsigned long cycles);
+unsigned long Sim_Bcd_Add(unsigned long a, unsigned long b, int digits);
+void Sim_Data16_Write_Addr(unsigned short addr, unsigned long src);
+
+#define __bis_SR_register(x)            Sim_Bis_SR(x)
+#define __bic_SR_register(x)            Sim_Bic_SR(x)
+#define __bis_SR_register_on_exit(x)    Sim_Bis_SR_On_Exit(x)
+#define __bic_SR_register_on_exit(x)    Sim_Bic_SR_On_Exit(x)
+#define __get_SR_register()             Sim_Get_SR()
+#define __enable_interrupt()            Sim_Bis_SR(GIE)
+#define __disable_interrupt()           Sim_Bic_SR(GIE)
+#define _enable_interrupts()            Sim_Bis_SR(GIE)
+#define _disable_interrupts()           Sim_Bic_SR(GIE)
+#define _low_power_mode_off_on_exit()   Sim_Bic_SR_On_Exit(LPM4_bits)
+#define __low_power_mode_off_on_exit()  Sim_Bic_SR_On_Exit(LPM4_bits)
+
+#define __delay_cycles(x)               Sim_Delay_Cycles(x)
+#define __bcd_add_short(a, b)           ((unsigned short)Sim_Bcd_Add((a), (b), 4))
+#define __bcd_add_long(a, b)            Sim_Bcd_Add((a), (b), 8)
+#define __data16_write_addr(addr, src)  Sim_Data16_Write_Addr((addr), (src))
+#define __no_operation()                ((void)0)
+#define _no_operation()                 ((void)0)
+#define __even_in_range(x, y)           (x)
+#define _even_in_range(x, y)            (x)
+#define _never_executed()               ((void)0)
+
+#endif /* HOST_INTRINSICS_H_ */
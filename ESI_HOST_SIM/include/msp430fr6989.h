@@ -0,0 +1,29 @@
+/* msp430fr6989.h (host)
+ *
+ * Host build replacement for the TI device header. It is force-included into
+ * every firmware source (-include) when the firmware is built for the ESI host
+ * simulator, so the device header in the firmware directory is never parsed on
+ * its own.
+ *
+ * The SFR declarations of the TI header are kept; only their C types are
+ * adapted to the host (16-bit registers are "unsigned short"). The register
+ * symbols themselves are placed into the simulated peripheral file by SimSFR.c.
+ *
+ * Note: "int" is 32 bits wide on the host, 16 bits on the MSP430.
+ */
+
+#ifndef HOST_MSP430FR6989_H_
+#define HOST_MSP430FR6989_H_
+
+#include <stdlib.h>                             // abs() is used by the firmware without prototype
+
+#define SFR_8BIT(address)   extern volatile unsigned char address
+#define SFR_16BIT(address)  extern volatile unsigned short address
+#define SFR_20BIT(address)  extern volatile unsigned long address
+#define SFR_32BIT(address)  extern volatile unsigned int address
+
+#define __interrupt                             // ISRs are plain functions, called by the simulator core
+
+#include "../../EVM430-FR6989_Out_of_Box_FW/msp430fr6989.h"
+
+#endif /* HOST_MSP430FR6989_H_ */
@@ -14,8 +14,16 @@
 #define ESIOSC_6MHz     183    // ESIOSC frequency is 5.997 MHz
 #define ESIOSC_7MHz     214    // ESIOSC frequency is 7.012 MHz
 
+//---- EsioscInit(): the ESICLKFQ-to-frequency slope is measured over ESIOSC_slope_steps settings
+#define ESIOSC_slope_steps  16
+#define ESIOSC_slope_min    16    // 1/64 ESIOSC cycles per ACLK period and step, lower: not a valid slope
+
+extern unsigned char Esiosc_target;
+
 void EsioscInit(unsigned char frequency);
 unsigned char EsioscReCal(unsigned char target);
 unsigned char EsioscMeasure(void);
+unsigned int MeasureEsiosc_Sum(void);
+unsigned char getESICLKFQ(void);
 
 #endif /* ESI_OSC_H_ */
@@ -1,7 +1,23 @@
 #ifndef LCD_H
 #define LCD_H
 
+// Display task: ISR_ESCAN_IF leaves the LCD alone. TA3 (ACLK/8) wakes the main loop every
+// Display_period if ESICNT1 has moved since the last refresh, and the main loop draws the
+// count. With Display_period 0 only switching the LCD on with the P1.2 key draws it.
+// 0: ISR_ESCAN_IF draws the count on every Q6 event.
+#ifndef Display_task
+#define Display_task         1
+#endif
+#ifndef Display_period
+#define Display_period       2048     // 0.5 s of ACLK/8, 2 Hz
+#endif
+
+// Lines of lcd_display_num()
+#define LCD_large		0			// lower line, 5 large digits
+#define LCD_small		1			// upper line, 4 small digits
+#define LCD_total		2			// both lines as one 8 digit number, the upper line the leading digits
+
 void init_LCD(void);
-void lcd_display_num(unsigned int num, unsigned char small);
+void lcd_display_num(unsigned long num, unsigned char line);
 
 #endif
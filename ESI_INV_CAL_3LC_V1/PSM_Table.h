@@ -0,0 +1,76 @@
+/*
+ * PSM_Table.h
+ *
+ * PSM state table, generated by psmgen from ESI_HOST_SIM/psm/3LC.psm. Do not edit,
+ * change the description and run make psm in ESI_HOST_SIM.
+ *
+ *   sensors 3, sequence 001 011 010 110 100 101
+ *   up forward, q6 forward, error cnt2, invalid q7
+ */
+
+ const unsigned char Table[] = {
+		0x80,		// 000 -> 000 invalid Q7
+		0x88,		// 000 -> 001 invalid Q7
+		0x90,		// 000 -> 010 invalid Q7
+		0x98,		// 000 -> 011 invalid Q7
+		0xA0,		// 000 -> 100 invalid Q7
+		0xA8,		// 000 -> 101 invalid Q7
+		0xB0,		// 000 -> 110 invalid Q7
+		0xB8,		// 000 -> 111 invalid Q7
+		0x80,		// 001 -> 000 invalid Q7
+		0x08,		// 001 -> 001
+		0x16,		// 001 -> 010 jump ESICNT2
+		0x5A,		// 001 -> 011 up Q6
+		0x26,		// 001 -> 100 jump ESICNT2
+		0x2C,		// 001 -> 101 down
+		0x36,		// 001 -> 110 jump ESICNT2
+		0xB8,		// 001 -> 111 invalid Q7
+		0x80,		// 010 -> 000 invalid Q7
+		0x0E,		// 010 -> 001 jump ESICNT2
+		0x10,		// 010 -> 010
+		0x1C,		// 010 -> 011 down
+		0x26,		// 010 -> 100 jump ESICNT2
+		0x2E,		// 010 -> 101 jump ESICNT2
+		0x72,		// 010 -> 110 up Q6
+		0xB8,		// 010 -> 111 invalid Q7
+		0x80,		// 011 -> 000 invalid Q7
+		0x0C,		// 011 -> 001 down
+		0x52,		// 011 -> 010 up Q6
+		0x18,		// 011 -> 011
+		0x26,		// 011 -> 100 jump ESICNT2
+		0x2E,		// 011 -> 101 jump ESICNT2
+		0x36,		// 011 -> 110 jump ESICNT2
+		0xB8,		// 011 -> 111 invalid Q7
+		0x80,		// 100 -> 000 invalid Q7
+		0x0E,		// 100 -> 001 jump ESICNT2
+		0x16,		// 100 -> 010 jump ESICNT2
+		0x1E,		// 100 -> 011 jump ESICNT2
+		0x20,		// 100 -> 100
+		0x6A,		// 100 -> 101 up Q6
+		0x34,		// 100 -> 110 down
+		0xB8,		// 100 -> 111 invalid Q7
+		0x80,		// 101 -> 000 invalid Q7
+		0x4A,		// 101 -> 001 up Q6
+		0x16,		// 101 -> 010 jump ESICNT2
+		0x1E,		// 101 -> 011 jump ESICNT2
+		0x24,		// 101 -> 100 down
+		0x28,		// 101 -> 101
+		0x36,		// 101 -> 110 jump ESICNT2
+		0xB8,		// 101 -> 111 invalid Q7
+		0x80,		// 110 -> 000 invalid Q7
+		0x0E,		// 110 -> 001 jump ESICNT2
+		0x14,		// 110 -> 010 down
+		0x1E,		// 110 -> 011 jump ESICNT2
+		0x62,		// 110 -> 100 up Q6
+		0x2E,		// 110 -> 101 jump ESICNT2
+		0x30,		// 110 -> 110
+		0xB8,		// 110 -> 111 invalid Q7
+		0x80,		// 111 -> 000 invalid Q7
+		0x88,		// 111 -> 001 invalid Q7
+		0x90,		// 111 -> 010 invalid Q7
+		0x98,		// 111 -> 011 invalid Q7
+		0xA0,		// 111 -> 100 invalid Q7
+		0xA8,		// 111 -> 101 invalid Q7
+		0xB0,		// 111 -> 110 invalid Q7
+		0xB8 		// 111 -> 111 invalid Q7
+ };
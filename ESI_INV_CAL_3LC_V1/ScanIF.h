@@ -1,18 +0,0 @@
-/*
- * ScanIF.h
- *
- *  Created on: Nov 29, 2012
- *
- */
-
-#ifndef SCANIF_H_
-#define SCANIF_H_
-
-#define AFE2_enable        1
-
-void InitScanIF(void);
-void ReCalScanIF(void);
-
-
-
-#endif /* SCANIF_H_ */
@@ -0,0 +1,96 @@
+/*
+ * ScanIF_Layout.h
+ *
+ * Meter layout of the ScanIF engine: 3 LC sensors, INV comparators.
+ * Included by ScanIF.c only, which all meter projects share from ESI_SCANIF.
+ *
+ */
+
+#ifndef SCANIF_LAYOUT_H_
+#define SCANIF_LAYOUT_H_
+
+#define ESI_channels       3          // LC sensors on ESICH0.., 1 to 4
+#define ESI_inverted       1          // ESICA1INV/ESICA2INV: ESIOUTx is 1 below the DAC level
+#define Noise_common       0          // Noise_level of every channel
+
+#define ESI_CTL_select     (ESIS3SEL1 + ESIS2SEL0)      // PPUS1..3 sources: ESIOUT0, ESIOUT1, ESIOUT2
+#define ESI_PSM_select     0                            // PPUS3 as V2 in normal operation
+#define TSM_rate_cal       ESIDIV3A_4                   // 1820 Hz, ACLK/18, calibration and ReCalScanIF()
+#define TSM_rate_run       (ESIDIV3A_2 + ESIDIV3B_2)    // 655 Hz, ACLK/50, normal operation
+#define Cal_rotor_command  0                            // IIC_TX() to the motor board before Set_DAC(), 0: none
+
+// TSM state list for 3 sensors, loaded by InitScanIF()
+#define TSM_states         30         // ESITSM0..29
+
+const unsigned int TSM_list[TSM_states] =
+{
+	0x0400,		// sync with Aclk
+	0x182C,		// excitation of Ch0 for 1us
+	0x0404,		// 1 Aclk delay
+	0x0024,		// tunable delay
+	0x0024,		// tunable delay
+	0x0024,		// tunable delay
+	0x0024,		// tunable delay
+	0xC934,		// DAC on, CA on, for 26 TSM clks
+	0x4974,		// DAC on, Ca on, and latches enable, for 10 TSM clks
+	0x0400,		// internally shorted for channel 0 LC sensor, for 1 Aclk
+	0x0400,		// internally shorted for channel 0 LC sensor, for 1 Aclk
+	0x18AD,		// excitation of Ch1 for 1us
+	0x0485,		// 1 Aclk delay
+	0x00A5,		// tunable delay
+	0x00A5,		// tunable delay
+	0x00A5,		// tunable delay
+	0x00A5,		// tunable delay
+	0xC9B5,		// DAC on, CA on, for 26 TSM clks
+	0x49F5,		// DAC on, Ca on, and latches enable, for 10 TSM clks
+	0x0401,		// internally shorted for channel 1 LC sensor, for 1 Aclk
+	0x0401,		// internally shorted for channel 1 LC sensor, for 1 Aclk
+	0x182E,		// excitation of Ch2 for 1us
+	0x0406,		// 1 Aclk delay
+	0x0026,		// tunable delay
+	0x0026,		// tunable delay
+	0x0026,		// tunable delay
+	0x0026,		// tunable delay
+	0xC936,		// DAC on, CA on, for 26 TSM clks
+	0x4976,		// DAC on, Ca on, and latches enable, for 10 TSM clks
+	0x0202,		// Stop TSM
+};
+
+// Tunable delay chains, tuned by TSM_Auto_cal()
+#define cycle_width        6          // which is equal to (ESICLK / freq of LC) - 2
+#define Delay_taps         4          // ESITSM3..6, ESITSM13..16, ESITSM23..26
+
+const unsigned char Delay_first[ESI_channels] = {3, 13, 23};	// first state of the delay chain of every channel
+const unsigned char Delay_aclk[ESI_channels]  = {2, 12, 22};	// 1xACLK state in front of it
+
+// Sensor states (ESIPPU & State_mask): in every state one channel is at its Max or Min level
+#define State_mask         0x0007
+#define No_channel         0xFF       // a state the disc does not show
+#define Tot_states         6          // sensor state changes per rotation
+
+const unsigned char State_channel[State_mask+1] = {No_channel, 0, 1, 2, 2, 1, 0, No_channel};
+const unsigned char Max_state[ESI_channels] = {1, 2, 4};
+const unsigned char Min_state[ESI_channels] = {6, 5, 3};
+
+// ReCalScanIF(): 4 rotations for a re-calibration, 8 for the initialization
+#define ReCal_loops_max    54         // TSM sequences before the burst gives up
+#define ReCal_Q6_gate      0          // 1: the Q6 interrupt is enabled only for the wait between two readings
+#define ReCal_timer_hold   1          // 1: no TA0 interrupt from a reading to the next
+
+#if Rate_governor
+#define Rate_start         2          // 655 Hz, TSM_rate_run
+#define Rate_margin_down   9          // 2.25, 655 Hz gives 2.4 sequences per state at 45 rps
+
+const unsigned int Rate_divider[Rate_levels] =			// ESIDIV3A, ESIDIV3B of every rate, fastest first
+{
+	ESIDIV3A_4,												// 1820 Hz, ACLK/18
+	ESIDIV3A_7,												// 1092 Hz, ACLK/30
+	ESIDIV3A_2 + ESIDIV3B_2,								// 655 Hz, ACLK/50
+	ESIDIV3A_7 + ESIDIV3B_1,								// 364 Hz, ACLK/90
+	ESIDIV3A_7 + ESIDIV3B_3,								// 156 Hz, ACLK/210
+	ESIDIV3A_7 + ESIDIV3B_7,								// 73 Hz, ACLK/450
+};
+const unsigned int Rate_period[Rate_levels] = {18, 30, 50, 90, 210, 450};	// ACLK cycles between two TSM sequences
+#endif
+
+#endif /* SCANIF_LAYOUT_H_ */
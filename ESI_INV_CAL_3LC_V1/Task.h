@@ -0,0 +1,52 @@
+/*
+ * Task.h
+ *
+ * Event scheduler of the main loop, the same file in every meter project.
+ *
+ */
+
+#ifndef TASK_H_
+#define TASK_H_
+
+// The interrupts post events with Task_Post() into Task_Ring, which only the interrupts write
+// (they do not nest) and only the main loop reads, so it needs no lock. Task_Run() sleeps in
+// the deepest LPM the running clock users allow, with the check and the LPM entry under one
+// GIE so that no event is left waiting for the next wake; then it runs the pending tasks,
+// highest priority first and each to completion, and returns when none is left. An
+// interrupt leaves the LPM only when Task_Post() says the main loop sleeps there, never the
+// LPM wait of a running task. Every task has a deadline in ACLK cycles from its first post,
+// measured on TA2R: Task_Wait[] keeps the longest wait, Task_Late[] counts the runs that
+// started after it. The deadlines are for the measurement only: the order is the priority
+// alone, and a late task is neither skipped nor moved up. A post to a full ring is counted in
+// Task_Lost and still runs the task, its wait counted from when Task_Run() takes it. The temperature reading is split at the ADC12 interrupt (ScanIF.h).
+// 0: the main loop polls ReCal_Flag, test_status, Display_due and Save_due after every LPM3 wake.
+#ifndef Task_scheduler
+#define Task_scheduler       1
+#endif
+#define Task_ring_size       16       // events, power of 2: the posts of a 4 s demo end
+
+// Tasks, highest priority first
+#define Task_demo            0        // 2-LC: more than 1000 rotations, stop the motor, start again
+#define Task_recal           1        // ReCalScanIF() burst, without the drift tracker
+#define Task_temp            2        // temperature reading of the drift tracker
+#define Task_osc             3        // ESIOSC trim step
+#define Task_display         4        // LCD refresh
+#define Task_sample          5        // start of a temperature reading, the ADC12 interrupt posts Task_temp
+#define Task_save            6        // Info_Save(), the counts of the ISRs into INFO FRAM with their CRC
+#define Task_num             7
+
+typedef struct
+{
+	void (*Run)(void);                // NULL: never posted in this meter
+	unsigned int Deadline;            // ACLK cycles from the post, Task_Late[] only
+} Task_Entry;
+
+extern const Task_Entry Task_List[Task_num];	// of the meter, in main.c
+extern volatile unsigned char Task_Sleeping;	// 0: a task or the code before Task_Init() runs or waits
+
+void Task_Init(void);
+unsigned char Task_Post(unsigned char Task);	// in an interrupt, 1: leave the LPM, Task_Run() sleeps
+void Task_Run(void);                  // sleep until an event, run the tasks of the wake
+unsigned int Task_Idle(void);         // LPM bits for the clock users
+
+#endif /* TASK_H_ */
@@ -0,0 +1,61 @@
+/*
+ * Trace.c
+ *
+ * Entry and exit trace of the interrupt service routines. The ISRs do not nest,
+ * so the entry of the running one is kept in Trace_entry until its Trace_Out().
+ *
+ */
+
+#include "msp430fr6989.h"
+#include "Trace.h"
+
+#if Isr_trace
+#pragma PERSISTENT(Trace_Log)
+Trace_Buffer Trace_Log = {0};						// FRAM, kept over a reset
+
+unsigned int  Trace_entry;							// TA2R at the entry of the running ISR
+unsigned char Trace_late;
+
+
+static unsigned int Trace_Stamp(void)
+{
+	unsigned int Stamp;
+
+	do { Stamp = TA2R; } while (Stamp != TA2R);		// TA2 runs on ACLK, read until two reads agree
+	return Stamp;
+}
+
+
+static void Trace_Write(unsigned char Isr, unsigned int Exit)
+{
+	Trace_Record *Record = &Trace_Log.Record[Trace_Log.Count & (Trace_size - 1)];
+
+	Record->Isr = Isr;
+	Record->Late = Trace_late;
+	Record->Entry = Trace_entry;
+	Record->Exit = Exit;
+	Trace_Log.Count++;								// last: a dump in between shows the record as not written
+}
+
+
+void Trace_Init(void)
+{
+	TA2CTL = TASSEL0 + MC1 + TACLR + TAIE;			// ACLK, continuous mode, the overflow records; Flow_Init() keeps it running
+	Trace_entry = Trace_Stamp();
+	Trace_late = Trace_late_none;
+	Trace_Write(Trace_reset, Trace_entry);
+}
+
+
+void Trace_In(unsigned int Late)
+{
+	Trace_entry = Trace_Stamp();
+	Trace_late = (Late <= Trace_late_none) ? Late : Trace_late_none - 1;	// a later trigger than the byte holds: 254
+}
+
+
+void Trace_Out(unsigned char Isr)
+{
+	Trace_Write(Isr, Trace_Stamp());
+}
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Trace.h
+ *
+ * Entry and exit trace of the interrupt service routines, the same file in every meter project.
+ *
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+// A traced ISR calls Trace_In() first and Trace_Out() last, before every return. Trace_Out()
+// writes one record into the ring of Trace_Log in FRAM: the ISR, the latency from its trigger
+// and TA2R at the entry and at the exit, ACLK cycles of 30.5 us. The ring keeps the last
+// Trace_size records over a reset; Trace_Init() writes a Trace_reset record, where the time
+// of the records starts again. The latency is known for the timers only: TA0R and TA3R count
+// ACLK/8 from the CCR0 match (8 cycles resolution), TA2R from the overflow. The TA2 overflow
+// interrupt is traced as well, so no two records are more than a TA2 period (2 s) apart. The
+// host decoder (ESI_HOST_SIM/TraceDec.c) reads a TI-TXT memory dump of Trace_Log.
+// Trace_Init() starts TA2 before the calibration, Flow_Init() and Task_Init() keep it running.
+// Cost per ISR: the two calls, two double reads of TA2R and 6 bytes of FRAM, a bounded time
+// without loops; the TA2 overflow wakes the CPU every 2 s without the flow meter.
+// 0: no trace.
+#ifndef Isr_trace
+#define Isr_trace            0
+#endif
+#define Trace_size           256      // records, power of 2: 1.5 KB of FRAM
+#define Trace_late_none      0xFF     // the trigger time of the ISR is not known (or TA2R is 255 at the overflow)
+
+// Records
+#define Trace_esi            0        // ISR_ESCAN_IF
+#define Trace_ta0            1        // Timer_A: temperature period, ReCal time out
+#define Trace_ta1            2        // Timer1_A: I2C time out
+#define Trace_ta2            3        // Timer2_A: TA2 overflow
+#define Trace_ta3            4        // Timer3_A: display refresh
+#define Trace_i2c            5        // USCI_B0_ISR
+#define Trace_port1          6        // PORT1_ISR
+#define Trace_adc            7        // ADC12_ISR
+#define Trace_reset          8        // Trace_Init(), Entry and Exit: TA2R
+#define Trace_num            9
+
+typedef struct
+{
+	unsigned char Isr;
+	unsigned char Late;               // ACLK cycles from the trigger to the entry, Trace_late_none: not known
+	unsigned int  Entry;              // TA2R
+	unsigned int  Exit;
+} Trace_Record;
+
+typedef struct
+{
+	unsigned long Count;              // records written, the next one goes to Record[Count % Trace_size]
+	Trace_Record  Record[Trace_size];
+} Trace_Buffer;
+
+extern Trace_Buffer Trace_Log;
+
+void Trace_Init(void);
+void Trace_In(unsigned int Late);     // first in the ISR, ACLK cycles from the trigger
+void Trace_Out(unsigned char Isr);    // last in the ISR
+
+#endif /* TRACE_H_ */
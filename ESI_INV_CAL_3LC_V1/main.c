@@ -29,23 +29,77 @@
 #include "LCD.h"
 #include "ScanIF.h"
 #include "ESI_ESIOSC.h"
+#include "Task.h"
+#include "Trace.h"
 
 #define Time_out  8192    					// 2 sec
 #define Time_to_Recal 8192  				// 2 sec for testing, 40960 for 10 sec
 
 
 extern 	unsigned char  Status_flag ;
+#if Drift_tracker
+extern 	unsigned char  Drift_probe ;
+#endif
 
 char Power_measure = 0;
 signed int  rotation_counter = 0;
 unsigned char ReCal_Flag ;
+#if Display_task
+#if !Task_scheduler
+unsigned char Display_due;						// the display task is to draw the count
+#endif
+unsigned int  Display_count;					// ESICNT1 at the last refresh
+#endif
+#if (Flow_meter || Skip_detect) && !Task_scheduler
+unsigned char Save_due;							// Info_Save() is to write the counts of the ISRs
+#endif
 
 
 void Set_Clock(void);
 void Port_Init(void);
 void Set_Timer_A(void);
 void Check_debug(void);
+void Display_Init(void);
+void Display_Update(void);
+void Temp_Task(void);
+void Recal_Task(void);
 
+#if Task_scheduler
+const Task_Entry Task_List[Task_num] =
+{
+	{0,				 0},						// Task_demo, the 2-LC motor demo
+#if AFE2_enable && !Drift_tracker
+	{Recal_Task,	 328},						// Task_recal, 10 ms
+#else
+	{0,				 0},
+#endif
+#if Temp_comp
+	{Temp_Task,		 328},						// Task_temp, 10 ms after the last conversion
+#else
+	{0,				 0},
+#endif
+#if Osc_tracker
+	{Osc_Update,	 32768},					// Task_osc, 1 s: one trim step of Temp_period
+#else
+	{0,				 0},
+#endif
+#if Display_task
+	{Display_Update, 16384},					// Task_display, 0.5 s
+#else
+	{0,				 0},
+#endif
+#if Temp_comp
+	{Temp_Start,	 3277},						// Task_sample, 0.1 s
+#else
+	{0,				 0},
+#endif
+#if Flow_meter || Skip_detect
+	{Info_Save,		 32768},					// Task_save, 1 s: the CRC runs after the other tasks
+#else
+	{0,				 0},
+#endif
+};
+#endif
 
 void Port_Init()
 {
@@ -128,12 +182,88 @@ void Set_Timer_A(void)
 }
 
 
+#if Display_task
+void Display_Init(void)
+{
+/*  TA3 wakes the display task every Display_period,
+ *  with Display_period 0 it is not started: only the P1.2 key draws the count.
+ */
+
+	Display_count = ESICNT1;
+	TA3CTL = TASSEL0 + ID0 + ID1 + TACLR;		// Aclk divided by 8;
+	TA3CCR0 = Display_period - 1;
+	TA3CCTL0 = CCIE;
+	if (Display_period) TA3CTL |= MC0;
+}
+
+
+void Display_Update(void)						// the display task, in the main loop
+{
+#if !Task_scheduler
+	Display_due = 0;
+#endif
+	Display_count = ESICNT1;
+#if Totalizer
+	lcd_display_num(Tot_Rotations(),LCD_total);	// forward minus reverse rotations of the totalizer, 8 digits
+#else
+	rotation_counter = ESICNT1;     			// for every complete rotation, there are 6 states change and so add +1 six times
+
+	if (rotation_counter < 0)
+		{rotation_counter = -1*rotation_counter /6;}
+	else
+		{rotation_counter = rotation_counter / 6;}
+
+	lcd_display_num(rotation_counter,0);
+#endif
+}
+#endif
+
+
+#if Temp_comp
+void Temp_Task(void)							// temperature reading is due
+{
+	Temp_Update();
+#if Totalizer && !Display_task
+	lcd_display_num(Tot_Rotations(),LCD_total);	// reverse flow has no Q6 events to update the LCD
+#endif
+}
+#endif
+
+#if AFE2_enable && !Drift_tracker
+void Recal_Task(void)							// the TA0 interrupt has set BIT7 of ReCal_Flag
+{
+	if(ReCal_Flag&BIT6)
+		{ReCal_Flag &= ~BIT7;}					// Reset Bit7 for timer call
+
+	TA0CCR0 = Time_out;                   		// 2 sec for testing; generate a time out when stop rotating
+	TA0CTL |= MC0;
+
+	ReCalScanIF();           					// to do runtime calibration with AFE2
+
+	TA0CTL &= ~MC0;
+	TA0CTL |= TACLR;                      		// Reset Timer
+	TA0CCR0 = Time_to_Recal;              		// 2 sec for testing
+	TA0CTL |= MC0;								// timer re-start for ReCal.
+	TA0CCTL0 |= CCIE;
+
+	ReCal_Flag = 0;								// ReCal of AFE1 is done, reset all flags.
+
+	__bic_SR_register(GIE);						// Ensure no abnormal interrupt before entering LPM;
+	ESIINT2 &= ~ESIIFG5;                  		// clear the Q6 flag
+	ESIINT1 |= ESIIE5;							// Enable Q6 INT for in case of Time out.
+}
+#endif
+
+
 void main(void)
 {
 	WDTCTL = WDTPW + WDTHOLD;					// disable Watchdog
 
 	Port_Init();
 	Set_Clock();
+#if Isr_trace
+	Trace_Init();								// entry and exit of the ISRs into Trace_Log, from the calibration on
+#endif
 
 	P1IES |= BIT2;								// Set P1.2 as key input
 	P1IFG &= ~BIT2;								// User can press the black button to toggle switch on/off the LCD
@@ -154,62 +284,101 @@ void main(void)
 	Status_flag |= BIT3;						// indicating Calibration of DAC process completed
 
 
-#if AFE2_enable
+#if Drift_tracker
+	 Drift_Init();								// AFE2 drift tracker on the Q6 interrupt, no ReCalScanIF() burst
+#if Temp_comp
+	 Temp_Init();
+#if Osc_tracker
+	 Osc_Init();
+#endif
+#if Rate_governor
+	 Rate_Init();
+#endif
+	 Set_Timer_A();
+	 TA0CCR0 = Temp_period;						// temperature readings for the drift tracker
+#endif
+#elif AFE2_enable
 	 Set_Timer_A();                				// set and start timer of 10 sec INT
 #endif
+#if Flow_meter
+	 Flow_Init();								// TA2 time base of the flow rate
+#endif
 
 
  	 ESIINT2 &= ~ESIIFG5;                   	// clear INT flag of Q6 of PSM
  	 ESIINT1 |= ESIIE5;							// enable INT of Q6
  	 ESICTL  |= ESIEN;            				// switch on ESI and will always on till battery drain off
+#if Totalizer
+	 Tot_Init();								// 32-bit forward and reverse volumes
+#endif
+#if Skip_detect
+	 Skip_Init();								// a TSM rate too slow for the flow
+#endif
+#if Display_task
+	 Display_Init();							// LCD refresh out of the ESI interrupt
+#endif
+#if Task_scheduler
+	 Task_Init();								// the events of the interrupts run the tasks below
+#endif
 
 	while(1)
 	{
+#if Task_scheduler
+	Task_Run();									// one task, or the deepest LPM until an interrupt posts one
+#else
 
 	__bis_SR_register(LPM3_bits+GIE);   		//	 wait for the ESISTOP flag
 
-#if AFE2_enable
-
-	if(ReCal_Flag&BIT7)
+#if Temp_comp
+	if (ReCal_Flag&BIT4)						// temperature reading is due
 	{
-	 if(ReCal_Flag&BIT6)
-		{ReCal_Flag &= ~BIT7;}              	// Reset Bit7 for timer call
-
-	  TA0CCR0 = Time_out;                   	// 2 sec for testing; generate a time out when stop rotating
-	  TA0CTL |= MC0;
-
-	  ReCalScanIF();           					// to do runtime calibration with AFE2
-
-	  TA0CTL &= ~MC0;
-	  TA0CTL |= TACLR;                      	// Reset Timer
-	  TA0CCR0 = Time_to_Recal;              	// 2 sec for testing
-	  TA0CTL |= MC0;							// timer re-start for ReCal.
-	  TA0CCTL0 |= CCIE;
-
-	  ReCal_Flag = 0;							// ReCal of AFE1 is done, reset all flags.
+	  ReCal_Flag &= ~BIT4;
+	  Temp_Task();
+#if Osc_tracker
+	  Osc_Update();								// ESIOSC drift, one EsioscReCal() step per wake
+#endif
+	}
+#endif
 
-	  __bic_SR_register(GIE);					// Ensure no abnormal interrupt before entering LPM;
-	  ESIINT2 &= ~ESIIFG5;                  	// clear the Q6 flag
-	  ESIINT1 |= ESIIE5;						// Enable Q6 INT for in case of Time out.
+#if Display_task
+	if (Display_due)
+	  Display_Update();							// the count has moved, or the LCD was switched on
+#endif
 
+#if Flow_meter || Skip_detect
+	if (Save_due)								// the TA2 overflow or a jump found new counts
+	{
+	  Save_due = 0;
+	  Info_Save();
 	}
-
 #endif
 
+#if AFE2_enable && !Drift_tracker
+	if(ReCal_Flag&BIT7)
+	  Recal_Task();
+#endif
+#endif
 	}
 }
 
 
-
 #pragma vector=ESCAN_IF_VECTOR
 __interrupt void ISR_ESCAN_IF(void)
 {
+#if Isr_trace
+   Trace_In(Trace_late_none);
+#endif
 
    switch (ESIIV)
    {
    case 0x02:  if (ESIINT1&ESIIE1)
 
 				{	ESIINT2 &= ~ESIIFG1;                 	// clear the ESISTOP flag
+#if Drift_tracker
+					if (Drift_probe)
+					{Drift_Probe_End();						// AFE2 result of the drift probe, stay in LPM3
+					break;}
+#endif
 
 					if(ReCal_Flag&BIT6)
 					{TA0CTL |= TACLR;                   	// Reset Timer to prevent abnormal time out.
@@ -221,7 +390,11 @@ __interrupt void ISR_ESCAN_IF(void)
 
    case 0x04:  break;
    case 0x06:  break;
-   case 0x08:  break;
+   case 0x08:
+#if Totalizer
+			   Tot_Threshold();						// ESICNT1 reached ESITHR1 or ESITHR2, stay in LPM3
+#endif
+			   break;
 
    case 0x0A: break;
    case 0x0C: if(ESIINT1&ESIIE5)
@@ -236,7 +409,20 @@ __interrupt void ISR_ESCAN_IF(void)
 
 						if(Status_flag&BIT3)                // Check for completion of Calibration of DAC
 						{							    	// If yes, LCD is to display the rotation number
-
+#if Drift_tracker
+							Drift_Probe_Start();			// AFE2 drift probe on the next TSM sequence
+#endif
+#if Rate_governor
+							Rate_Q6();						// TSM rate for the measured state interval
+#endif
+#if Flow_meter
+							Flow_Q6();						// period of the rotation ending at this state
+#endif
+#if Display_task
+															// the display task draws the count
+#elif Totalizer
+							lcd_display_num(Tot_Rotations(),LCD_total);	// forward minus reverse rotations of the totalizer, 8 digits
+#else
 							rotation_counter = ESICNT1;     // for every complete rotation, there are 6 states change and so add +1 six times
 
 							if (rotation_counter < 0)
@@ -245,18 +431,42 @@ __interrupt void ISR_ESCAN_IF(void)
 								{rotation_counter = rotation_counter / 6;}
 
 							lcd_display_num(rotation_counter,0);
+#endif
 						}
 
-
+#if Display_task && Drift_tracker
+						if (!(Status_flag&BIT3))		// InitScanIF() waits for the Q6 events, the normal operation not
+#elif Task_scheduler
+						if (!Task_Sleeping)				// InitScanIF() or ReCalScanIF() waits for the Q6 events, the main loop not
+#endif
 						_low_power_mode_off_on_exit();       // exit low power mode;
    	   	   	   	   }
 
 	          break;
-   case 0x0E: break;
-   case 0x10: break;
+   case 0x0E:
+#if Skip_detect
+			   if (Skip_Event())						// ESICNT2 counted a jump over a sensor state
+			   {
+#if Task_scheduler
+				   if (Task_Post(Task_save))
+#else
+				   Save_due = 1;
+#endif
+				   _low_power_mode_off_on_exit();
+			   }
+#endif
+			   break;
+   case 0x10:
+#if Totalizer
+			   Tot_Wrap();							// ESICNT0 wrapped to zero, stay in LPM3
+#endif
+			   break;
    case 0x12: break;
    }
 
+#if Isr_trace
+   Trace_Out(Trace_esi);
+#endif
 }
 
 
@@ -264,6 +474,20 @@ __interrupt void ISR_ESCAN_IF(void)
 #pragma vector = TIMER0_A0_VECTOR
 __interrupt void Timer_A (void)
 {
+#if Isr_trace
+	Trace_In((TA0R == TA0CCR0) ? 0 : (TA0R + 1) << 3);	// ACLK/8 cycles from the CCR0 match
+#endif
+#if Temp_comp
+#if Rate_governor
+	Rate_Tick();
+#endif
+#if Task_scheduler
+	if (Task_Post(Task_sample))						  // temperature reading, the timer keeps running
+#else
+	ReCal_Flag |= BIT4;								  // temperature reading, the timer keeps running
+#endif
+	_low_power_mode_off_on_exit();
+#else
     if (ReCal_Flag&BIT6)
     {
     	ReCal_Flag |= BIT1;                           // Time out
@@ -272,16 +496,96 @@ __interrupt void Timer_A (void)
     else
     {
     	ReCal_Flag |= BIT7;                   		  // indicate the need to perform runtime calibration
+#if Task_scheduler
+    	Task_Post(Task_recal);
+#endif
     }
 
 	TA0CTL &= ~MC0;									  // disable timer
 	_low_power_mode_off_on_exit();       	      	  // exit low power mode from ReCal_ScanIF ;
+#endif
+#if Isr_trace
+	Trace_Out(Trace_ta0);
+#endif
 }
 
+#if Display_task
+// Timer A3 interrupt service routine, display refresh
+#pragma vector = TIMER3_A0_VECTOR
+__interrupt void Timer3_A (void)
+{
+#if Isr_trace
+	Trace_In((TA3R == TA3CCR0) ? 0 : (TA3R + 1) << 3);	// ACLK/8 cycles from the CCR0 match
+#endif
+	if (ESICNT1 != Display_count)					  // the count has moved since the last refresh
+	{
+#if Task_scheduler
+		if (Task_Post(Task_display))
+#else
+		Display_due = 1;
+#endif
+		_low_power_mode_off_on_exit();
+	}
+#if Isr_trace
+	Trace_Out(Trace_ta3);
+#endif
+}
+#endif
+
+#if Task_scheduler && Temp_comp
+// ADC12 interrupt service routine, end of the conversion sequence of the temperature reading
+#pragma vector = ADC12_VECTOR
+__interrupt void ADC12_ISR(void)
+{
+#if Isr_trace
+	Trace_In(Trace_late_none);
+#endif
+	Temp_Sample();
+#if Osc_tracker
+	Task_Post(Task_osc);
+#endif
+	if (Task_Post(Task_temp))
+		_low_power_mode_off_on_exit();
+#if Isr_trace
+	Trace_Out(Trace_adc);
+#endif
+}
+#endif
+
+#if Flow_meter || Isr_trace
+// Timer A2 interrupt service routine, overflow of the flow rate time base and of the trace stamps
+#pragma vector = TIMER2_A1_VECTOR
+__interrupt void Timer2_A (void)
+{
+#if Isr_trace
+	Trace_In(TA2R);								  // ACLK from the overflow
+#endif
+#if Flow_meter
+	if ((TA2IV == TA2IV_TAIFG) && Flow_Overflow())
+	{
+#if Task_scheduler
+		if (Task_Post(Task_save))
+#else
+		Save_due = 1;
+#endif
+		_low_power_mode_off_on_exit();
+	}
+#else
+	TA2CTL &= ~TAIFG;
+#endif
+#if Isr_trace
+	Trace_Out(Trace_ta2);
+#endif
+}
+#endif
+
 // Port 1 interrupt service routine
 #pragma vector=PORT1_VECTOR
 __interrupt void PORT1_ISR(void)
 {
+#if Isr_trace
+    Trace_In(Trace_late_none);
+#endif
     P1IFG &= ~BIT2;
     Power_measure ^= BIT0;
 
@@ -289,14 +593,31 @@ __interrupt void PORT1_ISR(void)
     {LCDCCTL0 &= ~LCDON;
     ESIINT1 &= ~ESIIE5;								 // toggle INT of Q6
 	TA0CTL &= ~MC0;									 // toggle on/off timer
+#if Display_task
+	TA3CTL &= ~MC0;									 // no display refresh
+#endif
     }
     else
     {LCDCCTL0 |= LCDON;
     ESIINT1 |= ESIIE5;								 // toggle INT of Q6
 	TA0CTL |= MC0;									 // toggle on/off timer
+#if Display_task
+	if (Display_period) TA3CTL |= MC0;
+#if Task_scheduler
+	if (Task_Post(Task_display))					 // draw the count at once
+		_low_power_mode_off_on_exit();
+#else
+	Display_due = 1;								 // draw the count at once
+#endif
+#endif
     }
 
+#if !(Task_scheduler && Display_task)
    _low_power_mode_off_on_exit();       	      	 // exit low power mode from ReCal_ScanIF ;
+#endif
+#if Isr_trace
+   Trace_Out(Trace_port1);
+#endif
 
 }
 
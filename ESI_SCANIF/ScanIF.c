@@ -0,0 +1,2215 @@
+/*
+ * This code is a reference design for rotational flow meters with LC sensors.
+ * The main board undergoes Auto TSM setting once it is powered up, and optimizes
+ * the reference voltage setting for DAC while the rotor disc turns.
+ *
+ * All meter projects build this one file from ESI_SCANIF: the number of LC sensors
+ * (1 to 4), the TSM state list, the sensor states of the disc, the INV or non-INV
+ * comparators and the TSM rates are set by ScanIF_Layout.h of the project. All per-channel variables are arrays over
+ * the channels, ESI_channels of them.
+ *
+ * When measuring the current consumption, remove all jumpers of the main board except for the jumper of GND above J401.
+ * and tap the current meter to the jumper 3V3.
+ * To measure the current consumption of ESI, without LCD and I2C,
+ * press the black button on the main board and remove the I2C cable.
+ *
+ * To turn on the LCD again, press the black button to toggle it.
+ *
+ * Texas Instruments
+ *
+ * Author: Thomas Kot
+ * Date  : July 2014
+ *
+ *
+ */
+
+
+#include "msp430fr6989.h"
+#include "ScanIF.h"
+#include "ScanIF_Layout.h"
+#include "ESI_ESIOSC.h"
+#include "LCD.h"
+#include "IIC.h"
+
+
+ // PSM state table, generated from ESI_HOST_SIM/psm/<meter>.psm (make psm)
+#include "PSM_Table.h"
+
+
+#if (ESI_channels < 1) || (ESI_channels > 4)
+#error "ScanIF_Layout.h: ESI_channels is 1 to 4"
+#endif
+
+
+#define Search_range  8
+#define Separation_factor   4
+#define delta_level   10								// largest move of AFE1 by a re-calibration
+
+// The DAC registers of channel ch are ESIDAC1R<2ch>, ESIDAC1R<2ch+1> for AFE1 and
+// ESIDAC2R<2ch>, ESIDAC2R<2ch+1> for AFE2, which follow ESIDAC1R7. Its comparator
+// outputs are ESIOUT<ch> and ESIOUT<ch+4>.
+#define AFE1          0
+#define AFE2          8
+#define DAC_R(Bank, i)      (&ESIDAC1R0)[(Bank) + (i)]
+#define Out_bit(Bank, ch)   (ESIOUT0 << ((Bank)/2 + (ch)))
+#define DAC_Set(Bank, ch, Level)  (DAC_R(Bank, 2*(ch)+1) = DAC_R(Bank, 2*(ch)) = (Level))	// both levels of a channel
+#define DAC_Limit(Level)    ((Level) < 0 ? 0 : ((Level) > 0x0FFF ? 0x0FFF : (Level)))	// int level into the 12 bit DAC range
+#define All_channels  ((1 << ESI_channels) - 1)				// Out_bit(AFE1, ch) of all channels
+
+#if ESI_inverted
+#define AFE1_INV      ESICA1INV
+#define AFE2_INV      ESICA2INV
+#define Out_sense     0x0000							// ESIPPU ^ Out_sense: ESIOUTx is 1 below the DAC level
+#define Inv(x)        (x)								// hysteresis: "-" below and "+" above the middle for INV
+#else
+#define AFE1_INV      0
+#define AFE2_INV      0
+#define Out_sense     0x00FF
+#define Inv(x)        (-(int)(x))
+#endif
+
+#if Noise_common
+#define Noise_levels  1
+#define Ch_noise(ch)  Noise_level[0]
+#else
+#define Noise_levels  ESI_channels
+#define Ch_noise(ch)  Noise_level[ch]
+#endif
+
+int AFE1_base[ESI_channels];
+int AFE2_base[ESI_channels];
+int AFE2_drift[ESI_channels];
+
+int AFE2_offset[ESI_channels];					// AFE2 - AFE1 comparator offset, used by FindDAC_Dual()
+unsigned char AFE2_offset_valid = 0;
+
+int AFE2_base_Max[ESI_channels], AFE2_base_Min[ESI_channels];
+
+
+unsigned char  	Status_flag = 0;				// BITn: separation of channel n found by Set_DAC(), main() uses the next bit
+unsigned int  	STATE_SEPARATION[ESI_channels];
+
+unsigned int    Noise_level[Noise_levels];
+unsigned int    Set_DAC_loops = 0;				// iterations of the last Set_DAC() after the separation was found
+
+unsigned int    Max_DAC[ESI_channels], Min_DAC[ESI_channels];
+
+
+#if Snapshot_enable
+
+#define Snapshot_checks       4					// FindDAC() measurements to confirm the snapshot
+#define Snapshot_ESICLKFQ_range  2				// allowed change of the ESIOSC trimming
+#define Snapshot_noise_margin 3					// noise levels a measurement may lie beyond Max_DAC / Min_DAC
+
+struct Cal_snapshot
+{
+	unsigned int  Version;
+	unsigned int  TSM[TSM_states];				// state list with the tuned delay chains
+	unsigned int  DAC[2*ESI_channels];			// ESIDAC1R0.. of the channels
+	unsigned int  Noise_level[Noise_levels];
+	unsigned int  Max_DAC[ESI_channels], Min_DAC[ESI_channels];		// signal range found by Set_DAC()
+	int           AFE1_base[ESI_channels], AFE2_base[ESI_channels];
+	int           AFE2_base_Max[ESI_channels], AFE2_base_Min[ESI_channels];	// for the AFE2 re-calibration
+	unsigned int  ESICLKFQ;						// trimming of ESIOSC by EsioscInit()
+	unsigned int  CRC;							// CRC-16-CCITT of the fields above
+};
+
+// PERSISTENT: zero when the device is programmed, not cleared by the C start-up like
+// an uninitialized variable. LOCATION keeps it in INFOA of lnk_msp430fr6989.cmd.
+#pragma PERSISTENT(Cal_Snapshot)
+#pragma LOCATION(Cal_Snapshot, 0x1980)
+struct Cal_snapshot Cal_Snapshot = {0};			// kept over a reset, written by Save_Snapshot()
+
+#endif
+
+
+#if AFE2_enable
+extern unsigned char ReCal_Flag ;
+extern signed int  rotation_counter;
+#endif
+
+
+void SAR_Step(unsigned char , unsigned int , unsigned int , unsigned int );
+void FindDAC(unsigned char );
+void FindDAC_Dual(void);
+void FindDAC_Offset(void);
+void FindDAC_Fast_Range(int );
+void FindDAC_Fast_Successive(int );
+void ReCalScanIF(void);
+void TSM_Auto_cal(void);
+void TSM_Set_delay(unsigned char , unsigned char , unsigned int );
+void Find_Noise_level(void);
+void Set_DAC(void);
+unsigned int Info_CRC(const unsigned char* , unsigned int );
+unsigned int Snapshot_CRC(void);
+void Save_Snapshot(void);
+unsigned char Restore_Snapshot(void);
+
+void AFE2_FindDAC_Fast_Successive(int );
+void AFE1_Level(unsigned char , int );
+void Drift_Shift(unsigned char , int );
+unsigned int Temp_Read(void);
+long Tot_Delta(unsigned int , unsigned int );
+unsigned long Flow_Stamp(void);
+unsigned char Info_Copy(unsigned char , unsigned int , unsigned int );
+unsigned int Flow_CRC(unsigned char );
+unsigned int Skip_CRC(unsigned char );
+unsigned int Temp_CRC(unsigned char );
+
+
+// One step of the successive approximation on every channel of a bank, Below the
+// comparator outputs of the last TSM sequence as ESIPPU ^ Out_sense.
+
+void SAR_Step(unsigned char Bank, unsigned int Below, unsigned int DAC_BIT, unsigned int Prev_DAC_BIT)
+{
+	unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		if (!(Below&Out_bit(Bank, ch)))
+			{ DAC_Set(Bank, ch, DAC_R(Bank, 2*ch) | DAC_BIT); }			// keep the previous bit and set the next bit
+		else
+			{ DAC_Set(Bank, ch, DAC_R(Bank, 2*ch) ^ Prev_DAC_BIT); }	// reset the previous bit and set the next bit
+	}
+}
+
+
+void FindDAC(unsigned char Search_mode)
+{
+	unsigned int i;
+	unsigned int DAC_BIT = 0x0800, Prev_DAC_BIT = 0x0C00;	// DAC Level tester, using Sucessive approx approach
+	unsigned char ch;
+
+	if (Search_mode == DAC_search_dual)
+	{
+		FindDAC_Dual();
+		return;
+	}
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ DAC_Set(AFE1, ch, DAC_BIT); }		// set as the middle point
+
+	ESIINT2 &= ~ESIIFG1;                	// clear the ESISTOP flag
+	ESIINT1 |= ESIIE1;						// enable ESISTOP INT
+	ESICTL  |= ESIEN;						// switch on Scan Interface.
+
+	for(i = 0; i<12; i++)				 	// test 12 times as 12 bit DAC
+	{
+		__bis_SR_register(LPM3_bits+GIE);   //	 wait for the ESISTOP flag
+
+		DAC_BIT /= 2 ;						// right shift one bit
+		SAR_Step(AFE1, ESIPPU ^ Out_sense, DAC_BIT, Prev_DAC_BIT);
+		Prev_DAC_BIT /= 2;					// right shift one bit
+	}
+
+	ESICTL &= ~ESIEN;						// switch off ESI Interface.
+	ESIINT1 &= ~ESIIE1;
+}
+
+
+// Same result as FindDAC() in 8 instead of 12 TSM sequences.
+// Each sequence compares the signal of a channel with two probe points: AFE1 at
+// one third and AFE2 at two thirds of the remaining interval, so every sequence
+// splits the interval in three. The AFE2 probe is corrected by the comparator
+// offset AFE2_offset, which the first call measures with FindDAC_Offset().
+// An AFE2 probe that the offset pushes out of 0..4095 is limited to the DAC range
+// and its result not used: that sequence splits the interval in two on AFE1 only.
+// The result is left in ESIDAC1R like FindDAC().
+
+void FindDAC_Dual(void)
+{
+	unsigned int Low[ESI_channels], High[ESI_channels];		// signal level of a channel is in [Low, High)
+	unsigned int Probe[ESI_channels], Third, Below;
+	unsigned int Limited;									// BITn: AFE2 probe of channel n limited
+	int Level;
+	unsigned char ch, Open = 1;
+
+	if (!AFE2_offset_valid)
+	{
+		FindDAC_Offset();
+		return;
+	}
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ Low[ch] = 0;  High[ch] = 0x1000; }
+
+	ESIAFE |= ESIDAC2EN + ESICA2EN + AFE2_INV;	// AFE2 for the second probe
+	ESIINT2 &= ~ESIIFG1;                	// clear the ESISTOP flag
+	ESIINT1 |= ESIIE1;						// enable ESISTOP INT
+	ESICTL  |= ESIEN;						// switch on Scan Interface.
+
+	while (Open)
+	{
+		Limited = 0;
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Third = (High[ch] - Low[ch] + 2) / 3;
+			Probe[ch] = Low[ch] + Third;
+			Level = (int)(Probe[ch] + Third) + AFE2_offset[ch];
+			if      (Level < 0)      { Level = 0;       Limited |= BIT0 << ch; }
+			else if (Level > 0x0FFF) { Level = 0x0FFF;  Limited |= BIT0 << ch; }
+			DAC_Set(AFE1, ch, Probe[ch]);
+			DAC_Set(AFE2, ch, Level);
+		}
+
+		__bis_SR_register(LPM3_bits+GIE);   	// wait for the ESISTOP flag
+
+		Below = ESIPPU ^ Out_sense;
+		Open = 0;
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			if (High[ch] - Low[ch] > 1)
+			{
+				Third = Probe[ch] - Low[ch];
+				if (Below&Out_bit(AFE1, ch))		// below the AFE1 probe
+					{ High[ch] = Probe[ch]; }
+				else if (Limited & (BIT0 << ch))	// AFE2 probe not where it should be, AFE1 only
+					{ Low[ch] = Probe[ch]; }
+				else if ((Probe[ch] + Third < High[ch]) && !(Below&Out_bit(AFE2, ch)))
+					{ Low[ch] = Probe[ch] + Third; }	// above the AFE2 probe
+				else
+					{ Low[ch] = Probe[ch];
+					  if (Probe[ch] + Third < High[ch]) { High[ch] = Probe[ch] + Third; }
+					}
+			}
+			if (High[ch] - Low[ch] > 1) { Open = 1; }
+		}
+	}
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ DAC_Set(AFE1, ch, Low[ch]); }
+
+	ESICTL &= ~ESIEN;						// switch off ESI Interface.
+	ESIINT1 &= ~ESIIE1;
+	ESIAFE &= ~(ESIDAC2EN + ESICA2EN + AFE2_INV);
+}
+
+
+// 12 bit successive approximation like FindDAC(), on AFE1 and AFE2 in parallel.
+// The difference of the two results is the AFE2 comparator offset.
+
+void FindDAC_Offset(void)
+{
+	unsigned int i, Below;
+	unsigned int DAC_BIT = 0x0800, Prev_DAC_BIT = 0x0C00;
+	unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		DAC_Set(AFE1, ch, DAC_BIT);				// set as the middle point
+		DAC_Set(AFE2, ch, DAC_BIT);
+	}
+
+	ESIAFE |= ESIDAC2EN + ESICA2EN + AFE2_INV;
+	ESIINT2 &= ~ESIIFG1;                	// clear the ESISTOP flag
+	ESIINT1 |= ESIIE1;						// enable ESISTOP INT
+	ESICTL  |= ESIEN;						// switch on Scan Interface.
+
+	for(i = 0; i<12; i++)				 		// test 12 times as 12 bit DAC
+	{
+		__bis_SR_register(LPM3_bits+GIE);   	// wait for the ESISTOP flag
+
+		DAC_BIT /= 2 ;							// right shift one bit
+		Below = ESIPPU ^ Out_sense;
+		SAR_Step(AFE1, Below, DAC_BIT, Prev_DAC_BIT);
+		SAR_Step(AFE2, Below, DAC_BIT, Prev_DAC_BIT);
+		Prev_DAC_BIT /= 2;						// right shift one bit
+	}
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ AFE2_offset[ch] = (int)DAC_R(AFE2, 2*ch) - (int)DAC_R(AFE1, 2*ch); }
+	AFE2_offset_valid = 1;
+
+	ESICTL &= ~ESIEN;						// switch off ESI Interface.
+	ESIINT1 &= ~ESIIE1;
+	ESIAFE &= ~(ESIDAC2EN + ESICA2EN + AFE2_INV);
+}
+
+
+// Successive approximation of the last Range_num bits of every channel around the
+// level in ESIDAC1R<2ch>, one bit per TSM sequence. The bank is a constant in the
+// loop, so the compiler unrolls it over the channels; AFE2_FindDAC_Fast_Successive()
+// is the same on AFE2. A step is stopped at 0 and 4095: the Set_DAC_wide_steps
+// search near either end would otherwise wrap in the 12 bit DAC field.
+
+void FindDAC_Fast_Successive(int Range_num)
+{
+	unsigned int i, Below;
+	unsigned int DAC_BIT = 0x0001 << (Range_num - 1);	// DAC Level tester, using Sucessive approx approach
+	int Level;
+	unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ DAC_Set(AFE1, ch, DAC_R(AFE1, 2*ch)); }
+
+	ESIINT2 &= ~ESIIFG1;                	// clear the ESISTOP flag
+	ESIINT1 |= ESIIE1;						// enable ESISTOP INT
+	ESICTL  |= ESIEN;						// switch on Scan Interface.
+
+	for(i = 0; i<Range_num; i++)			// test "Range_num" times as 12 bit DAC
+	{
+		__bis_SR_register(LPM3_bits+GIE);   //	 wait for the ESISTOP flag
+
+		Below = (ESIPPU ^ Out_sense) >> (AFE1/2);		// bit ch: below the DAC level, up one DAC_BIT or down one
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Level = (int)DAC_R(AFE1, 2*ch) + (int)DAC_BIT - (int)(((Below >> ch) & 1)*2*DAC_BIT);
+			DAC_Set(AFE1, ch, DAC_Limit(Level));
+		}
+
+		DAC_BIT /= 2;						// right shift one bit
+	}
+
+	ESICTL &= ~ESIEN;						// switch off ESI Interface.
+	ESIINT1 &= ~ESIIE1;
+}
+
+
+void FindDAC_Fast_Range(int Range_num)			// AFE1, from the level in ESIDAC1R
+{
+unsigned int Range;
+unsigned int Up, Down, Done, Move;					// direction and completion marks, Out_bit() of a channel
+unsigned int Below;
+unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ DAC_Set(AFE1, ch, DAC_R(AFE1, 2*ch)); }
+
+	ESIINT2 &= ~ESIIFG1;                	// clear the ESISTOP flag
+	ESIINT1 |= ESIIE1;						// enable ESISTOP INT
+	ESICTL  |= ESIEN;						// switch on Scan Interface.
+
+// This loop is to find the starting point of DAC and the direction of searching by adding or subtracting a value of "Range" into or from the DAC
+// Down / Up mark a channel whose DAC was decreased / increased, Done a channel that has
+// moved in both directions. The search is then repeated with "Range" of one, by "+/- 1 method".
+// The marks of all channels are set at once, so the loop over the channels stays small
+// enough for the compiler to unroll it.
+
+	for (Range = Range_num; ; Range = 1)
+	{
+		Up = Down = Done = 0;
+
+		while (Done != All_channels)
+		{
+			__bis_SR_register(LPM3_bits+GIE);   	// wait for the ESISTOP flag
+
+			Below = (ESIPPU ^ Out_sense) & All_channels;	// AFE1 outputs of all channels
+			Move = ~Done & All_channels;
+			Done |= Move & ((Below & Up) | (~Below & Down));	// if moved the other way before, put a completion mark
+			Down |= Move & Below;
+			Up   |= Move & ~Below;
+
+			for (ch=0; ch<ESI_channels; ch++)
+			{
+				if (!(Move&Out_bit(AFE1, ch))) continue;
+				if (Below&Out_bit(AFE1, ch))	{ DAC_Set(AFE1, ch, DAC_R(AFE1, 2*ch) - Range); }	// decrease the DAC by a value of "Range"
+				else							{ DAC_Set(AFE1, ch, DAC_R(AFE1, 2*ch) + Range); }	// increase the DAC by a value of "Range"
+			}
+		}
+
+		if (Range <= 1) break;								// "+/- 1 method completed, the loop end here
+	}
+
+	ESICTL &= ~ESIEN;						// switch off ESI Interface.
+	ESIINT1 &= ~ESIIE1;
+}
+
+
+void TSM_Auto_cal(void)
+{
+// constant and variable for TSM calibration, cycle_width and the delay chains in ScanIF_Layout.h
+#define LC_Threshold_TSM_CAL 1600
+#define Tread       (cycle_width + 2)						// ESIFCLK cycles per LC period
+#define Delay_max   (Delay_taps * 31)						// extra ESIFCLK cycles of a full delay chain
+#define Delay_step  12										// DAC step between two treads
+
+#define Delay_coarse  0
+#define Delay_bisect  1
+#define Delay_done    2
+
+unsigned int  Delay[ESI_channels], Lo[ESI_channels], Hi[ESI_channels], Start[ESI_channels];	// extra ESIFCLK cycles of the chain
+int           Level, Level_lo[ESI_channels];
+unsigned char Phase[ESI_channels], Step[ESI_channels], Above[ESI_channels];
+unsigned char ch, Busy;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// This module is to find the signal level of LC oscillation for every channel
+// using this information to calibrate the delay for TSM
+//
+// The level over the delay is a stair case: each peak of the LC oscillation gives
+// a tread one LC period (Tread) wide, and the treads step down with the decay.
+// The delay is set in the middle of the first tread above LC_Threshold_TSM_CAL.
+// Instead of walking the delay one ESIFCLK cycle at a time, the delay is stepped
+// by half a tread until the level steps by more than Delay_step (coarse), the
+// step is then located to one cycle by bisection, and the delay chain is written
+// half a tread before it, or half a tread after it when that is out of range.
+// All channels are searched in parallel, one FindDAC() per step.
+// When the whole chain shows no step, the search is repeated once with half the
+// step; a chain without any level above the threshold gets one more ACLK in front.
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Delay[ch] = Lo[ch] = Hi[ch] = Start[ch] = 0;
+		Level_lo[ch] = 0;										// 0: no level above the threshold yet
+		Phase[ch] = Delay_coarse;
+		Step[ch] = Delay_step;
+		Above[ch] = 0;
+		TSM_Set_delay(Delay_first[ch], Delay_taps, 0);
+	}
+
+	do
+	{
+
+		FindDAC(DAC_search_mode);                  // 12 bit DAC level, see ScanIF.h for the search mode
+		Busy = 0;
+
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Level = DAC_R(AFE1, 2*ch);						// ESIDAC1R0 / ESIDAC1R2 / ..
+
+			if (Phase[ch] == Delay_coarse)
+			{
+				if ((Level > LC_Threshold_TSM_CAL) && Level_lo[ch]
+				 && ((Level > Level_lo[ch] + Step[ch]) || (Level + Step[ch] < Level_lo[ch])))
+				{
+					Hi[ch] = Delay[ch];							// the step is in (Lo, Hi]
+					Phase[ch] = Delay_bisect;
+				}
+				else
+				{
+					if (Level > LC_Threshold_TSM_CAL)
+					{
+						if (!Above[ch]) { Start[ch] = Delay[ch]; }
+						Above[ch] = 1;
+						Lo[ch] = Delay[ch];
+						Level_lo[ch] = Level;
+					}
+					else
+					{	Level_lo[ch] = 0; }
+
+					Delay[ch] += Tread/2;
+					if (Delay[ch] > Delay_max)					// end of the chain, no step found
+					{
+						Delay[ch] = 0;
+						Level_lo[ch] = 0;
+						if (!Above[ch])
+						{
+							if (((&ESITSM0)[Delay_aclk[ch]] & 0xF800) != 0xF800)
+								{ (&ESITSM0)[Delay_aclk[ch]] += 0x0800; }			// one more ACLK in front of the chain
+							else
+								{ Phase[ch] = Delay_done; }
+						}
+						else if (Step[ch] == Delay_step)
+							{ Step[ch] = Delay_step/2; }		// treads too low, once more with half the step
+						else
+							{ Delay[ch] = Start[ch];			// no tread found, keep the highest level
+							  Phase[ch] = Delay_done; }
+						Above[ch] = 0;
+					}
+				}
+			}
+			else if (Phase[ch] == Delay_bisect)
+			{
+				if ((Level > Level_lo[ch] + Step[ch]) || (Level + Step[ch] < Level_lo[ch]))
+					{ Hi[ch] = Delay[ch]; }
+				else
+					{ Lo[ch] = Delay[ch]; }
+			}
+
+			if (Phase[ch] == Delay_bisect)
+			{
+				if (Hi[ch] - Lo[ch] > 1)
+				{	Delay[ch] = (Lo[ch] + Hi[ch]) / 2; }
+				else
+				{
+					if (Hi[ch] >= Start[ch] + Tread/2)			// Hi is the first cycle of the next tread
+						{ Delay[ch] = Hi[ch] - Tread/2; }
+					else if (Hi[ch] + Tread/2 <= Delay_max)
+						{ Delay[ch] = Hi[ch] + Tread/2; }
+					else
+						{ Delay[ch] = Delay_max; }
+					Phase[ch] = Delay_done;
+				}
+			}
+
+			TSM_Set_delay(Delay_first[ch], Delay_taps, Delay[ch]);
+			if (Phase[ch] != Delay_done) { Busy = 1; }
+		}
+
+	}while(Busy);
+
+
+// TSM Calibration competed
+
+}
+
+
+// Sets the tunable delay chain of Taps states from ESITSM<First> on to Taps + Extra
+// ESIFCLK cycles. The states are filled up to 32 cycles one after the other.
+
+void TSM_Set_delay(unsigned char First, unsigned char Taps, unsigned int Extra)
+{
+	unsigned char i;
+	unsigned int Repeat;
+
+	for (i=0; i<Taps; i++)
+	{
+		Repeat = (Extra > 31) ? 31 : Extra;
+		Extra -= Repeat;
+		(&ESITSM0)[First + i] = ((&ESITSM0)[First + i] & 0x07FF) | (Repeat << 11);
+	}
+}
+
+
+
+void Find_Noise_level(void)
+{
+
+unsigned int Loop_counter = 0;
+unsigned int Threshold;
+unsigned char ch;
+#if Noise_early_exit
+#define Noise_range_sq  36							// (6 sigma)^2, about the spread of 234 loops of Gaussian noise
+
+long          Sum[ESI_channels];					// of the deviation from the first level
+unsigned long Sum_sq[ESI_channels];
+unsigned long Var16, Var16_prev[ESI_channels], Bound_sq;
+unsigned int  First[ESI_channels], Spread, Bound[ESI_channels];
+int           Dev;
+unsigned char Settled = 0;
+#endif
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// To find the noise level of each channel, or the largest of them with Noise_common
+// With Noise_early_exit, the variance of every channel is tracked as well. From Noise_min_loops
+// on it is checked every Noise_check_loops loops: the search stops when the variance has
+// changed by less than 1/Noise_tolerance since the last check and the spread of no channel
+// exceeds the spread that Gaussian noise of that variance gives in 234 loops. The noise level
+// of a channel is then the larger of its spread and bound. Noisy or drifting sensors run the
+// full 234 loops.
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Min_DAC[ch] = 0x0FFF;					// set initial value for DAC max and min
+		Max_DAC[ch] = 0x0000;					// this variable will record the DAC value of metal and non metal part of a rotor
+#if Noise_early_exit
+		Sum[ch] = 0;
+		Sum_sq[ch] = 0;
+		Var16_prev[ch] = 0;
+		Bound[ch] = 0;
+#endif
+	}
+
+
+	do {  // do loop for detection of noise level
+
+	FindDAC_Fast_Range(Search_range);
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		if (DAC_R(AFE1, 2*ch+1) < Min_DAC[ch]) {Min_DAC[ch] = DAC_R(AFE1, 2*ch+1);}
+		if (DAC_R(AFE1, 2*ch)   > Max_DAC[ch]) {Max_DAC[ch] = DAC_R(AFE1, 2*ch);}
+	}
+
+	Loop_counter++;
+
+#if Noise_early_exit
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		if (Loop_counter == 1) { First[ch] = DAC_R(AFE1, 2*ch); }
+		Dev = (int)DAC_R(AFE1, 2*ch) - (int)First[ch];
+		Sum[ch] += Dev;
+		Sum_sq[ch] += (long)Dev * Dev;
+	}
+
+	if ((Loop_counter >= Noise_min_loops) && !(Loop_counter & (Noise_check_loops - 1)))
+	{
+		Settled = 1;
+
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Var16 = ((unsigned long)Loop_counter * Sum_sq[ch] - (unsigned long)(Sum[ch] * Sum[ch])) * 16
+			        / ((unsigned long)Loop_counter * (Loop_counter - 1));	// 16 x variance
+
+			if (Var16 > Var16_prev[ch])
+				{ if ((Var16 - Var16_prev[ch]) * Noise_tolerance > Var16) { Settled = 0; } }
+			else
+				{ if ((Var16_prev[ch] - Var16) * Noise_tolerance > Var16) { Settled = 0; } }
+			Var16_prev[ch] = Var16;
+
+			Bound_sq = (Var16 * Noise_range_sq + 15) / 16;
+			Spread = Max_DAC[ch] - Min_DAC[ch];
+			if ((unsigned long)Spread * Spread > Bound_sq) { Settled = 0; }
+
+			Bound[ch] = 0;
+			while ((unsigned long)Bound[ch] * Bound[ch] < Bound_sq) { Bound[ch]++; }
+		}
+	}
+
+	}while ((Loop_counter < 234) && !Settled);	// run for approx 0.5 second at most
+#else
+	}while (Loop_counter < 234); 				// run for approx 0.5 second
+#endif
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Threshold = Max_DAC[ch] - Min_DAC[ch];
+#if Noise_early_exit
+		if (Settled && (Bound[ch] > Threshold))	// stopped early: at least the bound of 234 loops
+			{ Threshold = Bound[ch]; }
+#endif
+#if Noise_common
+		if ((ch == 0) || (Threshold > Noise_level[0]))
+			{ Noise_level[0] = Threshold; }
+#else
+		Noise_level[ch] = Threshold;
+#endif
+	}
+
+}
+
+
+void Set_DAC(void)
+{
+unsigned int Loop_counter = 0;
+unsigned char ch;
+#if Set_DAC_adaptive
+unsigned int Ref_max[ESI_channels], Ref_min[ESI_channels];
+unsigned int Middle;
+unsigned char State = 2, New_state, Edges = 0, Wider;		// State 2: not known yet
+unsigned int Stable = 0;									// searches since the range widened
+unsigned int Last_DAC[ESI_channels];
+unsigned int Full;											// the move of a search over its full range
+unsigned char Steps = 5;
+#endif
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// when the disc is rotating, the Max and Min of signal is found and their difference is required to be larger than STATE_SEPARATION.
+// After reaching the STATE_SEPARATION, it will keep rotating for one more second to ensure a complete rotation is calibrated.
+// With Set_DAC_adaptive, it stops as soon as Max and Min have not widened by more than half the noise level
+// over Set_DAC_stable_edges metal edges of channel 0, i.e. over a full rotation, and Set_DAC_stable_loops
+// searches. A search that could not
+// follow the signal is repeated over Set_DAC_wide_steps: the 5 steps alone miss the extremes of a fast rotor.
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Min_DAC[ch] = 4096;
+		Max_DAC[ch] = 0;
+		STATE_SEPARATION[ch] = Ch_noise(ch)*(Separation_factor-1)+Ch_noise(ch)/2;
+#if Set_DAC_adaptive
+		Ref_max[ch] = Ref_min[ch] = 0;
+#endif
+	}
+
+	 Loop_counter = 0;
+
+
+	do {  // do loop for 1 more second after valid separation detected;
+	do {  // do loop for detection of valid Max-Min separation;
+
+#if Set_DAC_adaptive
+		for (ch=0; ch<ESI_channels; ch++)
+			{ Last_DAC[ch] = DAC_R(AFE1, 2*ch); }
+		Full = (1 << Steps) - 1;
+		FindDAC_Fast_Successive(Steps);
+		Steps = 5;
+#else
+		FindDAC_Fast_Successive(5);
+#endif
+
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+#if Set_DAC_adaptive
+			// moved by the full range: the level may lie further out, search wider next time
+			if ((DAC_R(AFE1, 2*ch) == Last_DAC[ch] + Full) || (DAC_R(AFE1, 2*ch) + Full == Last_DAC[ch]))
+				{ Steps = Set_DAC_wide_steps; }
+#endif
+			if (DAC_R(AFE1, 2*ch+1) < Min_DAC[ch]) {Min_DAC[ch] = DAC_R(AFE1, 2*ch+1);}
+			if (DAC_R(AFE1, 2*ch)   > Max_DAC[ch]) {Max_DAC[ch] = DAC_R(AFE1, 2*ch);}
+
+			// To detect the a change due to rotation
+			// if a separation of STATE_SEPARATION is found, a rotation is detected and keep running for 1 second to find the max and min
+
+			if (Max_DAC[ch] - Min_DAC[ch] > STATE_SEPARATION[ch]) { Status_flag |= BIT0 << ch;}	// check for valid separation
+		}
+
+		}while ((Status_flag&All_channels) != All_channels);
+
+#if Set_DAC_adaptive
+			// A wider range restarts the count of the edges.
+			Wider = (Loop_counter == 0);
+			for (ch=0; ch<ESI_channels; ch++)
+			{
+				if ((Max_DAC[ch] > Ref_max[ch] + Ch_noise(ch)/2) || (Min_DAC[ch] + Ch_noise(ch)/2 < Ref_min[ch]))
+					{ Wider = 1; }
+			}
+			if (Wider)
+			{
+				for (ch=0; ch<ESI_channels; ch++)
+					{ Ref_max[ch] = Max_DAC[ch];  Ref_min[ch] = Min_DAC[ch]; }
+				Edges = 0;
+				Stable = 0;
+			}
+
+			// Sensor state of channel 0, as the PPU will see it with the thresholds set below.
+			// ESIPPU itself holds the last probe of FindDAC_Fast_Successive() here.
+			Middle = (Max_DAC[0] + Min_DAC[0])/2;
+			New_state = State;
+			if      (ESIDAC1R0 > Middle + Ch_noise(0)) { New_state = 1; }
+			else if (ESIDAC1R0 + Ch_noise(0) < Middle) { New_state = 0; }
+
+			if (New_state != State)
+			{
+				if (State != 2) { Edges++; }
+				State = New_state;
+			}
+
+			Loop_counter++;
+			Stable++;
+		} while((Loop_counter < Set_DAC_max_loops) && ((Edges < Set_DAC_stable_edges) || (Stable < Set_DAC_stable_loops)));
+#else
+			Loop_counter++;
+		} while(Loop_counter < 468)   ;   				// 1 second for 2340Hz using FindDAC_Fast_Successive();
+#endif
+
+	 Set_DAC_loops = Loop_counter;
+
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		AFE1_base[ch] = (Max_DAC[ch] + Min_DAC[ch])/2;
+		DAC_R(AFE1, 2*ch+1) = AFE1_base[ch] + Inv(Ch_noise(ch));		// "+" for INV version, "-" for non-INV version
+		DAC_R(AFE1, 2*ch)   = AFE1_base[ch] - Inv(Ch_noise(ch));		// "-" for INV version, "+" for non-INV version
+	}
+
+}
+
+
+// CRC-16-CCITT of a structure kept in FRAM, four bits per step: Info_Save() runs it
+// every few seconds.
+
+static const unsigned int CRC_nibble[16] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+unsigned int Info_CRC(const unsigned char* Data, unsigned int Length)
+{
+	unsigned int CRC = 0xFFFF;
+
+	while (Length--)
+	{
+		CRC = ((CRC << 4) & 0xFFFF) ^ CRC_nibble[(CRC >> 12) ^ (*Data >> 4)];
+		CRC = ((CRC << 4) & 0xFFFF) ^ CRC_nibble[(CRC >> 12) ^ (*Data++ & 0x0F)];
+	}
+	return CRC;
+}
+
+
+#if Temp_comp || Flow_meter || Skip_detect
+// Temp_Model, Flow_Hist and Skip_Log are kept in two copies with a sequence number. A save
+// writes the copy it did not read and switches to it after its CRC, so a reset during a
+// save leaves the last one valid. Returns the copy to go on with, 2 if none is valid
+// (BITn of Valid: copy n).
+
+unsigned char Info_Copy(unsigned char Valid, unsigned int Sequence0, unsigned int Sequence1)
+{
+	if (Valid == (BIT0+BIT1)) return (Sequence1 - Sequence0 == 1) ? 1 : 0;	// the later save
+	if (Valid & BIT0) return 0;
+	if (Valid & BIT1) return 1;
+	return 2;
+}
+#endif
+
+
+#if Snapshot_enable
+
+// CRC-16-CCITT of the calibration snapshot, without the CRC field.
+
+unsigned int Snapshot_CRC(void)
+{
+	return Info_CRC((unsigned char*)&Cal_Snapshot, sizeof(Cal_Snapshot) - sizeof(Cal_Snapshot.CRC));
+}
+
+
+// Writes the result of the calibration into INFO FRAM. A reset during the
+// update leaves a snapshot with a wrong CRC, which is not used.
+
+void Save_Snapshot(void)
+{
+	unsigned int i;
+	unsigned char ch;
+
+	for (i=0; i<TSM_states; i++)
+		{ Cal_Snapshot.TSM[i] = (&ESITSM0)[i]; }		// ESITSM0.. are consecutive registers
+
+	for (i=0; i<2*ESI_channels; i++)
+		{ Cal_Snapshot.DAC[i] = DAC_R(AFE1, i); }
+	for (i=0; i<Noise_levels; i++)
+		{ Cal_Snapshot.Noise_level[i] = Noise_level[i]; }
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Cal_Snapshot.Max_DAC[ch] = Max_DAC[ch];
+		Cal_Snapshot.Min_DAC[ch] = Min_DAC[ch];
+		Cal_Snapshot.AFE1_base[ch] = AFE1_base[ch];
+		Cal_Snapshot.AFE2_base[ch] = AFE2_base[ch];
+		Cal_Snapshot.AFE2_base_Max[ch] = AFE2_base_Max[ch];
+		Cal_Snapshot.AFE2_base_Min[ch] = AFE2_base_Min[ch];
+	}
+	Cal_Snapshot.ESICLKFQ = getESICLKFQ();
+	Cal_Snapshot.Version = Snapshot_version;
+
+	Cal_Snapshot.CRC = Snapshot_CRC();
+}
+
+
+// Resumes with the calibration snapshot of the last run. The snapshot is used
+// when version and CRC match, ESIOSC needed about the same trimming, and a few
+// measurements with the restored TSM find the signal of all channels within the
+// range Min_DAC..Max_DAC seen by Set_DAC(), widened by Snapshot_noise_margin noise levels.
+// Returns 1 when the calibration is restored, 0 if the full calibration is needed;
+// the TSM state list is then TSM_list again.
+
+unsigned char Restore_Snapshot(void)
+{
+	unsigned int i, Clkfq, Level, Margin;
+	unsigned char ch, Valid = 1;
+
+	if (Cal_Snapshot.Version != Snapshot_version) return 0;
+	if (Cal_Snapshot.CRC != Snapshot_CRC()) return 0;
+
+	Clkfq = getESICLKFQ();
+	if ((Clkfq > Cal_Snapshot.ESICLKFQ + Snapshot_ESICLKFQ_range) ||
+	    (Clkfq + Snapshot_ESICLKFQ_range < Cal_Snapshot.ESICLKFQ)) return 0;
+
+	for (i=0; i<TSM_states; i++)
+		{ (&ESITSM0)[i] = Cal_Snapshot.TSM[i]; }
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ AFE2_offset[ch] = Cal_Snapshot.AFE2_base[ch] - Cal_Snapshot.AFE1_base[ch]; }	// for FindDAC_Dual()
+	AFE2_offset_valid = 1;
+	for (i=0; i<Noise_levels; i++)
+		{ Noise_level[i] = Cal_Snapshot.Noise_level[i]; }			// Ch_noise(); measured again if not valid
+
+	for (i=0; i<Snapshot_checks; i++)
+	{
+		FindDAC(DAC_search_mode);
+
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Level = DAC_R(AFE1, 2*ch);
+			Margin = Snapshot_noise_margin*Ch_noise(ch);
+			if ((Level + Margin < Cal_Snapshot.Min_DAC[ch]) || (Level > Cal_Snapshot.Max_DAC[ch] + Margin)) Valid = 0;
+		}
+	}
+
+	if (!Valid)
+	{
+		for (i=0; i<TSM_states; i++)
+			{ (&ESITSM0)[i] = TSM_list[i]; }
+		AFE2_offset_valid = 0;
+		return 0;
+	}
+
+	for (i=0; i<2*ESI_channels; i++)
+		{ DAC_R(AFE1, i) = Cal_Snapshot.DAC[i]; }
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Max_DAC[ch] = Cal_Snapshot.Max_DAC[ch];
+		Min_DAC[ch] = Cal_Snapshot.Min_DAC[ch];
+		AFE1_base[ch] = Cal_Snapshot.AFE1_base[ch];
+		AFE2_base[ch] = Cal_Snapshot.AFE2_base[ch];
+		AFE2_base_Max[ch] = Cal_Snapshot.AFE2_base_Max[ch];
+		AFE2_base_Min[ch] = Cal_Snapshot.AFE2_base_Min[ch];
+	}
+
+	return 1;
+}
+
+#endif
+
+
+void InitScanIF(void)
+{
+	unsigned int i;
+	volatile unsigned char*  PsmRamPointer;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+	 Status_flag = 0;
+
+//  Port pin selection for ESI, all channels for ESI should be selected, even only two channels are used.
+//  The un-used pin should be floating, not be connected to any other circuit.
+
+	P9SEL1 |= BIT0 + BIT1 + BIT2 + BIT3;
+	P9SEL0 |= BIT0 + BIT1 + BIT2 + BIT3;            	// Select mux for ESI function
+
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//	ESI control registers setting, rates and PPU sources of ScanIF_Layout.h
+
+
+	ESIAFE = ESIVCC2 + AFE1_INV + ESITEN;            	                                                    // AVCC/2 enable, Excitation enable
+    ESITSM = ESITSMTRG1 + ESITSMTRG0 + TSM_rate_cal;                                                        // calibration sampling rate
+	ESIPSM = ESICNT2RST +ESICNT1RST + ESICNT0RST + ESICNT2EN +ESICNT1EN +ESICNT0EN;			                // ALL counters reset to zero, output TSM clock signal, enable all counters
+	ESICTL = ESI_CTL_select + ESITCH10 + ESICS ;    														// PPUS1..3 sources, no test cycle, ESI not enable yet
+
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+// TSM Setting
+
+	for (i=0; i<TSM_states; i++)
+		{ (&ESITSM0)[i] = TSM_list[i]; }			// ESITSM0.. are consecutive registers
+
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+// Fill in ESIRAM TABLE for PSM
+
+	PsmRamPointer = &ESIRAM0;
+
+	for (i=0; i<sizeof(Table); i++)
+	{
+		*PsmRamPointer = Table[i];
+		 PsmRamPointer +=1  ;
+	}
+
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+#if Snapshot_enable
+	if (Restore_Snapshot())				// calibration of the last run is still valid, the rotor is not needed
+	{
+	 ESIAFE = ESIVCC2 + AFE1_INV + ESITEN;
+	 ESITSM = ESITSMTRG1 + ESITSMTRG0 + TSM_rate_run;
+	 ESIPSM = ESICNT2RST +ESICNT1RST + ESICNT0RST + ESI_PSM_select +ESICNT2EN +ESICNT1EN +ESICNT0EN;
+	 ESIINT1 &= ~ESIIE5;
+	 return;
+	}
+#endif
+
+	TSM_Auto_cal();						// Auto set the TSM delay
+	Find_Noise_level();					// To find the noise level detected by ESI
+
+	lcd_display_num(8888,0);           	// "8888" on LCD indicating the completion of TSM calibration.
+
+#if Cal_rotor_command
+	IIC_TX(Cal_rotor_command); 			// start the rotor of the motor board
+#endif
+
+	Set_DAC();							// noise level found.
+										// User need to switch on the motor with half-covered metal disc to finish the calibration
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Set the ESI control registers for normal operation
+// now ready for normal operation
+
+
+	 ESIAFE = ESIVCC2 + AFE1_INV + ESITEN;             														// disable AFE2;
+	 ESITSM = ESITSMTRG1 + ESITSMTRG0 + TSM_rate_run; 														// Soft start or ACLK divider trig for TSM sequence
+	 ESIPSM = ESICNT2RST +ESICNT1RST + ESICNT0RST + ESI_PSM_select +ESICNT2EN +ESICNT1EN +ESICNT0EN;		// ALL counters reset to zero, output TSM clock signal, enable all counters
+	 ESIINT1 &= ~ESIIE5;
+
+#if AFE2_enable
+	 ReCal_Flag |= BIT5;          			// indication for a call from InitScanIF
+
+ 	 ESIINT2 &= ~ESIIFG5;                   // clear INT flag of Q6 of PSM
+ 	 ESIINT1 |= ESIIE5;						// enable INT of Q6
+ 	 ESICTL  |= ESIEN;
+
+ 	__bis_SR_register(LPM3_bits+GIE);   	// wait for the ESISTOP flag
+
+	 ReCalScanIF();                			// to find the init AFE2_base
+
+	 ESICTL &= ~ESIEN;
+ 	 ESIINT1 &= ~ESIIE5;					// disable INT of Q6
+ 	 ESIINT2 &= ~ESIIFG5;                   // clear INT flag of Q6 of PSM
+
+#if Snapshot_enable
+	 if (ReCal_Flag&BIT0) Save_Snapshot();	// AFE2_base found, calibration completed
+#endif
+	 ReCal_Flag = 0;
+
+#else
+#if Snapshot_enable
+	 Save_Snapshot();
+#endif
+#endif
+
+
+
+}
+
+
+
+#if AFE2_enable
+void ReCalScanIF(void)
+{
+
+unsigned int Loop_counter = 0;
+unsigned char Sensor_state, ch;
+
+int	AFE2_Max_DAC[ESI_channels];				//  sums of the AFE2 levels at the Max and Min of every channel
+int	AFE2_Min_DAC[ESI_channels];
+
+	ESIAFE = ESIDAC2EN + ESICA2EN + AFE1_INV + AFE2_INV + ESIVCC2 + ESITEN;            	// AVCC/2 enable, Excitation enable
+	ESITSM = ESITSMTRG1 + ESITSMTRG0 + TSM_rate_cal;                                        // calibration sampling rate
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		AFE2_Max_DAC[ch] = 0;
+		AFE2_Min_DAC[ch] = 0;
+	}
+
+	 ESIINT2 &= ~ESIIFG1;
+	 ESIINT1 |= ESIIE1;
+
+do {
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		if(ReCal_Flag&BIT6) {DAC_R(AFE2, 2*ch) = AFE2_base[ch] + AFE2_drift[ch];}
+		else                {DAC_R(AFE2, 2*ch) = AFE1_base[ch];}
+	}
+	AFE2_FindDAC_Fast_Successive(5);
+
+#if ReCal_timer_hold
+	TA0CCTL0 &= ~CCIE;
+#endif
+
+	Loop_counter++;
+
+	if (ReCal_Flag&(BIT5+BIT6))
+	{
+		if (ReCal_Flag&BIT7)												// timer call during the burst, start again
+		{
+			for (ch=0; ch<ESI_channels; ch++)
+			{
+				AFE2_Max_DAC[ch] = 0;
+				AFE2_Min_DAC[ch] = 0;
+			}
+		}
+		ReCal_Flag &= ~BIT7;
+	}
+
+		// in every sensor state one channel is at its Max or Min level, see ScanIF_Layout.h
+		Sensor_state = ESIPPU&State_mask;
+		ch = State_channel[Sensor_state];
+		if (ch != No_channel)
+		{
+			if (Sensor_state == Max_state[ch])	{ AFE2_Max_DAC[ch] += DAC_R(AFE2, 2*ch); }
+			else								{ AFE2_Min_DAC[ch] += DAC_R(AFE2, 2*ch+1); }
+		}
+
+	if(ReCal_Flag&BIT6)
+	{
+
+		ESIINT1 &= ~ESIIE1;
+
+
+		if (Loop_counter == 4*Tot_states)												    // need 4 rotations for re-calibration
+				{
+				  ReCal_Flag |= BIT0;                                              	        // indication of valid calibration
+				  break;
+				}
+
+#if ReCal_Q6_gate
+		ESIINT2 &= ~ESIIFG5;                  												// clear the Q6 flag
+		ESIINT1 |= ESIIE5;																	// Enable Q6 INT for in case of Time out.
+#endif
+		__bis_SR_register(LPM3_bits+GIE);   												// wait for the Q6 flag
+#if ReCal_Q6_gate
+		ESIINT1 &= ~ESIIE5;
+#endif
+
+	}
+	else if (ReCal_Flag&BIT5)
+	{
+		 ESIINT1 &= ~ESIIE1;
+
+		if (Loop_counter == 8*Tot_states)												    // need 8 rotations for initialization
+				{
+				  ReCal_Flag |= BIT0;                                              	        // indication of valid calibration
+				  break;
+				}
+
+		__bis_SR_register(LPM3_bits+GIE);   												//	 wait for the Q6 flag
+
+	}
+	else if (ReCal_Flag&BIT7)
+	{
+		if (Loop_counter == 4)															    // take 4 readings
+				{
+				  ReCal_Flag |= BIT0;                                              	        // indication of valid calibration
+				  break;
+				}
+	}
+
+
+	if(ReCal_Flag&BIT1)																		// inidcation of time out from Timer A
+	{   __no_operation();
+		break;}
+
+	  ESIINT2 &= ~ESIIFG1;
+	  ESIINT1 |= ESIIE1;
+
+#if ReCal_timer_hold
+	  TA0CCTL0 |= CCIE;
+#endif
+
+}while(Loop_counter < ReCal_loops_max)   ;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// if BIT0 of ReCal_Flag is set, Max & Min of all channels found. set the ESIDAC with noise margin and AFE2_offset
+// otherwise, it will be time out for re-calibration and no data for AFE1
+
+
+
+if (ReCal_Flag&BIT0)
+{
+	if(ReCal_Flag&BIT6)
+	{
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			AFE2_Max_DAC[ch] /= 4;
+			AFE2_Min_DAC[ch] /= 4;
+
+			AFE2_drift[ch] = (AFE2_Max_DAC[ch] + AFE2_Min_DAC[ch])/2 - AFE2_base[ch];
+			AFE1_Level(ch, AFE1_base[ch] + AFE2_drift[ch]);
+		}
+	}
+	else if(ReCal_Flag&BIT5)                              // call from InitScanIF only to get AFE2 base value
+			{
+				for (ch=0; ch<ESI_channels; ch++)
+				{
+					AFE2_base_Max[ch] = AFE2_Max_DAC[ch]/8;
+					AFE2_base_Min[ch] = AFE2_Min_DAC[ch]/8;
+
+					AFE2_base[ch]  = (AFE2_base_Max[ch] + AFE2_base_Min[ch])/2;
+					AFE2_offset[ch] = AFE2_base[ch] - AFE1_base[ch];     // both are the middle of the signal
+				}
+				AFE2_offset_valid = 1;
+			}
+	else if(ReCal_Flag&BIT7)
+			{
+				Sensor_state = ESIPPU&State_mask;		// only for clockwise rotation, cutting ch0 first
+				ch = State_channel[Sensor_state];
+				if (ch != No_channel)
+				{
+					if (Sensor_state == Max_state[ch])	{ AFE2_drift[0] = AFE2_Max_DAC[ch]/4 - AFE2_base_Max[ch]; }
+					else								{ AFE2_drift[0] = AFE2_Min_DAC[ch]/4 - AFE2_base_Min[ch]; }
+				}
+
+				for (ch=0; ch<ESI_channels; ch++)
+					{ AFE1_Level(ch, AFE1_base[ch] + AFE2_drift[0]/2); }
+			}
+}
+
+
+		 ESIAFE = ESIVCC2 + AFE1_INV + ESITEN;                                  				// disable AFE2 when completed;
+		 ESITSM = ESITSMTRG1 + ESITSMTRG0 + TSM_rate_run;			            				// Back to the normal rate
+		 ESIINT1 &= ~ESIIE1;																	// disable ESISTOP INT
+
+}
+
+
+// Moves the AFE1 thresholds of a channel to New_level with the noise margin, unless
+// they are delta_level or more away from it.
+
+void AFE1_Level(unsigned char ch, int New_level)
+{
+	int Delta = (DAC_R(AFE1, 2*ch) + DAC_R(AFE1, 2*ch+1))/2 - New_level;
+
+	if (abs(Delta) < delta_level )
+	{
+	DAC_R(AFE1, 2*ch)   = New_level - Inv(Ch_noise(ch));		// Noise_level, "-" for INV version, "+" for non-INV version
+	DAC_R(AFE1, 2*ch+1) = New_level + Inv(Ch_noise(ch));		// Noise_level, "+" for INV version, "-" for non-INV version
+	}
+}
+
+
+void AFE2_FindDAC_Fast_Successive(int Range_num)	// from the level in ESIDAC2R, ESI and ESISTOP INT are on
+{
+	unsigned int i, Below;
+	unsigned int DAC_BIT = 0x0001 << (Range_num - 1);
+	unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+		{ DAC_Set(AFE2, ch, DAC_R(AFE2, 2*ch)); }
+
+	for(i = 0; i<Range_num; i++)
+	{
+		__bis_SR_register(LPM3_bits+GIE);   //	 wait for the ESISTOP flag
+
+		Below = (ESIPPU ^ Out_sense) >> (AFE2/2);		// bit ch: below the DAC level, up one DAC_BIT or down one
+		for (ch=0; ch<ESI_channels; ch++)
+			{ DAC_Set(AFE2, ch, DAC_R(AFE2, 2*ch) + DAC_BIT - ((Below >> ch) & 1)*2*DAC_BIT); }
+
+		DAC_BIT /= 2;
+	}
+}
+
+
+#if Drift_tracker
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// AFE2 drift tracker. In every sensor state one channel is at its Max or Min level, as
+// sampled by ReCalScanIF(). Drift_Probe_Start() sets ESIDAC2 of that channel to the tracked
+// level of the state and switches AFE2 on for the next TSM sequence; Drift_Probe_End()
+// moves the tracked level one DAC code towards the AFE2 result. The middle of the Max and
+// Min levels against AFE2_base is averaged into AFE2_drift, and ESIDAC1R of the channel
+// follows AFE1_base + AFE2_drift one DAC code per probe. The TSM rate is left as it is.
+// The channel of a sensor state is State_channel[] of ScanIF_Layout.h.
+
+int           Drift_level[State_mask+1];				// tracked AFE2 level per sensor state
+int           Drift_sum[ESI_channels];					// AFE2_drift * Drift_ewma_weight
+int           Drift_AFE1_base[ESI_channels], Drift_AFE2_base[ESI_channels];
+unsigned char Drift_count = 0, Drift_state = 0, Drift_probe = 0;
+unsigned int  Drift_interval = Drift_probe_interval;		// Q6 events between two probes
+
+
+void Drift_Init(void)
+{
+	unsigned char ch;
+	int Swing;
+
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Drift_AFE1_base[ch] = AFE1_base[ch];
+		Drift_AFE2_base[ch] = AFE2_base[ch];
+		Swing = (Max_DAC[ch] - Min_DAC[ch])/2;			// the middle of the start levels is AFE2_base
+
+		Drift_level[Max_state[ch]] = Drift_AFE2_base[ch] - Inv(Swing);	// INV: the Max level is the lower DAC code
+		Drift_level[Min_state[ch]] = Drift_AFE2_base[ch] + Inv(Swing);
+		Drift_sum[ch] = 0;
+		AFE2_drift[ch] = 0;
+	}
+	Drift_count = 0;
+	Drift_probe = 0;
+	Drift_interval = Drift_probe_interval;
+}
+
+
+// Moves the tracked levels, AFE2_drift and ESIDAC1R of a channel by Step DAC codes.
+// Called with interrupts disabled.
+
+void Drift_Shift(unsigned char ch, int Step)
+{
+	Drift_level[Max_state[ch]] += Step;
+	Drift_level[Min_state[ch]] += Step;
+	Drift_sum[ch] += Step*Drift_ewma_weight;
+	AFE2_drift[ch] = Drift_sum[ch]/Drift_ewma_weight;
+
+	DAC_R(AFE1, 2*ch)   += Step;
+	DAC_R(AFE1, 2*ch+1) += Step;
+}
+
+
+void Drift_Probe_Start(void)									// called by the Q6 interrupt
+{
+	unsigned char ch;
+
+	if (++Drift_count < Drift_interval) return;
+
+	Drift_state = ESIPPU&State_mask;
+	ch = State_channel[Drift_state];
+	if (ch == No_channel) return;							// not a state of the disc, try the next Q6
+	Drift_count = 0;
+
+	DAC_Set(AFE2, ch, Drift_level[Drift_state]);
+
+	ESIAFE |= ESIDAC2EN + ESICA2EN + AFE2_INV;				// AFE2 on for the next TSM sequence
+	ESIINT2 &= ~ESIIFG1;
+	ESIINT1 |= ESIIE1;
+	Drift_probe = 1;
+}
+
+
+void Drift_Probe_End(void)										// called by the ESISTOP interrupt of the probe
+{
+	unsigned char ch;
+	int Middle, New_level, Delta;
+
+	ESIINT1 &= ~ESIIE1;
+	ESIAFE &= ~(ESIDAC2EN + ESICA2EN + AFE2_INV);
+	Drift_probe = 0;
+
+	if ((ESIPPU&State_mask) != Drift_state) return;			// next state reached, another level
+
+	ch = State_channel[Drift_state];
+	if (!((ESIPPU ^ Out_sense)&Out_bit(AFE2, ch)))	Drift_level[Drift_state]++;	// level above ESIDAC2
+	else											Drift_level[Drift_state]--;
+
+	Middle = (Drift_level[Max_state[ch]] + Drift_level[Min_state[ch]])/2;
+	Drift_sum[ch] += Middle - Drift_AFE2_base[ch] - Drift_sum[ch]/Drift_ewma_weight;
+	AFE2_drift[ch] = Drift_sum[ch]/Drift_ewma_weight;
+
+	New_level = Drift_AFE1_base[ch] + Drift_sum[ch]/Drift_ewma_weight;
+	Delta = (DAC_R(AFE1, 2*ch) + DAC_R(AFE1, 2*ch+1))/2 - New_level;
+
+	if ((Delta > 0) && (Delta < delta_level))					// one DAC code per probe, the noise margin is kept
+	{
+		DAC_R(AFE1, 2*ch)--;
+		DAC_R(AFE1, 2*ch+1)--;
+	}
+	else if ((Delta < 0) && (Delta > -delta_level))
+	{
+		DAC_R(AFE1, 2*ch)++;
+		DAC_R(AFE1, 2*ch+1)++;
+	}
+}
+#endif
+
+
+#if Temp_comp
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Temperature compensation of the drift tracker. The temperature T is the sum of Temp_samples
+// ADC12 conversions of the internal sensor, the model a slope of AFE2_drift per 4096 of T
+// for every channel. Between two learning points (anchors) the prediction
+// Slope * (T - Temp_anchor) / 4096 is applied to the tracker by Drift_Shift(), so the
+// probes only correct what the model does not explain.
+
+struct Temp_model
+{
+	unsigned int  Version;
+	unsigned int  Sequence;							// of the save, see Info_Copy()
+	int           Slope[ESI_channels];							// AFE2_drift per 4096 of T
+	unsigned int  CRC;								// CRC-16-CCITT of the fields above
+};
+
+#pragma PERSISTENT(Temp_Model)						// not cleared by the C start-up, see Cal_Snapshot
+#pragma LOCATION(Temp_Model, 0x1900)				// INFOB
+struct Temp_model Temp_Model[2] = {0};				// kept over a reset, written in turn by Temp_Update()
+unsigned char Temp_copy = 0;						// Temp_Model[] of the last save
+int           Temp_slope[ESI_channels];						// the model in use, learned by Temp_Update()
+
+unsigned char Temp_valid = 0;						// Temp_slope[] holds a learned slope
+unsigned char Temp_settled = 0;						// the tracker has converged, the anchor is set
+unsigned int  Temp_anchor;							// T at the last learning point
+unsigned int  Temp_now;							// T of the last reading
+int           Temp_anchor_drift[ESI_channels];					// AFE2_drift at the last learning point
+int           Temp_applied[ESI_channels];						// prediction applied since the last learning point
+int           Temp_window_drift[ESI_channels];					// AFE2_drift at the start of the accuracy window
+int           Temp_window_applied[ESI_channels];				// prediction applied since then
+unsigned char Temp_ticks = 0, Temp_stretch = 0;
+
+
+static void Temp_Adc_On(void)
+{
+	REFCTL0 |= REFVSEL_0 + REFON;					// 1.2 V reference for the temperature sensor
+	ADC12CTL0 = ADC12SHT0_8 + ADC12ON;				// 256 ADC12CLK sampling, > 30 us for the sensor
+	ADC12CTL1 = ADC12SHP;
+	ADC12CTL2 = ADC12RES_2;
+	ADC12CTL3 = ADC12TCMAP;
+	ADC12MCTL0 = ADC12VRSEL_1 + ADC12INCH_30;
+	__delay_cycles(300);							// reference settling time
+}
+
+
+unsigned int Temp_Read(void)
+{
+	unsigned int T = 0;
+	unsigned char i;
+
+	Temp_Adc_On();
+	for (i=0; i<Temp_samples; i++)
+	{
+		ADC12IFGR0 &= ~ADC12IFG0;
+		ADC12CTL0 |= ADC12ENC + ADC12SC;
+		while (!(ADC12IFGR0&ADC12IFG0));
+		T += ADC12MEM0;
+	}
+
+	ADC12CTL0 &= ~(ADC12ENC + ADC12ON);
+	REFCTL0 &= ~REFON;
+	return T;
+}
+
+
+#if Task_scheduler
+unsigned int  Temp_sum;								// the reading of the last sequence
+
+void Temp_Start(void)											// every Temp_period, the reading ends in Temp_Sample()
+{
+	Temp_Adc_On();
+	ADC12MCTL1 = ADC12VRSEL_1 + ADC12INCH_30;					// Temp_samples of 4: one sequence, one interrupt
+	ADC12MCTL2 = ADC12VRSEL_1 + ADC12INCH_30;
+	ADC12MCTL3 = ADC12VRSEL_1 + ADC12INCH_30 + ADC12EOS;
+	ADC12CTL1 |= ADC12CONSEQ_1;
+	ADC12IFGR0 &= ~(ADC12IFG0 + ADC12IFG1 + ADC12IFG2 + ADC12IFG3);
+	ADC12IER0 = ADC12IE3;
+	ADC12CTL0 |= ADC12MSC + ADC12ENC + ADC12SC;					// the conversions follow each other, the CPU sleeps
+}
+
+
+void Temp_Sample(void)											// called by the ADC12 interrupt, Temp_Update() is due
+{
+	Temp_sum = ADC12MEM0 + ADC12MEM1 + ADC12MEM2 + ADC12MEM3;
+	ADC12IER0 = 0;
+	ADC12CTL0 &= ~(ADC12ENC + ADC12ON);
+	REFCTL0 &= ~REFON;
+}
+#endif
+
+
+unsigned int Temp_CRC(unsigned char Copy)
+{
+	return Info_CRC((unsigned char*)&Temp_Model[Copy], sizeof(Temp_Model[0]) - sizeof(Temp_Model[0].CRC));
+}
+
+
+void Temp_Init(void)
+{
+	unsigned char ch, Valid = 0;
+
+	for (ch=0; ch<2; ch++)
+		if ((Temp_Model[ch].Version == Temp_version) && (Temp_Model[ch].CRC == Temp_CRC(ch))) Valid |= BIT0 << ch;
+	Temp_copy = Info_Copy(Valid, Temp_Model[0].Sequence, Temp_Model[1].Sequence);
+	Temp_valid = (Temp_copy < 2);
+	if (!Temp_valid) Temp_copy = 1;						// the first save goes to copy 0
+	for (ch=0; ch<ESI_channels; ch++)
+		Temp_slope[ch] = Temp_valid ? Temp_Model[Temp_copy].Slope[ch] : 0;
+
+	Temp_now = Temp_anchor = Temp_Read();
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Temp_anchor_drift[ch] = 0;
+		Temp_applied[ch] = 0;
+		Temp_window_drift[ch] = 0;
+		Temp_window_applied[ch] = 0;
+	}
+	Temp_ticks = 0;
+	Temp_stretch = 0;
+	Temp_settled = 0;
+}
+
+
+void Temp_Update(void)											// every Temp_period, from main()
+{
+	unsigned int T;
+	unsigned char ch, Learn, Accurate = 1;
+	int Step, Drift, Error;
+	long Slope;
+	struct Temp_model *Model;
+
+#if Task_scheduler
+	T = Temp_now = Temp_sum;									// of Temp_Start() and Temp_Sample()
+#else
+	T = Temp_now = Temp_Read();
+#endif
+	Learn = Temp_settled && (abs((int)T - (int)Temp_anchor) >= Temp_learn_step);
+
+	__bic_SR_register(GIE);										// the tracker runs in the ESI interrupt
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Step = (int)((long)Temp_slope[ch]*((int)T - (int)Temp_anchor)/4096) - Temp_applied[ch];
+		if (Step > Temp_step_max)  Step = Temp_step_max;
+		if (Step < -Temp_step_max) Step = -Temp_step_max;
+		Drift_Shift(ch, Step);
+		Temp_applied[ch] += Step;
+		Temp_window_applied[ch] += Step;
+
+		Drift = Drift_sum[ch]/Drift_ewma_weight;
+		Error = Drift - Temp_window_drift[ch] - Temp_window_applied[ch];	// corrected by the probes
+		if (abs(Error) > Temp_accuracy) Accurate = 0;
+
+		if (Learn)
+		{
+			Slope = (long)(Drift - Temp_anchor_drift[ch])*4096/((int)T - (int)Temp_anchor);
+			if (Temp_valid) Slope = Temp_slope[ch] + (Slope - Temp_slope[ch])/4;
+			Temp_slope[ch] = (int)Slope;
+			Temp_anchor_drift[ch] = Drift;
+			Temp_applied[ch] = 0;
+		}
+	}
+	__bis_SR_register(GIE);
+
+	if (Learn)													// save into the other copy, see Info_Copy()
+	{
+		Temp_anchor = T;
+		Model = &Temp_Model[Temp_copy ^ 1];
+		for (ch=0; ch<ESI_channels; ch++)
+			Model->Slope[ch] = Temp_slope[ch];
+		Model->Version = Temp_version;
+		Model->Sequence = Temp_Model[Temp_copy].Sequence + 1;
+		Model->CRC = Temp_CRC(Temp_copy ^ 1);
+		Temp_copy ^= 1;
+		Temp_valid = 1;
+	}
+
+	if (!Accurate)												// the model is off, probe at the full rate
+	{
+		Temp_stretch = 0;
+		Temp_ticks = Temp_stretch_ticks;
+	}
+	else if (++Temp_ticks >= Temp_stretch_ticks)
+	{
+		if (Temp_stretch < Temp_stretch_max) Temp_stretch++;
+	}
+
+	if (Temp_ticks >= Temp_stretch_ticks)						// next accuracy window
+	{
+		Temp_ticks = 0;
+		for (ch=0; ch<ESI_channels; ch++)
+		{
+			Temp_window_drift[ch] = Drift_sum[ch]/Drift_ewma_weight;
+			Temp_window_applied[ch] = 0;
+			if (!Temp_settled)									// first anchor after the start of the tracker
+			{
+				Temp_anchor_drift[ch] = Temp_window_drift[ch];
+				Temp_applied[ch] = 0;
+			}
+		}
+		if (!Temp_settled) Temp_anchor = T;
+		Temp_settled = 1;
+	}
+	Drift_interval = ((Drift_probe_interval - 1) << Temp_stretch) + 1;
+}
+#endif
+
+
+#if Osc_tracker
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// ESIOSC drift in normal operation. EsioscReCal() keeps its search state between the calls,
+// so Osc_Update() makes one ESICLKFQ step per wake and the counting never waits for it.
+// TSM_Auto_cal() tuned the delay chains in ESIOSC cycles: when ESICLKFQ has moved, the
+// cycles from the first delay state through the CA state are set to Osc_chain * Sum / Osc_sum,
+// Sum the ESIOSC measurement now, which keeps the latch at the time found by the calibration.
+
+unsigned int  Osc_sum;								// MeasureEsiosc_Sum() after the TSM calibration
+unsigned int  Osc_chain[ESI_channels];							// ESIFCLK cycles of the delay chain and the CA state then
+unsigned int  Osc_T;								// Temp_now at the start of the last EsioscReCal() run
+unsigned char Osc_ticks = 0, Osc_busy = 0, Osc_FQ;
+unsigned int  Osc_moves = 0, Osc_TSM_updates = 0;	// ESICLKFQ changes, rescaled delay chains
+
+
+unsigned int Osc_Chain_cycles(unsigned char ch)
+{
+	unsigned int Cycles = 0;
+	unsigned char i;
+
+	for (i=0; i<=Delay_taps; i++)					// the delay chain and the CA state behind it
+		Cycles += ((&ESITSM0)[Delay_first[ch] + i] >> 11) + 1;
+	return Cycles;
+}
+
+
+void Osc_Init(void)
+{
+	unsigned char ch;
+
+	for (ch=0; ch<ESI_channels; ch++)
+		Osc_chain[ch] = Osc_Chain_cycles(ch);
+	Osc_sum = MeasureEsiosc_Sum();
+	Osc_T = Temp_now;
+	Osc_ticks = 0;
+	Osc_busy = 0;
+}
+
+
+void Osc_Update(void)											// every Temp_period, from main() after Temp_Update()
+{
+	unsigned long Cycles;
+	unsigned int Sum, Fixed;
+	unsigned char ch;
+
+	if (!Osc_busy)
+	{
+		if ((++Osc_ticks < Osc_period) && (abs((int)Temp_now - (int)Osc_T) < Osc_temp_step))
+			return;
+		Osc_ticks = 0;
+		Osc_T = Temp_now;
+		Osc_FQ = getESICLKFQ();
+		Osc_busy = 1;
+	}
+	if (EsioscReCal(Esiosc_target) == 0x01)					// not done, one more step at the next wake
+		return;
+	Osc_busy = 0;
+	if (getESICLKFQ() == Osc_FQ)
+		return;
+
+	Osc_moves++;
+	Sum = MeasureEsiosc_Sum();
+	for (ch=0; ch<ESI_channels; ch++)
+	{
+		Fixed = Delay_taps + ((&ESITSM0)[Delay_first[ch] + Delay_taps] >> 11) + 1;	// chain without extra cycles, CA state
+		Cycles = ((unsigned long)Osc_chain[ch]*Sum + Osc_sum/2)/Osc_sum;
+		if (Cycles < Fixed) Cycles = Fixed;
+		if (Cycles > Fixed + Delay_max) Cycles = Fixed + Delay_max;
+		if (Cycles != Osc_Chain_cycles(ch))
+		{
+			TSM_Set_delay(Delay_first[ch], Delay_taps, (unsigned int)Cycles - Fixed);
+			Osc_TSM_updates++;
+		}
+	}
+}
+#endif
+
+
+#if Rate_governor
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Flow-adaptive TSM rate. A TSM sequence every (4A+2)(2B+1) ACLK costs the same charge at any
+// flow, while the sensor states change only as fast as the rotor turns. Rate_Q6() runs right
+// after a state change, so a new divider is in place long before the next one: the PSM sees
+// every state and ESICNT1 counts on without a gap. TA0 counts ACLK/8 up to Temp_period, so
+// an interval over one period reads too short, which only ever selects a faster rate.
+// Rate_divider[] and Rate_period[] of the meter are in ScanIF_Layout.h.
+
+unsigned char Rate_level = Rate_start;
+unsigned char Rate_ticks = 0;							// TA0 periods since the last state change
+unsigned char Rate_calm = 0, Rate_down;
+unsigned int  Rate_last;								// TA0R at the last state change
+unsigned long Rate_sum;									// Rate_weight intervals
+unsigned int  Rate_count;								// ESICNT1 at the last Rate_Tick()
+unsigned int  Rate_switches = 0;
+
+
+void Rate_Set(unsigned char Level)
+{
+	if (Level == Rate_level) return;
+	Rate_level = Level;
+	Rate_calm = 0;
+	ESITSM = (ESITSM & ~(ESIDIV3A_7 + ESIDIV3B_7)) | Rate_divider[Level];
+	Rate_switches++;
+}
+
+
+unsigned int Rate_Read_TA0(void)						// TA0 runs on ACLK, read until two reads agree
+{
+	unsigned int T;
+
+	do { T = TA0R; } while (T != TA0R);
+	return T;
+}
+
+
+void Rate_Init(void)
+{
+	Rate_level = Rate_start;							// the rate set by InitScanIF()
+	Rate_ticks = 2;
+	Rate_calm = 0;
+	Rate_last = Rate_Read_TA0();
+	Rate_count = ESICNT1;
+	Rate_sum = (unsigned long)Rate_weight*Rate_margin_down*Rate_period[Rate_start];
+}
+
+
+void Rate_Q6(void)												// called by the Q6 interrupt
+{
+	unsigned long Interval;										// since the last state change
+	unsigned int Now;
+	unsigned char Level, Slow;
+
+	Now = Rate_Read_TA0();
+	Interval = (Now >= Rate_last) ? Now - Rate_last : Now + Temp_period + 1 - Rate_last;
+	Interval *= 8*4;											// 1/4 ACLK cycles, the margins are in 1/4 sequences
+	Rate_last = Now;
+
+	if (Rate_ticks >= 2)										// first state change after standstill
+	{
+		Rate_ticks = 0;
+		if (Rate_level > Rate_start) Rate_Set(Rate_start);
+		Rate_sum = (unsigned long)Rate_weight*Rate_margin_down*Rate_period[Rate_level];
+		return;
+	}
+	Rate_ticks = 0;
+	Rate_sum += Interval - Rate_sum/Rate_weight;
+	if (Interval >= (unsigned long)Rate_margin_single*Rate_period[Rate_level])
+		Interval = Rate_sum/Rate_weight;						// else a state seen by one sequence is enough to go
+																// faster: at an aliased rate the average stays long
+
+	for (Slow=Rate_levels; Slow>0; Slow--)						// slowest rate with Rate_margin_down
+		if (Interval >= (unsigned long)Rate_margin_down*Rate_period[Slow-1]) break;
+	Slow = Slow ? Slow - 1 : 0;
+
+	if (Interval < (unsigned long)Rate_margin*Rate_period[Rate_level])
+	{
+		Rate_Set(Slow);											// faster at once
+	}
+	else if (Slow > Rate_level)
+	{
+		Level = Rate_calm ? Rate_down : Slow;
+		Rate_down = (Slow < Level) ? Slow : Level;				// the fastest rate of the window
+		if (++Rate_calm >= Rate_down_events)
+			Rate_Set(Rate_down);
+	}
+	else
+		Rate_calm = 0;
+}
+
+
+void Rate_Tick(void)											// called by the TA0 interrupt, every Temp_period
+{
+	unsigned int Count = ESICNT1;
+	unsigned char Reverse = (Count != Rate_count) && ((Count - Rate_count)&0x8000);
+
+	Rate_count = Count;
+	if (!(ESICTL&ESIEN) || !(ESIINT1&ESIIE5))					// no state changes can be seen, keep the rate
+	{	Rate_ticks = 0;
+		return;
+	}
+	if (Reverse)												// ESICNT1 went down: reverse flow has no Q6 events,
+	{	Rate_ticks = 0;											// keep the rate of the calibration
+		if (Rate_level > Rate_start) Rate_Set(Rate_start);
+		return;
+	}
+	if (Rate_ticks < 2) Rate_ticks++;
+	if (Rate_ticks == 2)										// no state change for a full period: no flow
+		Rate_Set(Rate_levels - 1);
+}
+
+
+void Rate_Skip(void)											// called by Skip_Event(): a state was missed
+{
+	Rate_Set(0);
+	Rate_calm = 0;
+	Rate_sum = (unsigned long)Rate_weight*Rate_margin*Rate_period[0];	// the intervals seen so far were aliased
+}
+#endif
+
+
+#endif
+
+
+
+#if Totalizer
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Totalizer. The net volume is Tot_net_base at ESICNT1 = Tot_net_last plus the 16-bit distance
+// of ESICNT1 from there, which stays below Tot_sync_states + 1: the thresholds move along at
+// every sync. The forward volume is Tot_fwd_base plus ESICNT0, one 0x10000 step per wrap.
+// The reverse volume is their difference. Readers retry when a sync ran in between.
+
+unsigned long Tot_fwd_base;								// forward states at ESICNT0 = 0
+long          Tot_net_base;								// net states at ESICNT1 = Tot_net_last
+unsigned int  Tot_net_last;
+
+
+long Tot_Delta(unsigned int Count, unsigned int Last)	// ESICNT1 distance, -0x8000..0x7FFF
+{
+	unsigned int D = (Count - Last) & 0xFFFF;			// int is 32 bits on the host
+
+	return (D & 0x8000) ? (long)D - 0x10000 : (long)D;
+}
+
+
+void Tot_Init(void)												// after ESIEN has reset the counters
+{
+	Tot_fwd_base = 0 - (unsigned long)ESICNT0;
+	Tot_net_base = 0;
+	Tot_net_last = ESICNT1;
+	ESITHR1 = Tot_net_last + Tot_sync_states;
+	ESITHR2 = Tot_net_last - Tot_sync_states;
+
+	ESIINT2 |= ESIIS0_3;										// ESIIFG7 when ESICNT0 wraps to zero
+	ESIINT2 &= ~(ESIIFG3+ESIIFG7);
+	ESIINT1 |= ESIIE3+ESIIE7;
+}
+
+
+void Tot_Threshold(void)										// called by the ESIIFG3 interrupt
+{
+	unsigned int Count = ESICNT1;
+
+	Tot_net_base += Tot_Delta(Count, Tot_net_last);
+	Tot_net_last = Count;
+	ESITHR1 = Count + Tot_sync_states;
+	ESITHR2 = Count - Tot_sync_states;
+}
+
+
+void Tot_Wrap(void)												// called by the ESIIFG7 interrupt
+{
+	Tot_fwd_base += 0x10000;
+}
+
+
+unsigned long Tot_Forward(void)									// forward state changes
+{
+	unsigned long Base, Skips = 0;
+	unsigned int Count, Pending;
+
+	do {
+		Base = Tot_fwd_base;
+#if Skip_detect
+		Skips = Skip_Count();									// ESICNT0 counts the jumps as well
+#endif
+		Count = ESICNT0;
+		Pending = ESIINT2&ESIIFG7;
+#if Skip_detect
+	} while ((Base != Tot_fwd_base) || (Skips != Skip_Count()));
+#else
+	} while (Base != Tot_fwd_base);
+#endif
+	if (Pending && (Count < 0x8000)) Base += 0x10000;			// wrapped, Tot_Wrap() has not run yet
+	return Base + Count - Skips;
+}
+
+
+long Tot_Net(void)												// forward minus reverse state changes
+{
+	long Base;
+	unsigned int Last, Count;
+
+	do {
+		Base = Tot_net_base;
+		Last = Tot_net_last;
+		Count = ESICNT1;
+	} while ((Base != Tot_net_base) || (Last != Tot_net_last));
+	return Base + Tot_Delta(Count, Last);
+}
+
+
+unsigned long Tot_Reverse(void)									// reverse state changes
+{
+	unsigned long Forward;
+	long Net;
+
+	do {
+		Forward = Tot_Forward();
+		Net = Tot_Net();
+	} while (Forward != Tot_Forward());							// a state change between the reads
+	return Forward - Net;
+}
+
+
+unsigned long Tot_Rotations(void)								// net volume in whole rotations, for the LCD
+{
+	long Net = Tot_Net();
+
+	return (unsigned long)((Net < 0) ? -Net : Net)/Tot_states;
+}
+#endif
+
+
+
+#if Flow_meter || Skip_detect
+unsigned char Info_unsaved = 0;							// BIT0: Flow_new[], BIT1: Skip_copy, Info_Save() is due
+#endif
+
+
+#if Flow_meter
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Flow rate. The stamps are TA2R extended to 32 bits by the TA2 overflow interrupt (36 hours).
+// Flow_stamp[] holds the stamps of the last rotation, so a period always spans the same
+// states and the spacing of the states on the disc does not matter. Flow_Q6() only adds,
+// shifts and compares; the average jumps to a period more than 4 times off, after a stop.
+// It counts into Flow_new[]; Info_Save() adds them to Flow_Hist and its CRC in the main loop
+// after the TA2 overflow, so a reset loses about the last 2 s and the CRC takes no ISR time.
+
+struct Flow_hist
+{
+	unsigned int  Version;
+	unsigned int  Sequence;								// of the save, see Info_Copy()
+	unsigned long Count[Flow_bins];						// forward state changes per octave of the period
+	unsigned int  CRC;									// CRC-16-CCITT of the fields above
+};
+
+#pragma PERSISTENT(Flow_Hist)
+struct Flow_hist Flow_Hist[2] = {0};					// kept over a reset, written in turn by Info_Save()
+unsigned char Flow_copy = 0;							// Flow_Hist[] of the last save
+
+const unsigned long Flow_limit[Flow_bins] =				// shortest period of every bin but the first
+{
+	0, 0x200, 0x400, 0x800, 0x1000, 0x2000, 0x4000, 0x8000,
+	0x10000, 0x20000, 0x40000, 0x80000, 0x100000, 0x200000, 0x400000, 0x800000,
+};
+
+unsigned int  Flow_high = 0;							// TA2 overflows, upper half of the stamps
+unsigned long Flow_stamp[Tot_states];					// stamps of the last rotation
+unsigned char Flow_next = 0;							// oldest stamp
+unsigned char Flow_stamps = 0;							// stamps in Flow_stamp[]
+unsigned char Flow_bin = 0;
+unsigned long Flow_period = 0;							// ACLK cycles of the last rotation, 0: none yet
+unsigned long Flow_average = 0;							// Flow_period averaged, x 2^Flow_shift
+unsigned long Flow_peak = 0;							// shortest Flow_period, 0: none yet
+unsigned int  Flow_new[Flow_bins];						// state changes not yet in Flow_Hist
+
+
+unsigned long Flow_Stamp(void)
+{
+	unsigned int High, Low, Pending;
+
+	do {
+		High = Flow_high;
+		do { Low = TA2R; } while (Low != TA2R);			// TA2 runs on ACLK, read until two reads agree
+		Pending = TA2CTL&TAIFG;
+	} while (High != Flow_high);
+	if (Pending && (Low < 0x8000)) High++;				// overflowed, Flow_Overflow() has not run yet
+	return ((unsigned long)High << 16) + Low;
+}
+
+
+unsigned int Flow_CRC(unsigned char Copy)
+{
+	struct Flow_hist *Hist = &Flow_Hist[Copy];
+
+	return Info_CRC((unsigned char*)Hist, (unsigned char*)&Hist->CRC - (unsigned char*)Hist);	// the host pads after the CRC
+}
+
+
+void Flow_Init(void)
+{
+	unsigned char i, Valid = 0;
+
+	for (i=0; i<2; i++)
+		if ((Flow_Hist[i].Version == Flow_version) && (Flow_Hist[i].CRC == Flow_CRC(i))) Valid |= BIT0 << i;
+	Flow_copy = Info_Copy(Valid, Flow_Hist[0].Sequence, Flow_Hist[1].Sequence);
+	if (Flow_copy > 1)
+	{
+		Flow_copy = 0;
+		for (i=0; i<Flow_bins; i++) Flow_Hist[0].Count[i] = 0;
+		Flow_Hist[0].Version = Flow_version;
+		Flow_Hist[0].Sequence = 0;
+		Flow_Hist[0].CRC = Flow_CRC(0);
+	}
+	for (i=0; i<Flow_bins; i++) Flow_new[i] = 0;
+	Info_unsaved &= ~BIT0;
+	Flow_high = 0;
+	Flow_stamps = 0;
+#if Isr_trace
+	TA2CTL |= TAIE;										// Trace_Init() runs TA2: no clear, the trace stamps go on
+#else
+	TA2CTL = TASSEL0 + MC1 + TACLR + TAIE;				// ACLK, continuous mode, overflow interrupt
+#endif
+}
+
+
+unsigned char Flow_Overflow(void)								// called by the TA2 overflow interrupt, 1: Info_Save() is due
+{
+	Flow_high++;
+	return Info_unsaved;
+}
+
+
+void Flow_Q6(void)												// called by the Q6 interrupt
+{
+	unsigned long Now = Flow_Stamp();
+	unsigned long Period = Now - Flow_stamp[Flow_next];
+	unsigned char i;
+
+	Flow_stamp[Flow_next] = Now;
+	if (++Flow_next == Tot_states) Flow_next = 0;
+	if (Flow_stamps < Tot_states)								// the first rotation
+	{	Flow_stamps++;
+		return;
+	}
+
+	Flow_period = Period;
+	if (((Period << (Flow_shift-2)) > Flow_average) || ((Period << (Flow_shift+2)) < Flow_average))
+		Flow_average = Period << Flow_shift;
+	else
+		Flow_average += Period - (Flow_average >> Flow_shift);
+	if ((Period < Flow_peak) || !Flow_peak) Flow_peak = Period;
+
+	i = Flow_bin;												// the rate changes slowly, start at the last bin
+	while ((i < Flow_bins-1) && (Period >= Flow_limit[i+1])) i++;
+	while (i && (Period < Flow_limit[i])) i--;
+	Flow_bin = i;
+	Flow_new[i]++;
+	Info_unsaved |= BIT0;
+}
+
+
+unsigned long Flow_Period_Now(void)								// Flow_period, longer while the next state is overdue
+{
+	unsigned char Last = Flow_next ? Flow_next - 1 : Tot_states - 1;
+	unsigned long Since;
+
+	if (!Flow_period) return 0;
+	Since = (Flow_Stamp() - Flow_stamp[Last])*Tot_states;
+	return (Since > Flow_period) ? Since : Flow_period;
+}
+
+
+unsigned long Flow_Per_Hour(unsigned long Period)				// rotations per hour, 0: no period
+{
+	return Period ? (32768UL*3600 + Period/2)/Period : 0;
+}
+#endif
+
+
+#if Skip_detect
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Skip detection. ESICNT2 counts down once per jump. Skip_Event() takes the 16-bit distance from
+// the last one, so jumps that came together lose no count. While the TSM already runs at the
+// fastest rate, the flow is beyond what it can follow: the jumps are added to the last entry of
+// the log instead of filling it. Skip_Event() writes Skip_copy in RAM; Info_Save() copies it to
+// the other copy of Skip_Log and renews the CRC in the main loop.
+
+struct Skip_entry
+{
+	unsigned long Time;									// TA2 stamp of the flow rate, ACLK cycles
+	long          Net;									// Tot_Net() at the jump, sensor states
+	unsigned char Level;								// Rate_level before the jump
+	unsigned char Skips;								// jumps of the entry, at most 255
+};
+
+struct Skip_log
+{
+	unsigned int  Version;
+	unsigned int  Sequence;								// of the save, see Info_Copy()
+	unsigned char Next;									// entry written next
+	unsigned char Entries;
+	unsigned long Total;								// jumps over all runs
+	struct Skip_entry Entry[Skip_log_size];
+	unsigned int  CRC;									// CRC-16-CCITT of the fields above
+};
+
+#pragma PERSISTENT(Skip_Log)
+struct Skip_log Skip_Log[2] = {0};						// kept over a reset, written in turn by Info_Save()
+unsigned char Skip_saved_copy = 0;						// Skip_Log[] of the last save
+
+struct Skip_log Skip_copy;								// Skip_Log with the jumps not yet saved
+unsigned long Skip_total = 0;							// jumps since Skip_Init()
+unsigned long Skip_saved = 0;							// Skip_total at the last Info_Save()
+unsigned int  Skip_last;								// ESICNT2 at the last Skip_Event()
+
+
+unsigned int Skip_CRC(unsigned char Copy)
+{
+	struct Skip_log *Log = &Skip_Log[Copy];
+
+	return Info_CRC((unsigned char*)Log, (unsigned char*)&Log->CRC - (unsigned char*)Log);	// the host pads after the CRC
+}
+
+
+void Skip_Init(void)											// after ESIEN has reset the counters
+{
+	unsigned char i, Valid = 0;
+
+	for (i=0; i<2; i++)
+		if ((Skip_Log[i].Version == Skip_version) && (Skip_Log[i].CRC == Skip_CRC(i))) Valid |= BIT0 << i;
+	Skip_saved_copy = Info_Copy(Valid, Skip_Log[0].Sequence, Skip_Log[1].Sequence);
+	if (Skip_saved_copy > 1)
+	{
+		Skip_saved_copy = 0;
+		Skip_Log[0].Next = 0;
+		Skip_Log[0].Entries = 0;
+		Skip_Log[0].Total = 0;
+		Skip_Log[0].Version = Skip_version;
+		Skip_Log[0].Sequence = 0;
+		Skip_Log[0].CRC = Skip_CRC(0);
+	}
+	Skip_copy = Skip_Log[Skip_saved_copy];
+	Info_unsaved &= ~BIT1;
+	Skip_total = 0;
+	Skip_saved = 0;
+	Skip_last = ESICNT2;
+
+	ESIINT2 &= ~(ESIIS2_3+ESIIFG4);								// ESIIFG4 at every change of ESICNT2
+	ESIINT1 |= ESIIE4;
+}
+
+
+unsigned char Skip_Event(void)									// called by the ESIIFG4 interrupt, 1: Info_Save() is due
+{
+	unsigned int Count = ESICNT2;
+	unsigned int Skips = (Skip_last - Count) & 0xFFFF;			// ESICNT2 counts down, int is 32 bits on the host
+	unsigned long Unsaved = Skip_total - Skip_saved;			// jumps not in Skip_Log yet
+	unsigned char Level = 0, Due, i;
+
+	if (!Skips) return 0;
+	Skip_last = Count;
+	Skip_total += Skips;
+	Skip_copy.Total += Skips;
+#if Rate_governor
+	Level = Rate_level;
+	Rate_Skip();
+#endif
+#if Flow_meter
+	Flow_stamps = 0;											// the next period would span a missed state
+#endif
+
+	Due = (Unsaved < Skip_save_jumps) && (Unsaved + Skips >= Skip_save_jumps);	// once between two saves
+	i = Skip_copy.Next ? Skip_copy.Next - 1 : Skip_log_size - 1;	// last entry
+	if (Level || !Skip_copy.Entries)
+	{
+		i = Skip_copy.Next;
+		if (++Skip_copy.Next == Skip_log_size) Skip_copy.Next = 0;
+		if (Skip_copy.Entries < Skip_log_size) Skip_copy.Entries++;
+#if Flow_meter
+		Skip_copy.Entry[i].Time = Flow_Stamp();
+#else
+		Skip_copy.Entry[i].Time = 0;
+#endif
+		Skip_copy.Entry[i].Net = Tot_Net();
+		Skip_copy.Entry[i].Level = Level;
+		Skip_copy.Entry[i].Skips = 0;
+		Due = 1;												// a new entry is saved at once
+	}
+	Info_unsaved |= BIT1;
+	Skips += Skip_copy.Entry[i].Skips;
+	Skip_copy.Entry[i].Skips = (Skips > 255) ? 255 : Skips;
+	return Due;
+}
+
+
+unsigned long Skip_Count(void)									// jumps since Skip_Init()
+{
+	unsigned long Total;
+	unsigned int Last, Count;
+
+	do {
+		Total = Skip_total;
+		Last = Skip_last;
+		Count = ESICNT2;
+	} while ((Total != Skip_total) || (Last != Skip_last));
+	return Total + ((Last - Count) & 0xFFFF);					// with the jumps Skip_Event() has not taken yet
+}
+#endif
+
+
+#if Flow_meter || Skip_detect
+void Info_Save(void)											// from main(), after Flow_Overflow() or Skip_Event() has asked for it
+{
+	unsigned char Unsaved;
+#if Flow_meter
+	unsigned char i, Hist_copy = Flow_copy ^ 1;
+	struct Flow_hist *Hist = &Flow_Hist[Hist_copy];
+#endif
+#if Skip_detect
+	unsigned char Log_copy = Skip_saved_copy ^ 1;
+	struct Skip_log *Log = &Skip_Log[Log_copy];
+#endif
+
+	__bic_SR_register(GIE);										// Flow_Q6() and Skip_Event() run in the ESI interrupt
+	Unsaved = Info_unsaved;
+	Info_unsaved = 0;
+#if Flow_meter
+	if (Unsaved&BIT0)
+	{
+		for (i=0; i<Flow_bins; i++)								// into the other copy, the last save stays valid
+		{
+			Hist->Count[i] = Flow_Hist[Flow_copy].Count[i] + Flow_new[i];
+			Flow_new[i] = 0;
+		}
+	}
+#endif
+#if Skip_detect
+	if (Unsaved&BIT1)
+	{
+		*Log = Skip_copy;										// into the other copy as well
+		Skip_saved = Skip_total;
+	}
+#endif
+	__bis_SR_register(GIE);
+#if Flow_meter
+	if (Unsaved&BIT0)											// the interrupts only write RAM
+	{
+		Hist->Version = Flow_version;
+		Hist->Sequence = Flow_Hist[Flow_copy].Sequence + 1;
+		Hist->CRC = Flow_CRC(Hist_copy);
+		Flow_copy = Hist_copy;									// the save is complete
+	}
+#endif
+#if Skip_detect
+	if (Unsaved&BIT1)
+	{
+		Log->Sequence = Skip_Log[Skip_saved_copy].Sequence + 1;
+		Log->CRC = Skip_CRC(Log_copy);
+		Skip_saved_copy = Log_copy;
+	}
+#endif
+}
+#endif
@@ -0,0 +1,202 @@
+/*
+ * ScanIF.h
+ *
+ *  Created on: Nov 29, 2012
+ *
+ * Shared by all meter projects with ScanIF.c; the values of a meter are in its
+ * ScanIF_Layout.h.
+ *
+ */
+
+#ifndef SCANIF_H_
+#define SCANIF_H_
+
+#include "Task.h"
+
+#define AFE2_enable        1
+
+// Search mode of FindDAC()
+#define DAC_search_SAR     0          // 12 TSM sequences, one AFE1 probe per channel
+#define DAC_search_dual    1          // 8 TSM sequences, an AFE1 and an AFE2 probe per channel
+
+#ifndef DAC_search_mode
+#define DAC_search_mode    DAC_search_dual
+#endif
+
+// Calibration snapshot in INFO FRAM: InitScanIF() resumes with the calibration
+// of the last run after a reset, if it is still valid
+#define Snapshot_enable    1
+#define Snapshot_version   2          // change when the snapshot layout changes
+
+// Set_DAC(): after the separation is found, sample until the signal range has been
+// stable over Set_DAC_stable_edges sensor state changes of channel 0 (about one
+// revolution), at most Set_DAC_max_loops times. A search that moved a channel by its full
+// range (31 codes in 5 steps) could not follow the signal: the next one takes
+// Set_DAC_wide_steps, so that the range reaches the extremes before it counts as stable.
+// A fast rotor gives few searches per revolution: the range must also have been stable
+// over Set_DAC_stable_loops searches. 0 keeps the fixed 1 second tail.
+#ifndef Set_DAC_adaptive
+#define Set_DAC_adaptive     1
+#endif
+#define Set_DAC_stable_edges 3        // 2 per revolution
+#define Set_DAC_stable_loops 12       // 2.3 revolutions at 90 rps
+#define Set_DAC_max_loops    468      // 1 second at 2340 Hz using FindDAC_Fast_Successive()
+#define Set_DAC_wide_steps   7        // 127 codes
+
+// Find_Noise_level(): stop before the 234 loops as soon as the noise variance of every
+// channel has settled to 1/Noise_tolerance between two checks and the spread fits the
+// Gaussian bound of 234 loops. 0 always runs the 234 loops.
+#ifndef Noise_early_exit
+#define Noise_early_exit     1
+#endif
+#define Noise_min_loops      32       // first check
+#define Noise_check_loops    16       // loops between two checks, power of 2
+#define Noise_tolerance      8
+
+// AFE2 drift tracker in normal operation, in place of the ReCalScanIF() burst every
+// Time_to_Recal (TSM_rate_cal, 4 rotations): every Drift_probe_interval-th Q6 event
+// AFE2 compares the next TSM_rate_run sequence with the tracked level of the sensor
+// state, and ESIDAC1R follows the averaged drift one DAC code at a time.
+// 0 keeps the ReCalScanIF() burst.
+#ifndef Drift_tracker
+#define Drift_tracker        AFE2_enable
+#endif
+#define Drift_probe_interval 13       // Q6 events, not a multiple of Tot_states
+#define Drift_ewma_weight    16       // AFE2_drift averages about the last 16 probes of a channel
+
+// Temperature compensation of the drift tracker: Timer_A0 reads the internal temperature
+// sensor (ADC12_B) every Temp_period. A slope of AFE2_drift against the temperature is
+// learned per channel whenever the temperature has changed by Temp_learn_step, kept in
+// INFO FRAM over a reset, and applied to the tracked levels and ESIDAC1R at every reading.
+// While the tracker corrects no more than Temp_accuracy over Temp_stretch_ticks readings,
+// the probe interval doubles (13, 25, 49, 97 Q6 events). 0: no temperature readings.
+// With Task_scheduler the conversions run as one ADC12 sequence while the CPU sleeps:
+// Temp_Start() on the TA0 event, Temp_Sample() in the interrupt, then Temp_Update().
+// Needs Drift_tracker.
+#ifndef Temp_comp
+#define Temp_comp            Drift_tracker
+#endif
+#if Temp_comp && !Drift_tracker
+#error "Temp_comp needs Drift_tracker"
+#endif
+#define Temp_period          8192     // 2 s of ACLK/8
+#define Temp_samples         4        // ADC12 conversions per reading, summed
+#define Temp_learn_step      64       // about 2 degC of the summed conversions
+#define Temp_step_max        4        // DAC codes applied per reading
+#ifndef Temp_accuracy
+#define Temp_accuracy        2        // DAC codes
+#endif
+#define Temp_stretch_ticks   8
+#define Temp_stretch_max     3
+#define Temp_version         2        // change when the layout of the FRAM model changes
+
+// ESIOSC drift in normal operation: on the Temp_period wakes, EsioscReCal() is started every
+// Osc_period wakes or when the temperature has changed by Osc_temp_step since the last run,
+// and then makes one ESICLKFQ step per wake. When it has moved ESICLKFQ, the TSM delay chains
+// are rescaled to the ESIOSC cycles they had at the TSM calibration. Needs Temp_comp.
+#ifndef Osc_tracker
+#define Osc_tracker          Temp_comp
+#endif
+#if Osc_tracker && !Temp_comp
+#error "Osc_tracker needs Temp_comp"
+#endif
+#define Osc_period           150      // 5 minutes of Temp_period
+#define Osc_temp_step        32       // about 1 degC of the summed conversions
+
+// Flow-adaptive TSM rate in normal operation: the Q6 interrupt measures the time between two
+// sensor state changes on TA0R, averaged over Rate_weight of them, and switches to a faster
+// ESIDIV3 rate of Rate_divider[] as soon as a state gets fewer than Rate_margin TSM sequences,
+// or a single one fewer than Rate_margin_single. After Rate_down_events state changes that
+// all allow a slower rate with Rate_margin_down, it steps down to it. Without a state change
+// for two Temp_period, the slowest rate (73 Hz) is used until the next one, which returns
+// to Rate_start, the TSM_rate_run of the calibration. Margins in 1/4 TSM sequences per sensor
+// state; Rate_start and Rate_margin_down are in ScanIF_Layout.h. Reverse flow sets no Q6 flag:
+// when ESICNT1 has gone down over a Temp_period, the rate of the calibration is kept. Needs Temp_comp.
+#ifndef Rate_governor
+#define Rate_governor        Temp_comp
+#endif
+#if Rate_governor && !Temp_comp
+#error "Rate_governor needs Temp_comp"
+#endif
+#define Rate_levels          6
+#define Rate_margin          8        // 2 TSM sequences per state
+#define Rate_margin_single   6        // 1.5, a single interval, TA0R counts 8 ACLK
+#define Rate_down_events     32
+#define Rate_weight          4        // the state changes are seen at whole TSM sequences
+
+// Totalizer: ESICNT1 (forward minus reverse state changes) and ESICNT0 (forward state changes,
+// the PSM table counts up on them only) extended to 32 bits. ESICNT1 reaching ESITHR1/ESITHR2,
+// Tot_sync_states away from the last sync, and ESICNT0 wrapping to zero are the only ESI
+// interrupts it adds. The volumes are in sensor states, Tot_states (ScanIF_Layout.h) per rotation.
+#ifndef Totalizer
+#define Totalizer            1
+#endif
+#define Tot_sync_states      0x4000   // below half the ESICNT1 range
+
+// Flow rate: the Q6 interrupt stamps every forward state change with TA2, free-running on
+// ACLK, and keeps the period of the rotation ending there, its average over about
+// 2^Flow_shift rotations and the shortest one. Flow_Hist in FRAM counts the state
+// changes per octave of the rotation period, bin 0 below 2^(Flow_bin_first+1) ACLK, with a
+// CRC-16; Info_Save() adds the counts of the last 2 s to it in the main loop, after the TA2
+// overflow interrupt, writing its two copies in turn.
+// The rates are only computed when they are read, Flow_Per_Hour().
+#ifndef Flow_meter
+#define Flow_meter           1
+#endif
+#define Flow_shift           3
+#define Flow_bins            16
+#define Flow_bin_first       8        // 256 ACLK, 128 rps
+#define Flow_version         3        // change when the layout of Flow_Hist changes
+
+// Skip detection: the PSM tables count a jump over a sensor state, two sensors changed within
+// one TSM sequence because the TSM rate is too slow for the flow, on ESICNT2 (which counts
+// ESICNT0 up as well). ESIIFG4 is set at every jump: Skip_Event() switches to the fastest
+// TSM rate at once and logs the jump in Skip_Log in FRAM, the last Skip_log_size of them,
+// with a CRC-16: Info_Save() writes one of its two copies in the main loop when an entry
+// opens, after Skip_save_jumps jumps and after the TA2 overflow of the flow meter.
+// Tot_Forward() leaves the jumps out; with 0 they count as forward state changes. Needs Totalizer.
+#ifndef Skip_detect
+#define Skip_detect          Totalizer
+#endif
+#if Skip_detect && !Totalizer
+#error "Skip_detect needs Totalizer"
+#endif
+#define Skip_log_size        8
+#define Skip_save_jumps      128      // unsaved jumps that call for Info_Save()
+#define Skip_version         3        // change when the layout of Skip_Log changes
+
+void InitScanIF(void);
+void ReCalScanIF(void);
+void Drift_Init(void);
+void Drift_Probe_Start(void);
+void Drift_Probe_End(void);
+void Temp_Init(void);
+void Temp_Update(void);
+void Temp_Start(void);
+void Temp_Sample(void);
+void Osc_Init(void);
+void Osc_Update(void);
+void Rate_Init(void);
+void Rate_Q6(void);
+void Rate_Tick(void);
+void Rate_Skip(void);
+void Tot_Init(void);
+void Tot_Threshold(void);
+void Tot_Wrap(void);
+unsigned long Tot_Forward(void);
+unsigned long Tot_Reverse(void);
+long Tot_Net(void);
+unsigned long Tot_Rotations(void);
+void Flow_Init(void);
+void Flow_Q6(void);
+unsigned char Flow_Overflow(void);
+unsigned long Flow_Period_Now(void);
+unsigned long Flow_Per_Hour(unsigned long );
+void Skip_Init(void);
+unsigned char Skip_Event(void);
+unsigned long Skip_Count(void);
+void Info_Save(void);
+
+
+
+#endif /* SCANIF_H_ */
@@ -10,7 +10,9 @@ C_SRCS += \
 ../ESI_ESIOSC.c \
 ../IIC.c \
 ../LCD.c \
-../ScanIF.c \
+../../ESI_SCANIF/ScanIF.c \
+../Task.c \
+../Trace.c \
 ../main.c 
 
 OBJS += \
@@ -18,6 +20,8 @@ OBJS += \
 ./IIC.obj \
 ./LCD.obj \
 ./ScanIF.obj \
+./Task.obj \
+./Trace.obj \
 ./main.obj 
 
 C_DEPS += \
@@ -25,6 +29,8 @@ C_DEPS += \
 ./IIC.d \
 ./LCD.d \
 ./ScanIF.d \
+./Task.d \
+./Trace.d \
 ./main.d 
 
 C_DEPS__QUOTED += \
@@ -32,6 +38,8 @@ C_DEPS__QUOTED += \
 "IIC.d" \
 "LCD.d" \
 "ScanIF.d" \
+"Task.d" \
+"Trace.d" \
 "main.d" 
 
 OBJS__QUOTED += \
@@ -39,13 +47,17 @@ OBJS__QUOTED += \
 "IIC.obj" \
 "LCD.obj" \
 "ScanIF.obj" \
+"Task.obj" \
+"Trace.obj" \
 "main.obj" 
 
 C_SRCS__QUOTED += \
 "../ESI_ESIOSC.c" \
 "../IIC.c" \
 "../LCD.c" \
-"../ScanIF.c" \
+"../../ESI_SCANIF/ScanIF.c" \
+"../Task.c" \
+"../Trace.c" \
 "../main.c" 
 
 
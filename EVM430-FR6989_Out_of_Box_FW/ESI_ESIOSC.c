@@ -3,14 +3,19 @@
  *
  */
 #include "msp430fr6989.h"
+#include "ESI_ESIOSC.h"
 
 unsigned char v_status=0;
+signed short  v_slope=0;								// 1/64 ESIOSC cycles per ACLK period per ESICLKFQ step, 0: not known yet
+signed char   Esiosc_error=0;							// error of EsioscInit() in ESIOSC cycles per ACLK period
+unsigned char Esiosc_target=0;							// target of EsioscInit(), for EsioscReCal()
 
 //--------------------------------------------------------------------------
 
 void setESICLKFQ(unsigned char setting);
 unsigned char getESICLKFQ();
 unsigned char MeasureEsiosc_Oversampling(void);
+unsigned int MeasureEsiosc_Sum(void);
 unsigned char EsioscMeasure();
 
 //--------------------------------------------------------------------------
@@ -34,16 +39,21 @@ void setESICLKFQ(unsigned char setting)
 	ESIOSC = temp;
 }
 
-unsigned char MeasureEsiosc_Oversampling()
-// this function does an averaging of 4 ESIOSC measurement results
+unsigned int MeasureEsiosc_Sum()
+// this function sums 4 ESIOSC measurement results, 1/4 cycle resolution
 { unsigned int temp;
 
   temp = (unsigned int) EsioscMeasure();
   temp = temp + (unsigned int) EsioscMeasure();
   temp = temp + (unsigned int) EsioscMeasure();
   temp = temp + (unsigned int) EsioscMeasure();
-  temp = temp / 4;
-  return (unsigned char)temp;
+  return temp;
+}
+
+unsigned char MeasureEsiosc_Oversampling()
+// this function does an averaging of 4 ESIOSC measurement results
+{
+  return (unsigned char)(MeasureEsiosc_Sum() / 4);
 }
 
 //--------------------------------------------------------------------------
@@ -70,82 +80,135 @@ void EsioscInit(unsigned char target)
 //--- ensure that ACLK is stable running before calling this function.
 // target: number of ESIOSC cycles within one ACLK period
 //            (e.g. 4.8MHz/ACLK = 4.8MHz/32768Hz = 146.484375 ~ 146)
+// The frequency is nearly linear in ESICLKFQ. The slope is measured once over
+// ESIOSC_slope_steps settings, the setting predicted for the target is loaded, and
+// the neighbouring settings are measured until the closest one is bracketed.
+// Result: Esiosc_error, the remaining error in ESIOSC cycles per ACLK period.
 {
-	unsigned char v_Measure;  							// storing the measurement result
-	signed short v_Delta;     							// storing the delta between measurement and target
-	unsigned char v_Setting;  							// storing actual ESIOSC bit setting
+	signed short v_Delta;     							// storing the delta between measurement and target, 1/4 cycles
 	signed short v_min;       							// storing minimum delta (v_Delta) within measurement sequence
+	unsigned char v_Setting;  							// storing actual ESIOSC bit setting
 	signed char v_adder;      							// defines if ESIOSC settings should be incremented or decremented
-	unsigned char var;
+	signed short var;
 
-	  // decide if actual ESIOSC frequency is too high or too low
-	  v_Measure = MeasureEsiosc_Oversampling();
-	  v_min = v_Measure - target;
+	  Esiosc_target = target;
 	  v_Setting = getESICLKFQ();
-	  if (v_Measure > target)
-	  	v_adder = -1;         							// decrement should be used for following adjustment loop
-	  else if (v_Measure < target)
-		v_adder = 1;          							// increment should be used for following adjustment loop
-
-	  if (v_Measure != target) 							// continue only if ESIOSC frequency is not target frequency
-	  {  // following measurements: adjust ESIOSC frequency till it is closest to target
-	    do
+	  v_min = (signed short)MeasureEsiosc_Sum() - 4*target;
+
+	  // jump: characterize the slope on the way towards the target, then go to the predicted setting
+	  if (abs(v_min) > 8)									// more than 2 cycles, about 2 steps
+	  {
+	    if (v_slope == 0)
 	    {
-	      var = getESICLKFQ();
-	      if ((var==0x00) || (var==0x3F))  				// check for under- or overflow
-	      {	  break;
-	      }
-	      setESICLKFQ(var+v_adder);
-	      v_Measure = MeasureEsiosc_Oversampling();
-	      v_Delta = v_Measure - target;
-	      if (abs(v_Delta) < abs(v_min))
-	      {	v_min = v_Delta;
-	      	v_Setting = getESICLKFQ();
-	      }
-	    } while (v_min == v_Delta);
-	    setESICLKFQ(v_Setting);
+	      var = (v_min > 0) ? v_Setting - ESIOSC_slope_steps : v_Setting + ESIOSC_slope_steps;
+	      if (var < 0)    var = v_Setting + ESIOSC_slope_steps;	// no room towards the target, go the other way
+	      if (var > 0x3F) var = v_Setting - ESIOSC_slope_steps;
+	      setESICLKFQ(var);
+	      v_Delta = (signed short)MeasureEsiosc_Sum() - 4*target;
+	      var = (v_Delta - v_min)*16/(var - v_Setting);	// 1/64 cycles per ESICLKFQ step
+	      if (var >= ESIOSC_slope_min) v_slope = var;
+	      setESICLKFQ(v_Setting);
+	    }
+	    if (v_slope)
+	    {
+	      var = v_Setting - (v_min*16 + ((v_min > 0) ? v_slope/2 : -v_slope/2))/v_slope;	// rounded
+	      if (var < 0)    var = 0;
+	      if (var > 0x3F) var = 0x3F;
+	      setESICLKFQ(var);
+	      v_Setting = var;
+	      v_min = (signed short)MeasureEsiosc_Sum() - 4*target;
+	    }
+	  }
+
+	  // bracketed search: step towards the target until the error changes its sign or grows
+	  v_adder = (v_min > 0) ? -1 : 1;
+	  while (v_min != 0)
+	  {
+	    var = v_Setting + v_adder;
+	    if ((var < 0) || (var > 0x3F))  					// check for under- or overflow
+	    	break;
+	    setESICLKFQ(var);
+	    v_Delta = (signed short)MeasureEsiosc_Sum() - 4*target;
+	    if (abs(v_Delta) < abs(v_min))
+	    {	v_min = v_Delta;
+	      	v_Setting = var;
+	    }
+	    if ((v_Delta > 0) != (v_adder < 0))				// target bracketed
+	    	break;
+	    if (v_min != v_Delta)								// no closer setting in this direction
+	    	break;
 	  }
+	  setESICLKFQ(v_Setting);
+
+	  Esiosc_error = (v_min > 0) ? (v_min + 2)/4 : -((2 - v_min)/4);
 }
 
 
 unsigned char EsioscReCal(unsigned char target)
 //--- ensure that ACLK is stable running before calling this function.
-{  unsigned char val;
+// One ESICLKFQ step per call, the search state is kept in v_status between the calls.
+// The first step goes to the setting predicted by v_slope of EsioscInit(), the next ones
+// step by one setting until the target is bracketed. A jump that overshot the target
+// and left a larger deviation steps back from the predicted setting.
+// A deviation within half a step of v_slope is left alone, so that the measurement
+// noise does not move the setting back and forth.
+// return value: 0x00 done, 0x01 another call is needed, 0xFF limit of the ESICLKFQ settings
+{  static signed short v_min;
+   static unsigned char v_Setting;
+   static signed char v_adder;
    unsigned char RetValue;
-   signed short v_Delta;
-   volatile signed short v_min;
-   volatile unsigned char v_Setting;
-   volatile signed char v_adder;
+   signed short v_Delta, var;
 
-   val = EsioscMeasure();
-   v_Delta= val - target;
+   v_Delta = (signed short)MeasureEsiosc_Sum() - 4*target;	// 1/4 cycles
    switch (v_status)
    { case 0:   //--- idle, no measurement is running. New sequence is started.
-     		   if (val > target)
-	    	  	 v_adder = -1;         					// decrement should be used for following adjustment loop
-		       if (val < target)
-   			     v_adder = 1;          					// increment should be used for following adjustment loop
-	   	       if (val == target)
-	   	       {  RetValue=0x00;       					// ESIOSC frequency and target frequency are already equal
+	   	       if (abs(v_Delta) <= (v_slope ? v_slope/32 : 2))
+	   	       {  v_min=v_Delta;
+	   	    	  RetValue=0x00;       					// ESIOSC frequency and target frequency are already equal
 	   	    	  break;
 	   	       }
+	    	   v_adder = (v_Delta > 0) ? -1 : 1;		// decrement or increment in the following adjustment loop
      		   v_min=v_Delta;
      		   v_Setting=getESICLKFQ();
-     		   if ((v_Setting==0x00)||(v_Setting==0x3F))
+     		   var = v_Setting + v_adder;
+     		   if (v_slope && (abs(v_Delta) > 8))		// more than 2 cycles: go to the setting predicted by v_slope
+     			   var = v_Setting - (v_Delta*16 + ((v_Delta > 0) ? v_slope/2 : -v_slope/2))/v_slope;
+     		   if (var < 0)    var = 0;
+     		   if (var > 0x3F) var = 0x3F;
+     		   if (var == v_Setting)
      		   {   RetValue=0xFF;      					// limits for ESICLKFQx bit settings was reached: terminate Re-Calibration
      			   break;
      		   }
-     		   setESICLKFQ(v_Setting+v_adder);
-	   		   v_status=1;
+     		   setESICLKFQ(var);
+	   		   v_status=(var == v_Setting + v_adder) ? 1 : 2;
 	   	   	   RetValue=0x01;        					// re-calibration not yet completed. Another function call is needed.
 	   	   	   break;
 
+     case 2:   //--- the predicted setting was loaded.
+    	 	   if ((abs(v_Delta)>=abs(v_min))&&((v_Delta>0)==(v_adder>0)))	// overshot: step back from the predicted setting
+    	 	   {  v_min=v_Delta;
+    	 	   	  v_Setting=getESICLKFQ();
+    	 	   	  v_adder=-v_adder;
+    	 	   	  setESICLKFQ(v_Setting+v_adder);		// between the predicted and the old setting, in range
+    	 	   	  v_status=1;
+    	 	   	  RetValue=0x01;
+    	 	   	  break;
+    	 	   }
+    	 	   v_status=1;								// closer, or not over the target: go on as a step
+    	 	   // no break
+
      case 1:   //--- measurement sequence was started.
     	 	   if (abs(v_Delta)<abs(v_min))
     	 	   {  v_min=v_Delta;
     	 	   	  v_Setting=getESICLKFQ();
-        		  if ((v_Setting==0x00)||(v_Setting==0x3F))
-        		   {   RetValue=0xFF;  					// limits for ESICLKFQx bit settings was reached: terminate Re-Calibration
+        		  if ((v_Delta>0)==(v_adder>0))			// target bracketed
+        		  {  v_status=0;
+        		     RetValue=0x00;
+        		     break;
+        		  }
+        		  if (((v_Setting==0x00)&&(v_adder<0))||((v_Setting==0x3F)&&(v_adder>0)))
+        		   {   v_status=0;
+        			   RetValue=0xFF;  					// limits for ESICLKFQx bit settings was reached: terminate Re-Calibration
         			   break;
         		   }
     	 	   	  setESICLKFQ(v_Setting+v_adder);
@@ -157,7 +220,13 @@ unsigned char EsioscReCal(unsigned char target)
     	 		  RetValue=0x00;    					// re-calibration completed. Found new setting.
     	 	   }
  	   	       break;
+
+     default:  v_status=0;
+    	 	   RetValue=0xFF;
+    	 	   break;
    }
 
+   if (v_status == 0)
+	   Esiosc_error = (v_min > 0) ? (v_min + 2)/4 : -((2 - v_min)/4);
    return RetValue;
 }
@@ -19,6 +19,12 @@
 //  This two bytes tell the number (int format) of rotation of motor.
 //  The first byte is the low byte
 //  The second byte is the upper byte of an integer
+//  With IIC_count_long it receives the 32-bit number and the status of the motor board,
+//  five bytes in one burst.
+//
+//  With IIC_queue both only queue the transaction (IIC_Submit) and return,
+//  USCI_B0_ISR transfers it and calls the Done() callback of IIC_RX at the STOP.
+//  With IIC_dma DMA channel 0 moves the bytes, USCI_B0_ISR only ends the transaction.
 //
 //  ACLK = n/a, MCLK = SMCLK =  DCO = 4MHz
 //
@@ -38,10 +44,31 @@
 
 #include "msp430fr6989.h"
 #include "IIC.h"
-
+#include "Trace.h"
+
+#if IIC_queue && IIC_dma
+#define IIC_IE   (UCSTPIE | UCNACKIE | UCCLTOIE)					// the bytes are moved by DMA channel 0
+#else
+#define IIC_IE   (UCTXIE | UCRXIE  | UCSTPIE | UCNACKIE | UCCLTOIE)
+#endif
+
+#if IIC_queue
+static IIC_Xfer *IIC_List[IIC_queue_size];					// submitted transactions, IIC_List[IIC_Head] on the bus
+static unsigned char IIC_Head;
+static volatile unsigned char IIC_Num;
+#if !IIC_dma
+static unsigned char IIC_Index;								// bytes of the running transaction
+#endif
+static unsigned char IIC_Result;							// its status at the STOP
+
+static IIC_Xfer IIC_Command[IIC_queue_size];				// IIC_TX()
+static unsigned char Command_Data[IIC_queue_size];
+static IIC_Xfer IIC_Count;									// IIC_RX()
+#else
 unsigned char TXData[5];
 volatile unsigned char TXByteCtr;
 volatile unsigned char RXByteCtr;
+#endif
 
 
 void Set_IIC_Timeout()
@@ -71,11 +98,141 @@ void Set_IIC()
   UCB0I2CSA = Slave_Add;
 
   UCB0CTLW0 &= ~UCSWRST;                    						// clear reset register
-  UCB0IE |= UCTXIE | UCRXIE  | UCSTPIE | UCNACKIE | UCCLTOIE;     	// Enable interrupts
+  UCB0IE |= IIC_IE;     											// Enable interrupts
 
+#if IIC_queue
+  IIC_Head = 0;
+  IIC_Num = 0;
+#else
   RXByteCtr = 0;
+#endif
+}
+
+#if IIC_queue
+static void IIC_Reset(void)									// clock low or timeout: reset the eUSCI_B0 only
+{
+  UCB0CTLW0 |= UCSWRST;
+  UCB0CTLW0 &= ~UCSWRST;
+  UCB0IE |= IIC_IE;
+}
+
+static void IIC_Start(void)									// IIC_List[IIC_Head], interrupts disabled
+{
+  IIC_Xfer *x = IIC_List[IIC_Head];
+
+  x->Status = IIC_busy;
+  IIC_Result = IIC_done;
+#if IIC_dma
+  DMA0CTL &= ~DMAEN;
+  if (x->Read)												// UCB0RXBUF to the buffer on every UCB0RXIFG0
+  {
+	  DMACTL0 = (DMACTL0 & ~DMA0TSEL_31) | DMA0TSEL__UCB0RXIFG0;
+	  __data16_write_addr((unsigned short)&DMA0SA, (unsigned long)&UCB0RXBUF);
+	  __data16_write_addr((unsigned short)&DMA0DA, (unsigned long)x->Data);
+	  DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_3 | DMASRCBYTE | DMADSTBYTE;
+  }
+  else														// the buffer to UCB0TXBUF on every UCB0TXIFG0
+  {
+	  DMACTL0 = (DMACTL0 & ~DMA0TSEL_31) | DMA0TSEL__UCB0TXIFG0;
+	  __data16_write_addr((unsigned short)&DMA0SA, (unsigned long)x->Data);
+	  __data16_write_addr((unsigned short)&DMA0DA, (unsigned long)&UCB0TXBUF);
+	  DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASRCBYTE | DMADSTBYTE;
+  }
+  DMA0SZ = x->Length;
+  DMA0CTL |= DMAEN;											// armed before the START sets UCB0TXIFG0
+#else
+  IIC_Index = 0;
+#endif
+
+  UCB0CTLW0 |= UCSWRST;										// UCB0TBCNT is written in reset
+  UCB0TBCNT = x->Length;									// automatic stop after the last byte
+  UCB0CTLW0 &= ~UCSWRST;
+  UCB0IE |= IIC_IE;
+
+  UCB0I2CSA = x->Address;
+  if (x->Read)
+	  UCB0CTLW0 &= ~UCTR;
+  else
+	  UCB0CTLW0 |= UCTR;
+  UCB0CTLW0 |= UCTXSTT;										// start condition, the rest in USCI_B0_ISR
+
+  TA1CTL |= TACLR;
+  TA1CTL |= MC_1;
+}
+
+static unsigned char IIC_End(unsigned char Status)			// in the interrupt, 1: wake the main loop
+{
+  IIC_Xfer *x = IIC_List[IIC_Head];
+
+  TA1CTL &= ~MC_1;
+#if IIC_dma
+  DMA0CTL &= ~DMAEN;										// the rest of a transaction ended by a NACK or timeout
+#endif
+  IIC_Head = (IIC_Head + 1) & (IIC_queue_size - 1);
+  IIC_Num--;
+  x->Status = Status;
+  if (IIC_Num)
+	  IIC_Start();											// the next one, before Done() may submit more
+  return x->Done ? x->Done(x) : 0;
+}
+
+unsigned char IIC_Submit(IIC_Xfer *x)
+{
+  unsigned int SR = __get_SR_register();
+  unsigned char Queued = 0;
+
+  __disable_interrupt();
+  if ((IIC_Num < IIC_queue_size) && !IIC_pending(x))
+  {
+	  x->Status = IIC_queued;
+	  IIC_List[(IIC_Head + IIC_Num) & (IIC_queue_size - 1)] = x;
+	  if (IIC_Num++ == 0)
+		  IIC_Start();
+	  Queued = 1;
+  }
+  if (SR & GIE)
+	  __enable_interrupt();
+  return Queued;
+}
+
+unsigned char IIC_TX(unsigned char Data)
+{
+  unsigned int SR = __get_SR_register();
+  unsigned char i, Queued = 0;
+
+  __disable_interrupt();
+  for (i = 0; i < IIC_queue_size; i++)
+	  if (!IIC_pending(&IIC_Command[i]))					// a free command
+	  {
+		  Command_Data[i] = Data;
+		  IIC_Command[i].Address = Slave_Add;
+		  IIC_Command[i].Read = 0;
+		  IIC_Command[i].Length = 1;
+		  IIC_Command[i].Data = &Command_Data[i];
+		  IIC_Command[i].Done = 0;
+		  Queued = IIC_Submit(&IIC_Command[i]);
+		  break;
+	  }
+  if (SR & GIE)
+	  __enable_interrupt();
+  return Queued;
+}
+
+unsigned char IIC_RX(unsigned char (*Done)(IIC_Xfer *x))
+{
+  if (IIC_pending(&IIC_Count))								// the last read has not ended yet
+	  return 0;
+
+  IIC_Count.Address = Slave_Add;
+  IIC_Count.Read = 1;
+  IIC_Count.Length = IIC_count_bytes;
+  IIC_Count.Data = (unsigned char *)Master_RXData;
+  IIC_Count.Done = Done;
+  return IIC_Submit(&IIC_Count);
 }
 
+#else
+
 void IIC_TX(unsigned char Data)
 {
 
@@ -101,7 +258,7 @@ void IIC_TX(unsigned char Data)
 void IIC_RX()
 {
 
-	UCB0TBCNT = 0x0002;                       				// number of bytes to be received
+	UCB0TBCNT = IIC_count_bytes;              				// number of bytes to be received
 	RXByteCtr = 0;
 
 	while (UCB0CTL1 & UCTXSTP);            					// Ensure stop condition got sent
@@ -116,12 +273,84 @@ void IIC_RX()
     TA1CTL &= ~MC_1;
 
 }
+#endif
+
+
+#if IIC_queue
+#pragma vector = USCI_B0_VECTOR
+__interrupt void USCI_B0_ISR(void)
+{
+#if !IIC_dma
+  IIC_Xfer *x = IIC_List[IIC_Head];
+  unsigned char Data;
+#endif
+
+#if Isr_trace
+  Trace_In(Trace_late_none);
+#endif
+
+  switch(__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG))
+  {
+    case USCI_I2C_UCNACKIFG:                				// Vector 4: NACKIFG
+    	IIC_Result = IIC_nack;
+    	UCB0CTLW0 |= UCTXSTP;								// release the bus, the transaction ends at the STOP
+    						 break;
+
+    case USCI_I2C_UCSTPIFG:                 				// Vector 8: STPIFG
+    	if (IIC_Num && IIC_End(IIC_Result))
+    		_low_power_mode_off_on_exit();
+    						 break;
+
+#if !IIC_dma
+    case USCI_I2C_UCRXIFG0:                 				// Vector 22: RXIFG0
+    	Data = UCB0RXBUF;
+    	if (IIC_Num && (IIC_Index < x->Length))
+    		x->Data[IIC_Index++] = Data;
+    						 break;
+
+    case USCI_I2C_UCTXIFG0:                 				// Vector 24: TXIFG0
+    	if (IIC_Num && (IIC_Index < x->Length))
+    		UCB0TXBUF = x->Data[IIC_Index++];
+    						 break;
+#endif
+
+    case USCI_I2C_UCCLTOIFG:                				// Vector 28: clock low timeout
+    	IIC_Reset();
+    	if (IIC_Num && IIC_End(IIC_timeout))
+    		_low_power_mode_off_on_exit();
+    						 break;
+
+    default: break;
+  }
+#if Isr_trace
+  Trace_Out(Trace_i2c);
+#endif
+}
 
+// Timer A1 interrupt service routine for I2C time out timer
+#pragma vector = TIMER1_A0_VECTOR
+__interrupt void Timer1_A (void)
+{
+#if Isr_trace
+	Trace_In(Trace_late_none);
+#endif
+	TA1CTL &= ~MC_1;
+	IIC_Reset();
+	if (IIC_Num && IIC_End(IIC_timeout))
+		_low_power_mode_off_on_exit();
+#if Isr_trace
+	Trace_Out(Trace_ta1);
+#endif
+}
 
+#else
 #pragma vector = USCI_B0_VECTOR
 __interrupt void USCI_B0_ISR(void)
 
 {
+#if Isr_trace
+  Trace_In(Trace_late_none);
+#endif
   switch(__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG))
   {
     case USCI_NONE:          break;         				// Vector 0: No interrupts
@@ -170,4 +399,8 @@ __interrupt void USCI_B0_ISR(void)
 
     default: break;
   }
+#if Isr_trace
+  Trace_Out(Trace_i2c);
+#endif
 }
+#endif
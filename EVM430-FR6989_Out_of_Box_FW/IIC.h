@@ -8,14 +8,74 @@
 #define Master_Add 0x01        // Master Address
 #define Slave_Add  0x02        // Slave Address
 
+// Transaction queue: IIC_Submit() appends a transaction and returns, USCI_B0_ISR runs it byte
+// by byte and starts the next one from its STOP. The CPU stays in LPM3 meanwhile, the eUSCI_B0
+// requests SMCLK for the transfer only. A NACK ends the transaction with a STOP, the clock low
+// timeout (UCCLTO, 34 ms) and the TA1 timeout (1 s) with a reset of the eUSCI_B0, never with
+// Set_IIC(). Done() is called from the interrupt when the transaction has ended, a non-zero
+// return wakes the main loop. IIC_TX() and IIC_RX() queue the motor board commands and reads.
+// 0: IIC_TX() and IIC_RX() wait in LPM0 until the STOP.
+#ifndef IIC_queue
+#define IIC_queue            1
+#endif
+#define IIC_queue_size       4        // transactions, power of 2
+
+// DMA: DMA channel 0, triggered by UCB0RXIFG0 or UCB0TXIFG0, moves the bytes of the running
+// transaction, USCI_B0_ISR runs once for its STOP (and for a NACK or the clock low timeout).
+// Needs IIC_queue. 0: USCI_B0_ISR moves every byte.
+#ifndef IIC_dma
+#define IIC_dma              1
+#endif
+
+// Motor board count read by IIC_RX() into Master_RXData, low byte first, in one burst:
+// 1: the 32-bit rotation counter in bytes 0..3 and the board status (its last command) in byte 4.
+// 0: the 16-bit rotation counter in bytes 0..1.
+#ifndef IIC_count_long
+#define IIC_count_long       1
+#endif
+#if IIC_count_long
+#define IIC_count_size       4        // bytes of the rotation counter
+#define IIC_count_status     4        // byte of the board status
+#define IIC_count_bytes      5
+#else
+#define IIC_count_size       2
+#define IIC_count_bytes      2
+#endif
+
+#if IIC_queue
+// IIC_Xfer.Status
+#define IIC_idle             0        // not submitted yet
+#define IIC_queued           1
+#define IIC_busy             2        // on the bus
+#define IIC_done             3
+#define IIC_nack             4        // address or data byte not acknowledged
+#define IIC_timeout          5        // clock low or TA1 timeout, the eUSCI_B0 was reset
+
+#define IIC_pending(x)       (((x)->Status == IIC_queued) || ((x)->Status == IIC_busy))
 
+typedef struct IIC_Xfer IIC_Xfer;
+struct IIC_Xfer
+{
+	unsigned char  Address;                   // slave address
+	unsigned char  Read;                      // 1: master receiver
+	unsigned char  Length;                    // bytes, 1..255
+	unsigned char *Data;
+	unsigned char (*Done)(IIC_Xfer *x);       // in the interrupt, NULL: none
+	volatile unsigned char Status;
+};
+
+unsigned char IIC_Submit(IIC_Xfer *x);        // 0: queue full or x still pending
+unsigned char IIC_TX(unsigned char );         // 0: not queued
+unsigned char IIC_RX(unsigned char (*Done)(IIC_Xfer *x));	// the count into Master_RXData, 0: not queued
+#else
 void IIC_TX(unsigned char );
 void IIC_RX(void);
+#endif
 void Set_IIC(void);
 void Set_IIC_Timeout(void);
 
 
-volatile unsigned char Master_RXData[5];
+volatile unsigned char Master_RXData[IIC_count_bytes];
 
 // void Setup_IIC_Slave(void);
 
@@ -1,4 +1,5 @@
 #include "msp430fr6989.h"
+#include "LCD.h"
 
 #define LCD_USE_CHARGE_PUMP
 
@@ -28,6 +29,30 @@ const unsigned char lcd_small_num[10] = {
 	0x6F,		// 9
 };
 
+// Digit positions of the glass, most significant first
+#define LCD_positions	9
+#define LCD_upper		4			// Lcd_mem[0..3] upper line, small digits
+
+static volatile unsigned char *const Lcd_mem[LCD_positions] =
+{
+	&LCDM19, &LCDM18, &LCDM17, &LCDM16,				// upper line, thousands to units
+	&LCDM3, &LCDM5, &LCDM7, &LCDM9, &LCDM11,		// lower line, ten-thousands to units
+};
+
+static const unsigned char *const Lcd_seg[LCD_positions] =		// segment table of every position
+{
+	lcd_small_num, lcd_small_num, lcd_small_num, lcd_small_num,
+	lcd_num, lcd_num, lcd_num, lcd_num, lcd_num,
+};
+
+// Lines of lcd_display_num(): units position, digits
+static const unsigned char  Lcd_units[3] = { LCD_positions - 1, LCD_upper - 1, LCD_positions - 1 };
+static const unsigned long  Lcd_digits[3] = { 0x000FFFFF, 0x0000FFFF, 0xFFFFFFFF };
+
+static unsigned long Lcd_num[3];					// number shown on every line
+static unsigned long Lcd_bcd[3];					// its digits on the glass
+static unsigned char Lcd_valid;						// BITx: line x shows Lcd_num[x]
+
 void init_LCD(void)
 {
 	// LCD_C
@@ -47,84 +72,62 @@ void init_LCD(void)
 	LCDCVCTL	= LCDREXT + R03EXT +LCDEXTBIAS;						// Use resistor
 #endif
 	LCDCMEMCTL	= LCDCLRM;											// Clear LCD memory
+	Lcd_valid	= 0;
 	LCDCCTL0	= LCDDIV_3 + LCDPRE_5 + LCD4MUX + LCDLP  + LCDON;	// 4 MUX, Low power waveform, use ACLK, turn on LCD
 }
 
-void lcd_display_num(unsigned int num, unsigned char small)
+// Binary to BCD by double dabble on the decimal adder (DADD): the same 32 steps
+// for every number, no division. Doubling leaves an even units digit, which
+// takes the next bit. The last eight decimal digits.
+static unsigned long BCD_convert(unsigned long num)
 {
-	unsigned char ten_thousand = 0, thousand = 0, hundred = 0, ten = 0;
-	const unsigned char *disp_num;
-	volatile unsigned char
-		*disp_mem_ten_thousand,
-		*disp_mem_thousand,
-		*disp_mem_hundred,
-		*disp_mem_ten,
-		*disp_mem_num;
-
-	// define display memory for displaying digits on different locations
-	if (small)				// Small size on upper line
-	{
-		disp_num			= lcd_small_num;
-		disp_mem_thousand	= &LCDM19;
-		disp_mem_hundred	= &LCDM18;
-		disp_mem_ten		= &LCDM17;
-		disp_mem_num		= &LCDM16;
-	}
-	else					// Large size on lower line
-	{
-		disp_num				= lcd_num;
-		disp_mem_ten_thousand	= &LCDM3;
-		disp_mem_thousand		= &LCDM5;
-		disp_mem_hundred		= &LCDM7;
-		disp_mem_ten			= &LCDM9;
-		disp_mem_num			= &LCDM11;
-	}
+	unsigned long bcd = 0;
+	unsigned char i;
 
-	while (num >= 10000)
-	{
-		num -= 10000;
-		ten_thousand++;
-	}
-	
-	while (num >= 1000)
+	for (i = 0; i < 8; i++)							// 4 bits per pass
 	{
-		num -= 1000;
-		thousand++;
+		bcd = __bcd_add_long(bcd, bcd) | ((num >> 31) & 1);
+		bcd = __bcd_add_long(bcd, bcd) | ((num >> 30) & 1);
+		bcd = __bcd_add_long(bcd, bcd) | ((num >> 29) & 1);
+		bcd = __bcd_add_long(bcd, bcd) | ((num >> 28) & 1);
+		num <<= 4;
 	}
-	while (num >= 100)
+	return bcd;
+}
+
+// Display the last digits of num on a line, leading zeros blank. Only the
+// digits from the units up to the highest changed one are written, and nothing
+// if the line shows num already: it is called from ISR_ESCAN_IF on every Q6
+// event, mostly with the same number.
+void lcd_display_num(unsigned long num, unsigned char line)
+{
+	unsigned long bcd, changed;
+	unsigned char i;
+
+	if (Lcd_valid & (1 << line))
 	{
-		num -= 100;
-		hundred++;
+		if (Lcd_num[line] == num)
+			return;
+		bcd = BCD_convert(num) & Lcd_digits[line];
+		changed = bcd ^ Lcd_bcd[line];
 	}
-	while (num >= 10)
+	else
 	{
-		num -= 10;
-		ten++;
+		bcd = BCD_convert(num) & Lcd_digits[line];
+		changed = Lcd_digits[line];					// all digits
+		if (line == LCD_total)
+			*Lcd_mem[0] = 0x00;						// no ninth digit
 	}
+	Lcd_num[line] = num;
+	Lcd_bcd[line] = bcd;
+	Lcd_valid = (line == LCD_total) ? BIT2 : (Lcd_valid & ~BIT2) | (1 << line);	// the total shares both lines
 
-	*disp_mem_num = disp_num[num];
-
-
-	if (ten || hundred || thousand || ten_thousand)
-		*disp_mem_ten = disp_num[ten];
-	else
-		*disp_mem_ten = 0x00;
-
-	if (hundred || thousand || ten_thousand)
-		*disp_mem_hundred = disp_num[hundred];
-	else
-		*disp_mem_hundred = 0x00;
-
-	if (thousand || ten_thousand)
-		*disp_mem_thousand = disp_num[thousand];
-	else
-		*disp_mem_thousand = 0x00;
-
-	if (!small)
+	i = Lcd_units[line];
+	*Lcd_mem[i] = Lcd_seg[i][bcd & 0x0F];
+	while (changed >>= 4)
 	{
-		if (ten_thousand)
-			*disp_mem_ten_thousand = disp_num[ten_thousand];
-		else
-			*disp_mem_ten_thousand = 0x00;
+		bcd >>= 4;
+		i--;
+		*Lcd_mem[i] = bcd ? Lcd_seg[i][bcd & 0x0F] : 0x00;		// blank if it and all digits in front of it are 0
 	}
 }
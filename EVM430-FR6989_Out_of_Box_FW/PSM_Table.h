@@ -0,0 +1,44 @@
+/*
+ * PSM_Table.h
+ *
+ * PSM state table, generated by psmgen from ESI_HOST_SIM/psm/2LC.psm. Do not edit,
+ * change the description and run make psm in ESI_HOST_SIM.
+ *
+ *   sensors 2, sequence 00 01 11 10
+ *   up forward, q6 forward, error cnt2, invalid q7
+ */
+
+ const unsigned char Table[] = {
+		0x10,		// start -> 00
+		0x11,		// start -> 01
+		0x18,		// start -> 10
+		0x19,		// start -> 11
+		0x10,		// -- -> 00, not reached
+		0x11,		// -- -> 01, not reached
+		0x18,		// -- -> 10, not reached
+		0x19,		// -- -> 11, not reached
+		0x10,		// -- -> 00, not reached
+		0x11,		// -- -> 01, not reached
+		0x18,		// -- -> 10, not reached
+		0x19,		// -- -> 11, not reached
+		0x10,		// -- -> 00, not reached
+		0x11,		// -- -> 01, not reached
+		0x18,		// -- -> 10, not reached
+		0x19,		// -- -> 11, not reached
+		0x10,		// 00 -> 00
+		0x53,		// 00 -> 01 up Q6
+		0x1C,		// 00 -> 10 down
+		0x1F,		// 00 -> 11 jump ESICNT2
+		0x14,		// 01 -> 00 down
+		0x11,		// 01 -> 01
+		0x1E,		// 01 -> 10 jump ESICNT2
+		0x5B,		// 01 -> 11 up Q6
+		0x52,		// 10 -> 00 up Q6
+		0x17,		// 10 -> 01 jump ESICNT2
+		0x18,		// 10 -> 10
+		0x1D,		// 10 -> 11 down
+		0x16,		// 11 -> 00 jump ESICNT2
+		0x15,		// 11 -> 01 down
+		0x5A,		// 11 -> 10 up Q6
+		0x19 		// 11 -> 11
+ };
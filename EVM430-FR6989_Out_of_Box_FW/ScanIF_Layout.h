@@ -0,0 +1,90 @@
+/*
+ * ScanIF_Layout.h
+ *
+ * Meter layout of the ScanIF engine: 2 LC sensors, INV comparators.
+ * Included by ScanIF.c only, which all meter projects share from ESI_SCANIF.
+ *
+ */
+
+#ifndef SCANIF_LAYOUT_H_
+#define SCANIF_LAYOUT_H_
+
+#define ESI_channels       2          // LC sensors on ESICH0.., 1 to 4
+#define ESI_inverted       1          // ESICA1INV/ESICA2INV: ESIOUTx is 1 below the DAC level
+#define Noise_common       1          // one Noise_level for all channels, the largest
+
+#define ESI_CTL_select     (ESIS3SEL2 + ESIS2SEL0)      // PPUS1..3 sources: ESIOUT0, ESIOUT1, ESIOUT4
+#define ESI_PSM_select     ESIV2SEL                     // Q0 of the PSM as V2 in normal operation
+#define TSM_rate_cal       ESIDIV3A_3                   // 2340 Hz, ACLK/14, calibration and ReCalScanIF()
+#define TSM_rate_run       (ESIDIV3A_5 + ESIDIV3B_1)    // 496 Hz, ACLK/66, normal operation
+#define Cal_rotor_command  0x2A                         // IIC_TX() to the motor board before Set_DAC(), 0: none
+
+// TSM state list, loaded by InitScanIF()
+#define TSM_states         24         // ESITSM0..23
+
+const unsigned int TSM_list[TSM_states] =
+{
+	0x0400,		// DAC=off, CA=off,  1xACLK for ACLK sync
+	0x202C,		// DAC=off, CA=off,  5xESICLK, excitation  			    CH.0
+	0x0404,		// DAC=off, CA=off,  1xACLK                				CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0x0024,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.0
+	0xF134,		// DAC=on,  CA=on,   31xESIFCLK, 		          			CH.0
+	0x5974,		// DAC=on,  CA=on,   OUTPUT LATCHES ENABLED,  12xESICLK 	CH.0
+	0x0400,		// DAC=off, CA=off,  1xACLCK, Internally damped          	CH.0
+	0x0400,		// DAC=off, CA=off,  1xACLCK, Internally damped          	CH.0
+	0x20AD,		// DAC=off, CA=off,  5xESICLK, excitation  			    CH.1
+	0x0485,		// DAC=off, CA=off,  1xACLK                				CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0x00A5,		// DAC=off, CA=off,  1xESIFCLK  , delay tunable  			CH.1
+	0xF1B5,		// DAC=on,  CA=on,   31xESIFCLK			         		CH.1
+	0x59F5,		// DAC=on,  CA=on,   OUTPUT LATCHES ENABLED,  12xESICLK 	CH.1
+	0x0200,		// stop
+};
+
+// Tunable delay chains, tuned by TSM_Auto_cal()
+#define cycle_width        8          // which is equal to (ESICLK / freq of LC) - 2
+#define Delay_taps         6          // ESITSM3..8, ESITSM15..20
+
+const unsigned char Delay_first[ESI_channels] = {3, 15};	// first state of the delay chain of every channel
+const unsigned char Delay_aclk[ESI_channels]  = {2, 14};	// 1xACLK state in front of it
+
+// Sensor states (ESIPPU & State_mask): in every state one channel is at its Max or Min level
+#define State_mask         0x0003
+#define No_channel         0xFF       // a state the disc does not show
+#define Tot_states         4          // sensor state changes per rotation
+
+const unsigned char State_channel[State_mask+1] = {0, 1, 1, 0};	// channel at its Max or Min level per sensor state
+const unsigned char Max_state[ESI_channels] = {3, 2};
+const unsigned char Min_state[ESI_channels] = {0, 1};
+
+// ReCalScanIF(): 4 rotations for a re-calibration, 8 for the initialization
+#define ReCal_loops_max    40         // TSM sequences before the burst gives up
+#define ReCal_Q6_gate      1          // 1: the Q6 interrupt is enabled only for the wait between two readings
+#define ReCal_timer_hold   0          // 1: no TA0 interrupt from a reading to the next
+
+#if Rate_governor
+#define Rate_start         2          // 496 Hz, TSM_rate_run
+#define Rate_margin_down   10         // 2.5, 496 Hz gives 2.75 sequences per state at 45 rps
+
+const unsigned int Rate_divider[Rate_levels] =			// ESIDIV3A, ESIDIV3B of every rate, fastest first
+{
+	ESIDIV3A_3,												// 2340 Hz, ACLK/14
+	ESIDIV3A_7,												// 1092 Hz, ACLK/30
+	ESIDIV3A_5 + ESIDIV3B_1,								// 496 Hz, ACLK/66
+	ESIDIV3A_5 + ESIDIV3B_2,								// 298 Hz, ACLK/110
+	ESIDIV3A_7 + ESIDIV3B_3,								// 156 Hz, ACLK/210
+	ESIDIV3A_7 + ESIDIV3B_7,								// 73 Hz, ACLK/450
+};
+const unsigned int Rate_period[Rate_levels] = {14, 30, 66, 110, 210, 450};	// ACLK cycles between two TSM sequences
+#endif
+
+#endif /* SCANIF_LAYOUT_H_ */
@@ -0,0 +1,156 @@
+/*
+ * Task.c
+ *
+ * Event scheduler of the main loop. Task_In is written by the interrupts only,
+ * Task_Full by the interrupts and cleared by the main loop with the interrupts
+ * off, Task_Out and everything else by the main loop only. Task_Run() moves the
+ * posted events into Task_Pending before every task: a task posted again
+ * before it has run runs once, its wait counts from the first post.
+ *
+ */
+
+#include "msp430fr6989.h"
+#include "Task.h"
+
+#if Task_scheduler
+typedef struct
+{
+	unsigned char Task;
+	unsigned int  Stamp;							// TA2R at the post
+} Task_Event;
+
+Task_Event Task_Ring[Task_ring_size];
+volatile unsigned char Task_In = 0;					// next free entry, interrupts
+volatile unsigned char Task_Out = 0;				// oldest event, main loop
+unsigned char Task_Lost = 0;						// events posted to a full ring
+volatile unsigned char Task_Full = 0;				// BITn: task n was posted to a full ring, interrupts
+volatile unsigned char Task_Sleeping = 0;			// the main loop sleeps in Task_Run()
+unsigned char Task_Pending = 0;						// BITn: task n is to run
+unsigned int  Task_Posted[Task_num];				// TA2R at the first post of a pending task
+unsigned int  Task_Wait[Task_num];					// longest wait from the post to the run, ACLK cycles
+unsigned int  Task_Late[Task_num];					// runs that started after the deadline
+unsigned int  Task_Runs[Task_num];
+
+static const unsigned char Task_First[1 << Task_num] =	// lowest set bit of Task_Pending
+{
+	0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+	4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+};
+
+
+static unsigned int Task_Stamp(void)
+{
+	unsigned int Stamp;
+
+	do { Stamp = TA2R; } while (Stamp != TA2R);		// TA2 runs on ACLK, read until two reads agree
+	return Stamp;
+}
+
+
+void Task_Init(void)
+{
+	unsigned char i;
+
+	if (!(TA2CTL & MC_3))
+		TA2CTL = TASSEL0 + MC1 + TACLR;				// ACLK, continuous mode: the stamps, unless Flow_Init() or Trace_Init() runs it
+	for (i=0; i<Task_num; i++)
+	{
+		Task_Wait[i] = 0;
+		Task_Late[i] = 0;
+		Task_Runs[i] = 0;
+	}
+	Task_Pending = 0;
+	Task_Lost = 0;
+	Task_Full = 0;
+	Task_Out = Task_In;
+}
+
+
+unsigned char Task_Post(unsigned char Task)			// in an interrupt
+{
+	unsigned char In = Task_In;
+	unsigned char Next = (In + 1) & (Task_ring_size - 1);
+
+	if (Next == Task_Out)
+	{
+		Task_Lost++;
+		Task_Full |= 1 << Task;						// no stamp, but the task runs
+	}
+	else
+	{
+		Task_Ring[In].Task = Task;
+		Task_Ring[In].Stamp = TA2R;					// one read: a stamp taken as TA2R counts only spoils the statistics
+		Task_In = Next;
+	}
+	return Task_Sleeping;
+}
+
+
+unsigned int Task_Idle(void)
+{
+	if ((ESICTL & ESIEN) | (LCDCCTL0 & LCDON) | ((TA0CTL | TA1CTL | TA2CTL | TA3CTL) & MC_3)
+	    | (ADC12CTL0 & ADC12ON))						// one test, no branch per clock user
+		return LPM3_bits;							// ACLK users: the ESI, the LCD and the timers; MODOSC of the ADC12
+	return LPM4_bits;
+}
+
+
+void Task_Run(void)
+{
+	unsigned char Out, Full, i;
+	unsigned int Wait;
+
+	__disable_interrupt();							// an event of an interrupt from here on wakes the LPM
+	if ((Task_Out == Task_In) && !Task_Full)
+	{
+		Task_Sleeping = 1;
+		__bis_SR_register(Task_Idle() | GIE);
+		Task_Sleeping = 0;
+	}
+	__enable_interrupt();
+
+	for (Out = Task_Out; ; Out = Task_Out)
+	{
+		while (Out != Task_In)
+		{
+			i = Task_Ring[Out].Task;
+			if (!(Task_Pending & (1 << i)))
+			{
+				Task_Pending |= 1 << i;
+				Task_Posted[i] = Task_Ring[Out].Stamp;
+			}
+			Out = (Out + 1) & (Task_ring_size - 1);
+		}
+		Task_Out = Out;
+		if (Task_Full)
+		{
+			__disable_interrupt();
+			Full = Task_Full;
+			Task_Full = 0;
+			__enable_interrupt();
+			for (i=0; i<Task_num; i++)
+				if ((Full & (1 << i)) && !(Task_Pending & (1 << i)))
+				{
+					Task_Pending |= 1 << i;
+					Task_Posted[i] = Task_Stamp();	// the post itself has no stamp
+				}
+		}
+		if (!Task_Pending)
+			return;
+
+		i = Task_First[Task_Pending];				// the highest priority
+		Task_Pending &= ~(1 << i);
+		Wait = (Task_Stamp() - Task_Posted[i]) & 0xFFFF;	// int is 32 bits on the host
+		if (Wait > Task_Wait[i]) Task_Wait[i] = Wait;
+		if (Wait > Task_List[i].Deadline) Task_Late[i]++;
+		Task_Runs[i]++;
+		Task_List[i].Run();
+	}
+}
+#endif
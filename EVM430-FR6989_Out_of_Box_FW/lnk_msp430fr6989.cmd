@@ -136,6 +136,7 @@ SECTIONS
        {
           .cio        : {}                   /* C I/O BUFFER                      */
           .sysmem     : {}                   /* DYNAMIC MEMORY ALLOCATION AREA    */
+          .TI.persistent : {}                /* PERSISTENT VARIABLES              */
        } ALIGN(0x0400), RUN_START(fram_rw_start)
 
        GROUP(READ_ONLY_MEMORY)
@@ -28,16 +28,31 @@
 #include "ScanIF.h"
 #include "ESI_ESIOSC.h"
 #include "IIC.h"
+#include "Task.h"
+#include "Trace.h"
 
 #define Time_out  8192      					// 2 sec for time out of Recalibration
 #define Time_to_Recal 8192  					// 2 sec for testing use, 40960 for 10 sec
+#define Demo_states   ((1000+1)*4)			// ESICNT1 distance of more than 1000 rotations, Tot_states of ScanIF_Layout.h
 
 extern 	unsigned char  Status_flag ;
+#if Drift_tracker
+extern 	unsigned char  Drift_probe ;
+#endif
 char Power_measure = 0;
 signed int  test_status = 0;
 unsigned char ReCal_Flag ;
 
 int  rotation_counter = 0;
+#if Display_task
+#if !Task_scheduler
+unsigned char Display_due;						// the display task is to draw the counts
+#endif
+unsigned int  Display_count;					// ESICNT1 at the last refresh
+#endif
+#if (Flow_meter || Skip_detect) && !Task_scheduler
+unsigned char Save_due;							// Info_Save() is to write the counts of the ISRs
+#endif
 
 unsigned int Record_INT1=0;
 unsigned int Record_INT2=0;
@@ -51,6 +66,50 @@ void Set_Timer_A(void);
 void Check_debug(void);
 void Disable_all_IE(void);
 void Enable_all_IE(void);
+void Display_Init(void);
+void Display_Update(void);
+void Demo_End(void);
+void Recal_Task(void);
+#if IIC_queue
+unsigned char Motor_Count(IIC_Xfer *x);
+#endif
+
+#if Task_scheduler
+const Task_Entry Task_List[Task_num] =
+{
+	{Demo_End,		 3277},						// Task_demo, 0.1 s: the motor runs on
+#if AFE2_enable && !Drift_tracker
+	{Recal_Task,	 328},						// Task_recal, 10 ms: the burst starts at a Q6 event
+#else
+	{0,				 0},
+#endif
+#if Temp_comp
+	{Temp_Update,	 328},						// Task_temp, 10 ms after the last conversion
+#else
+	{0,				 0},
+#endif
+#if Osc_tracker
+	{Osc_Update,	 32768},					// Task_osc, 1 s: one trim step of Temp_period
+#else
+	{0,				 0},
+#endif
+#if Display_task
+	{Display_Update, 16384},					// Task_display, 0.5 s
+#else
+	{0,				 0},
+#endif
+#if Temp_comp
+	{Temp_Start,	 3277},						// Task_sample, 0.1 s
+#else
+	{0,				 0},
+#endif
+#if Flow_meter || Skip_detect
+	{Info_Save,		 32768},					// Task_save, 1 s: the CRC runs after the other tasks
+#else
+	{0,				 0},
+#endif
+};
+#endif
 
 void Port_Init()
 {
@@ -154,12 +213,114 @@ void Enable_all_IE(void)
 
 }
 
+#if Display_task
+void Display_Init(void)
+{
+/*  TA3 wakes the display task every Display_period,
+ *  with Display_period 0 it is not started: only the P1.2 key draws the counts.
+ */
+
+	Display_count = ESICNT1;
+	TA3CTL = TASSEL0 + ID0 + ID1 + TACLR; 		//Aclk divided by 8;
+	TA3CCR0 = Display_period - 1;
+	TA3CCTL0 = CCIE;
+	if (Display_period) TA3CTL |= MC0;
+}
+#endif
+
+
+void Display_Update(void)						// the display task, in the main loop
+{
+#if Display_task
+#if !Task_scheduler
+	Display_due = 0;
+#endif
+	Display_count = ESICNT1;
+#endif
+	if (!(LCDCCTL0&LCDON))
+		return;
+
+#if IIC_queue
+	IIC_RX(Motor_Count);						// the upper digits are drawn when the motor board has answered
+#else
+	IIC_RX();									// to get the number of rotation detected by motor board
+	rotation_counter = Master_RXData[1];
+	rotation_counter <<= 8;
+	rotation_counter += Master_RXData[0];
+	lcd_display_num(rotation_counter,1);		// to display the data from motor board in the upper digits of LCD
+#endif
+
+#if Totalizer
+	rotation_counter = Tot_Rotations();			// forward minus reverse rotations of the totalizer
+#else
+	rotation_counter = ESICNT1;					// get the ESI counter for number of rotation
+		if (rotation_counter < 0)
+		{rotation_counter = -1*rotation_counter /4;}	// divided by 4 as the counter is increased by 1 for every state change of 2 LC sensor.
+		else
+		{rotation_counter = rotation_counter / 4;}
+#endif
+	lcd_display_num(rotation_counter,0);		// to display the number of rotation from ESI in low digits of LCD
+}
+
+#if IIC_queue
+unsigned char Motor_Count(IIC_Xfer *x)			// Done() of IIC_RX(), in USCI_B0_ISR
+{
+	unsigned long Count = 0;
+	unsigned char i;
+
+	if (x->Status != IIC_done)					// no motor board: the upper digits stay
+		return 0;
+	for (i = IIC_count_size; i > 0; i--)		// low byte first
+		Count = (Count << 8) + Master_RXData[i - 1];
+	lcd_display_num(Count,1);					// to display the data from motor board in the upper digits of LCD
+	return 0;									// stay in LPM3
+}
+#endif
+
+
+void Demo_End(void)								// more than 1000 rotations, the ESI interrupt has disabled Q6
+{
+	if (LCDCCTL0&LCDON) IIC_TX(0x20);			// send command to stop the rotor
+	__delay_cycles(8000000);
+	Display_Update();							// User can then check the counting from ESI and Motor and see if they match.
+	__delay_cycles(8000000);
+	test_status |= BIT0;						// indication of completion of 1000 rotations
+}
+
+#if AFE2_enable && !Drift_tracker
+void Recal_Task(void)							// the Q6 interrupt has set BIT6 of ReCal_Flag
+{
+	ReCal_Flag &= ~BIT7;                  		// Reset Bit7 for timer call
+
+	TA0CCR0 = Time_out;                   		// set the time out timer. it will generate a time out interrupt when it stop rotating
+	TA0CTL |= MC0;
+	ESIINT1 &= ~ESIIE5;
+
+	ReCalScanIF();           					// to do runtime calibration with AFE2
+
+	TA0CTL &= ~MC0;
+	TA0CTL |= TACLR;                      		// Reset Timer
+	TA0CCR0 = Time_to_Recal;              		// Set the timer back for Re-calibration counting
+	TA0CTL |= MC0;								// timer re-start for ReCal.
+
+	ReCal_Flag = 0;								// ReCal of AFE1 is done, reset all flags.
+
+	__bic_SR_register(GIE);						// Ensure no abnormal interrupt before entering LPM;
+	ESIINT2 &= ~ESIIFG5;                  		// clear the Q6 flag
+	ESIINT1 |= ESIIE5;							// Enable Q6 INT for in case of Time out.
+}
+#endif
+
+
 void main(void)
 {
 	WDTCTL = WDTPW + WDTHOLD;					// disable Watchdog
 
 	Port_Init();
 	Set_Clock();
+#if Isr_trace
+	Trace_Init();								// entry and exit of the ISRs into Trace_Log, from the calibration on
+#endif
 
 	P1IES |= BIT2;								// Set P1.2 as key input
 	P1IFG &= ~BIT2;								// User can press the black button to toggle switch on/off the LCD
@@ -189,9 +350,32 @@ void main(void)
 //	Enable_all_IE();
 
 
-#if AFE2_enable
+#if Drift_tracker
+	 Drift_Init();								// AFE2 drift tracker on the Q6 interrupt, no ReCalScanIF() burst
+#if Temp_comp
+	 Temp_Init();
+#if Osc_tracker
+	 Osc_Init();
+#endif
+#if Rate_governor
+	 Rate_Init();
+#endif
+	 Set_Timer_A();
+	 TA0CCR0 = Temp_period;						// temperature readings for the drift tracker
+	 TA0CTL |= MC0;
+#endif
+#elif AFE2_enable
 	 Set_Timer_A();                				// set and start timer for triggering run-time re-calibration
 #endif
+#if Flow_meter
+	 Flow_Init();								// TA2 time base of the flow rate
+#endif
+#if Display_task
+	 Display_Init();							// LCD refresh out of the ESI interrupt
+#endif
+#if Task_scheduler
+	 Task_Init();								// the events of the interrupts run the tasks below
+#endif
 
 
 while(1)	                					// Infinite loop for demonstration purpose
@@ -210,10 +394,18 @@ while(1)	                					// Infinite loop for demonstration purpose
  	 ESIINT1 &= ~ESIIE5;
  	 ESICTL  |= ESIEN;            				// ESI enable. This will reset all counters of ESI. For actual operation of flowmeter, switch on ESI and will always on till battery drain off
  	 ESIINT2 &= ~ESIIFG5;                   	// clear INT flag of Q6 of PSM
+#if Totalizer
+	 Tot_Init();								// totals of this demonstration cycle
+#endif
+#if Skip_detect
+	 Skip_Init();								// a TSM rate too slow for the flow
+#endif
 
+#if !Drift_tracker
 	 TA0CTL &= ~MC0;							// Reset Timer for runtime Re-calibration
 	 TA0CTL |= TACLR;
 	 TA0CTL |= MC0;
+#endif
 	 ReCal_Flag = 0;
 
 	 IIC_TX(0x2F); 					        	// start motor clockwise rotation at 45 to 50 turns per second
@@ -230,36 +422,46 @@ while(1)	                					// Infinite loop for demonstration purpose
 		break;									// and repeat it infinitely
 		}
 
+#if Task_scheduler
+		Task_Run();								// one task, or the deepest LPM until an interrupt posts one
+#else
 	    __bis_SR_register(LPM3_bits | GIE);   	// Enter into LPM3 and enable interrupts
 	                                            // keep in LPM3 until there is a rotation to trigger ESI Q6 interrupt
 
-
-#if AFE2_enable
-
-	if(ReCal_Flag&BIT6)							// Check if Re-calibration flag is set
+#if Temp_comp
+	if (ReCal_Flag&BIT4)						// temperature reading is due
 	{
-	  ReCal_Flag &= ~BIT7;                  	// Reset Bit7 for timer call
-
-	  TA0CCR0 = Time_out;                   	// set the time out timer. it will generate a time out interrupt when it stop rotating
-	  TA0CTL |= MC0;
-	  ESIINT1 &= ~ESIIE5;
-
-	  ReCalScanIF();           					// to do runtime calibration with AFE2
-
-	  TA0CTL &= ~MC0;
-	  TA0CTL |= TACLR;                      	// Reset Timer
-	  TA0CCR0 = Time_to_Recal;              	// Set the timer back for Re-calibration counting
-	  TA0CTL |= MC0;							// timer re-start for ReCal.
-
-	  ReCal_Flag = 0;							// ReCal of AFE1 is done, reset all flags.
+	  ReCal_Flag &= ~BIT4;
+	  Temp_Update();
+#if Osc_tracker
+	  Osc_Update();								// ESIOSC drift, one EsioscReCal() step per wake
+#endif
+	}
+#endif
 
-	  __bic_SR_register(GIE);					// Ensure no abnormal interrupt before entering LPM;
-	  ESIINT2 &= ~ESIIFG5;                  	// clear the Q6 flag
-	  ESIINT1 |= ESIIE5;						// Enable Q6 INT for in case of Time out.
+	if (test_status&BIT1)						// more than 1000 rotations, the ESI interrupt has disabled Q6
+	{
+	  test_status &= ~BIT1;
+	  Demo_End();
 	}
+#if Display_task
+	else if (Display_due)
+	  Display_Update();							// the count has moved, or the LCD was switched on
 #endif
 
+#if Flow_meter || Skip_detect
+	if (Save_due)								// the TA2 overflow or a jump found new counts
+	{
+	  Save_due = 0;
+	  Info_Save();
+	}
+#endif
 
+#if AFE2_enable && !Drift_tracker
+	if(ReCal_Flag&BIT6)							// Check if Re-calibration flag is set
+	  Recal_Task();
+#endif
+#endif
 	}
 }
 
@@ -270,12 +472,24 @@ while(1)	                					// Infinite loop for demonstration purpose
 #pragma vector=ESCAN_IF_VECTOR
 __interrupt void ISR_ESCAN_IF(void)
 {
+#if Display_task
+   unsigned int Count;
+#endif
+
+#if Isr_trace
+   Trace_In(Trace_late_none);
+#endif
    TA0CCTL0 &= ~CCIE;
 
    switch (ESIIV)
    {
    case 0x02:  if (ESIINT1&ESIIE1)
 				{ESIINT2 &= ~ESIIFG1;                 								// clear the ESISTOP flag
+#if Drift_tracker
+				 if (Drift_probe)
+					{Drift_Probe_End();												// AFE2 result of the drift probe, stay in LPM3
+					 break;}
+#endif
    	   	   	   	   if(ReCal_Flag&BIT6)
 					{TA0CTL |= TACLR;                   							// Reset Timer to prevent abnormal time out.
 					TA0CCTL0 &= ~CCIFG;	}
@@ -287,7 +501,11 @@ __interrupt void ISR_ESCAN_IF(void)
 
    case 0x04:  break;
    case 0x06:  break;
-   case 0x08:  break;
+   case 0x08:
+#if Totalizer
+			   Tot_Threshold();													// ESICNT1 reached ESITHR1 or ESITHR2, stay in LPM3
+#endif
+			   break;
 
    case 0x0A: break;
    case 0x0C: if(ESIINT1&ESIIE5)
@@ -298,20 +516,52 @@ __interrupt void ISR_ESCAN_IF(void)
 						TA0CCTL0 &= ~CCIFG;	}
 
 						if(ReCal_Flag&BIT7)
-						{ ReCal_Flag |= BIT6;	}           						// to do runtime calibration with AFE2
+						{
+#if Task_scheduler && AFE2_enable && !Drift_tracker
+						  if (!(ReCal_Flag&BIT6)) Task_Post(Task_recal);			// the exit below leaves the LPM
+#endif
+						  ReCal_Flag |= BIT6;	}           						// to do runtime calibration with AFE2
 
 						if(Status_flag&BIT2)                						// Check for completion of Calibration of DAC
 							{							    						// If yes, LCD is to display the rotation number
+#if Drift_tracker
+							Drift_Probe_Start();									// AFE2 drift probe on the next TSM sequence
+#endif
+#if Rate_governor
+							Rate_Q6();												// TSM rate for the measured state interval
+#endif
+#if Flow_meter
+							Flow_Q6();												// period of the rotation ending at this state
+#endif
+#if Display_task
+							Count = ESICNT1;										// the display task draws the counts
+							if ((Count >= Demo_states) && (Count <= 0x10000 - Demo_states))
+								{													// more than 1000 rotations in either direction:
+								ESIINT1 &= ~ESIIE5;									// the main loop stops the motor
+#if Task_scheduler
+								if (Task_Post(Task_demo))
+#else
+								test_status |= BIT1;
+#endif
+								_low_power_mode_off_on_exit();
+								}
+							}
+#else
 							ESIINT1 &= ~ESIIE5;
 
 							 if(!(ReCal_Flag&BIT6))
 							 	 {
 									if (LCDCCTL0&LCDON)
-									{   IIC_RX();									// to get the number of rotation detected by motor board
+									{
+#if IIC_queue
+										IIC_RX(Motor_Count);						// drawn in USCI_B0_ISR when the motor board has answered
+#else
+										IIC_RX();									// to get the number of rotation detected by motor board
 										rotation_counter = Master_RXData[1];
 										rotation_counter <<= 8;
 										rotation_counter += Master_RXData[0];
 										lcd_display_num(rotation_counter,1);        // to display the data from motor board in the upper digits of LCD
+#endif
 									}
 							 	 }
 
@@ -319,11 +569,15 @@ __interrupt void ISR_ESCAN_IF(void)
 							ESIINT1 |= ESIIE5;
 
 
+#if Totalizer
+						rotation_counter = Tot_Rotations();							// forward minus reverse rotations of the totalizer
+#else
 						rotation_counter = ESICNT1;									// get the ESI counter for number of rotation
 							if (rotation_counter < 0)
 							{rotation_counter = -1*rotation_counter /4;}			// divided by 4 as the counter is increased by 1 for every state change of 2 LC sensor.
 							else													// which is set by PSM table
 							{rotation_counter = rotation_counter / 4;}
+#endif
 
 						lcd_display_num(rotation_counter,0);						// to display the number of rotation from ESI in low digits of LCD
 
@@ -332,48 +586,52 @@ __interrupt void ISR_ESCAN_IF(void)
 							if (rotation_counter > 1000)							// when number of rotation reaches 1000, it stop the motor
 								{													// User can then check the counting from ESI and Motor and see if they match.
 																					// There has a +/- 1 difference as the detector in motor board is not in the same physical position as that of LC sensors
-								    ESIINT1 &= ~ESIIE5;
-								    if (LCDCCTL0&LCDON) IIC_TX(0x20);				// send command to stop the rotor
-
-									 __delay_cycles(8000000);
-
-									 if (LCDCCTL0&LCDON)
-										 {
-										 	IIC_RX();
-											rotation_counter = Master_RXData[1];
-											rotation_counter <<= 8;
-											rotation_counter += Master_RXData[0];
-											lcd_display_num(rotation_counter,1);   	// to display the data from motor board in the upper digits of LCD
-										 }
-
-									rotation_counter = ESICNT1;
-										if (rotation_counter < 0)
-										{rotation_counter = -1*rotation_counter /4;}
-										else
-										{rotation_counter = rotation_counter / 4;}
-
-									lcd_display_num(rotation_counter,0);    		// to display the number of rotation from ESI in low digits of LCD
-
-										 __delay_cycles(8000000);
-
-									 test_status |= BIT0;							// indication of completion of 1000 rotations
-
+								    ESIINT1 &= ~ESIIE5;								// Demo_End() in the main loop: the queued I2C runs only after this ISR
+#if Task_scheduler
+								    Task_Post(Task_demo);							// the exit below leaves the LPM
+#else
+								    test_status |= BIT1;
+#endif
 								}
 
 							}
+#endif
 
 						TA0CCTL0 |= CCIE;
+#if Display_task && Drift_tracker
+						if (!(Status_flag&BIT2))						// InitScanIF() waits for the Q6 events, the normal operation not
+#elif Task_scheduler && Display_task
+						if (!Task_Sleeping || (ReCal_Flag&BIT6))		// InitScanIF() or a task waits for the Q6 events, or the ReCalScanIF() burst is due
+#endif
 						_low_power_mode_off_on_exit();       						// exit low power mode;
    	   	   	   	   }
 
 	          break;
-   case 0x0E: break;
-   case 0x10: break;
+   case 0x0E:
+#if Skip_detect
+			   if (Skip_Event())													// ESICNT2 counted a jump over a sensor state
+			   {
+#if Task_scheduler
+				   if (Task_Post(Task_save))
+#else
+				   Save_due = 1;
+#endif
+				   _low_power_mode_off_on_exit();
+			   }
+#endif
+			   break;
+   case 0x10:
+#if Totalizer
+			   Tot_Wrap();														// ESICNT0 wrapped to zero, stay in LPM3
+#endif
+			   break;
    case 0x12: break;
    }
 
    TA0CCTL0 |= CCIE;
-
+#if Isr_trace
+   Trace_Out(Trace_esi);
+#endif
 }
 
 
@@ -381,6 +639,20 @@ __interrupt void ISR_ESCAN_IF(void)
 #pragma vector = TIMER0_A0_VECTOR
 __interrupt void Timer_A (void)
 {
+#if Isr_trace
+	Trace_In((TA0R == TA0CCR0) ? 0 : (TA0R + 1) << 3);								// ACLK/8 cycles from the CCR0 match
+#endif
+#if Temp_comp
+#if Rate_governor
+	Rate_Tick();
+#endif
+#if Task_scheduler
+	if (Task_Post(Task_sample))														// temperature reading, the timer keeps running
+#else
+	ReCal_Flag |= BIT4;																// temperature reading, the timer keeps running
+#endif
+	_low_power_mode_off_on_exit();
+#else
     if (ReCal_Flag&BIT6)
     {
     	ReCal_Flag |= BIT1;                           								// Time out
@@ -395,26 +667,109 @@ __interrupt void Timer_A (void)
     }
 
 	TA0CTL &= ~MC0;									 								// disable timer
+#endif
+#if Isr_trace
+	Trace_Out(Trace_ta0);
+#endif
+}
+
+
 
+#if Display_task
+// Timer A3 interrupt service routine, display refresh
+#pragma vector = TIMER3_A0_VECTOR
+__interrupt void Timer3_A (void)
+{
+#if Isr_trace
+	Trace_In((TA3R == TA3CCR0) ? 0 : (TA3R + 1) << 3);								// ACLK/8 cycles from the CCR0 match
+#endif
+	if (ESICNT1 != Display_count)													// the count has moved since the last refresh
+	{
+#if Task_scheduler
+		if (Task_Post(Task_display))
+#else
+		Display_due = 1;
+#endif
+		_low_power_mode_off_on_exit();
+	}
+#if Isr_trace
+	Trace_Out(Trace_ta3);
+#endif
 }
+#endif
 
+#if Task_scheduler && Temp_comp
+// ADC12 interrupt service routine, end of the conversion sequence of the temperature reading
+#pragma vector = ADC12_VECTOR
+__interrupt void ADC12_ISR(void)
+{
+#if Isr_trace
+	Trace_In(Trace_late_none);
+#endif
+	Temp_Sample();
+#if Osc_tracker
+	Task_Post(Task_osc);
+#endif
+	if (Task_Post(Task_temp))
+		_low_power_mode_off_on_exit();
+#if Isr_trace
+	Trace_Out(Trace_adc);
+#endif
+}
+#endif
 
+#if Flow_meter || Isr_trace
+// Timer A2 interrupt service routine, overflow of the flow rate time base and of the trace stamps
+#pragma vector = TIMER2_A1_VECTOR
+__interrupt void Timer2_A (void)
+{
+#if Isr_trace
+	Trace_In(TA2R);																	// ACLK from the overflow
+#endif
+#if Flow_meter
+	if ((TA2IV == TA2IV_TAIFG) && Flow_Overflow())
+	{
+#if Task_scheduler
+		if (Task_Post(Task_save))
+#else
+		Save_due = 1;
+#endif
+		_low_power_mode_off_on_exit();
+	}
+#else
+	TA2CTL &= ~TAIFG;
+#endif
+#if Isr_trace
+	Trace_Out(Trace_ta2);
+#endif
+}
+#endif
 
+#if !IIC_queue
 // Timer A1 interrupt service routine for I2C time out timer
 #pragma vector = TIMER1_A0_VECTOR
 __interrupt void Timer1_A (void)
 {
+#if Isr_trace
+	Trace_In(Trace_late_none);
+#endif
 	TA1CTL &= ~MC_1;
 	Set_IIC();
 	__bic_SR_register_on_exit(LPM0_bits ); 											// Exit LPM0
-
+#if Isr_trace
+	Trace_Out(Trace_ta1);
+#endif
 }
+#endif
 
 
 // Port 1 interrupt service routine for push button of the main board
 #pragma vector=PORT1_VECTOR
 __interrupt void PORT1_ISR(void)
 {
+#if Isr_trace
+    Trace_In(Trace_late_none);
+#endif
     P1IFG &= ~BIT2;
     Power_measure ^= BIT0;
 
@@ -422,13 +777,29 @@ __interrupt void PORT1_ISR(void)
     {LCDCCTL0 &= ~LCDON;
     ESIINT1 &= ~ESIIE5;																// disable INT of Q6
 	TA0CTL &= ~MC0;																	// stop the re-calibartion timer
+#if Display_task
+	TA3CTL &= ~MC0;																	// no display refresh
+#endif
     }
     else
     {LCDCCTL0 |= LCDON;
     ESIINT1 |= ESIIE5;																// enable INT of Q6
 	TA0CTL |= MC0;																	// turn on re-calibration timer
+#if Display_task
+	if (Display_period) TA3CTL |= MC0;
+#if Task_scheduler
+	if (Task_Post(Task_display))													// draw the counts at once
+		_low_power_mode_off_on_exit();
+#else
+	Display_due = 1;																// draw the counts at once
+#endif
+#endif
     }
 
+#if !(Task_scheduler && Display_task)
    _low_power_mode_off_on_exit();
-
+#endif
+#if Isr_trace
+   Trace_Out(Trace_port1);
+#endif
 }